@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// epoch_manager.cpp
+//
+// Identification: src/common/epoch_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/epoch_manager.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <thread>  // NOLINT
+
+namespace bustub {
+
+EpochManager::Guard::~Guard() {
+  if (slot_ == OVERFLOW_SLOT) {
+    std::scoped_lock<std::mutex> lock(manager_->overflow_latch_);
+    manager_->overflow_.erase(overflow_);
+    return;
+  }
+  manager_->slots_[slot_].epoch_.store(INACTIVE);
+}
+
+EpochManager::~EpochManager() {
+  for (auto &retired : retired_) {
+    retired.deleter_(retired.object_);
+  }
+}
+
+auto EpochManager::Pin() -> Guard {
+  // Hashed once per thread, so a thread keeps finding the same, usually free, slot.
+  thread_local const size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+  for (size_t i = 0; i < NUM_SLOTS; i++) {
+    const size_t slot = (start + i) % NUM_SLOTS;
+    uint64_t expected = INACTIVE;
+    // The epoch read here may already be stale, which only makes the reader look older and delays reclamation.
+    if (slots_[slot].epoch_.compare_exchange_strong(expected, global_epoch_.load())) {
+      return Guard(this, slot);
+    }
+  }
+  // Every slot is taken, possibly by guards that live for long. Waiting for one could deadlock against them.
+  std::scoped_lock<std::mutex> lock(overflow_latch_);
+  overflow_.push_back(global_epoch_.load());
+  return Guard(this, std::prev(overflow_.end()));
+}
+
+void EpochManager::Retire(void *object, void (*deleter)(void *)) {
+  std::scoped_lock<std::mutex> lock(retired_latch_);
+  // Readers that pin after this point see the new epoch and cannot reach the object any more.
+  retired_.push_back({global_epoch_.fetch_add(1), object, deleter});
+  Reclaim();
+}
+
+void EpochManager::Reclaim() {
+  uint64_t oldest = std::numeric_limits<uint64_t>::max();
+  for (auto &slot : slots_) {
+    const uint64_t epoch = slot.epoch_.load();
+    if (epoch != INACTIVE) {
+      oldest = std::min(oldest, epoch);
+    }
+  }
+  {
+    // A reader that pins into the overflow list after this reads an epoch from after the retirements so far.
+    std::scoped_lock<std::mutex> lock(overflow_latch_);
+    for (uint64_t epoch : overflow_) {
+      oldest = std::min(oldest, epoch);
+    }
+  }
+  // A reader pinned at epoch e may hold objects retired at e or later, everything retired before it is safe to free.
+  while (!retired_.empty() && retired_.front().epoch_ < oldest) {
+    retired_.front().deleter_(retired_.front().object_);
+    retired_.pop_front();
+  }
+}
+
+}  // namespace bustub
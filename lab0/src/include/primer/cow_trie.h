@@ -0,0 +1,325 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// cow_trie.h
+//
+// Identification: src/include/primer/cow_trie.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "common/epoch_manager.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * CowTrieNode is a node of a CowTrie. Nodes are immutable once they are part of a trie version and shared between
+ * the versions that contain them, so every change builds new nodes along the path of its key.
+ */
+class CowTrieNode {
+ public:
+  /** Children sorted by key char, compared as unsigned char. */
+  using Children = std::vector<std::pair<char, std::shared_ptr<const CowTrieNode>>>;
+
+  explicit CowTrieNode(char key_char) : key_char_(key_char) {}
+
+  CowTrieNode(char key_char, Children children) : key_char_(key_char), children_(std::move(children)) {}
+
+  virtual ~CowTrieNode() = default;
+
+  /** @brief Copy this node, sharing its children and value. The copy is private to the caller until published. */
+  virtual auto Clone() const -> std::unique_ptr<CowTrieNode> { return std::make_unique<CowTrieNode>(*this); }
+
+  auto GetKeyChar() const -> char { return key_char_; }
+
+  auto IsEndNode() const -> bool { return is_end_; }
+
+  auto HasChildren() const -> bool { return !children_.empty(); }
+
+  auto GetChildren() const -> const Children & { return children_; }
+
+  /** @return the child with the given key char, nullptr if there is none */
+  auto GetChildNode(char key_char) const -> const CowTrieNode * {
+    auto it = LowerBound(children_, key_char);
+    return it == children_.end() || it->first != key_char ? nullptr : it->second.get();
+  }
+
+  /** @brief Point key_char at child, replacing the existing child if there is one. Only for unpublished nodes. */
+  void SetChildNode(char key_char, std::shared_ptr<const CowTrieNode> child) {
+    auto it = LowerBound(children_, key_char);
+    if (it != children_.end() && it->first == key_char) {
+      it->second = std::move(child);
+    } else {
+      children_.emplace(it, key_char, std::move(child));
+    }
+  }
+
+  /** @brief Drop the child with the given key char. Only for unpublished nodes. */
+  void RemoveChildNode(char key_char) {
+    auto it = LowerBound(children_, key_char);
+    if (it != children_.end() && it->first == key_char) {
+      children_.erase(it);
+    }
+  }
+
+ protected:
+  static auto LowerBound(const Children &children, char key_char) -> Children::const_iterator {
+    return std::lower_bound(children.begin(), children.end(), key_char, [](const auto &child, char key) {
+      return static_cast<unsigned char>(child.first) < static_cast<unsigned char>(key);
+    });
+  }
+
+  static auto LowerBound(Children &children, char key_char) -> Children::iterator {
+    return std::lower_bound(children.begin(), children.end(), key_char, [](const auto &child, char key) {
+      return static_cast<unsigned char>(child.first) < static_cast<unsigned char>(key);
+    });
+  }
+
+  /** Key character of this node */
+  char key_char_;
+  /** Whether this node marks the end of a key */
+  bool is_end_{false};
+  Children children_;
+};
+
+/**
+ * CowTrieNodeWithValue is a CowTrieNode that ends a key and holds its value. Copies of the node share the value.
+ */
+template <typename T>
+class CowTrieNodeWithValue : public CowTrieNode {
+ public:
+  CowTrieNodeWithValue(char key_char, Children children, std::shared_ptr<const T> value)
+      : CowTrieNode(key_char, std::move(children)), value_(std::move(value)) {
+    is_end_ = true;
+  }
+
+  auto Clone() const -> std::unique_ptr<CowTrieNode> override {
+    return std::make_unique<CowTrieNodeWithValue<T>>(key_char_, children_, value_);
+  }
+
+  /** @return the value, shared by every version of the trie that holds this key with it */
+  auto GetValue() const -> const std::shared_ptr<const T> & { return value_; }
+
+ private:
+  std::shared_ptr<const T> value_;
+};
+
+/**
+ * CowTrie is a persistent, copy-on-write variant of Trie for data that is read far more often than it changes.
+ *
+ * Every version of the trie is immutable. Insert and Remove copy only the nodes on the path of their key, share the
+ * rest with the previous version and publish the new root atomically; writers are serialized among themselves but
+ * never block readers. GetValue takes no lock: it walks whichever version is current when it starts. GetSnapshot()
+ * returns a version that stays unchanged for as long as the caller keeps it, for reads that must agree with each
+ * other.
+ */
+class CowTrie {
+ public:
+  /**
+   * Snapshot is one version of a CowTrie. It is cheap to copy, never changes, and keeps its nodes alive on its own,
+   * so it may outlive the trie.
+   */
+  class Snapshot {
+   public:
+    /**
+     * @brief Get the value of type T stored at key.
+     * @param key Key used to traverse the trie and find the correct node
+     * @param success set to whether key exists and holds a T
+     * @return the value, a default constructed T if success is false
+     */
+    template <typename T>
+    auto GetValue(std::string_view key, bool *success) const -> T {
+      return CowTrie::GetValueIn<T>(root_.get(), key, success);
+    }
+
+    /** @return the value of type T stored at key shared with the snapshot, nullptr if there is none */
+    template <typename T>
+    auto GetValuePtr(std::string_view key) const -> std::shared_ptr<const T> {
+      auto node = CowTrie::FindValueNode<T>(root_.get(), key);
+      return node == nullptr ? nullptr : node->GetValue();
+    }
+
+   private:
+    friend class CowTrie;
+    explicit Snapshot(std::shared_ptr<const CowTrieNode> root) : root_(std::move(root)) {}
+
+    std::shared_ptr<const CowTrieNode> root_;
+  };
+
+  CowTrie() : root_(new Root{std::make_shared<const CowTrieNode>('\0')}) {}
+
+  ~CowTrie() { delete root_.load(std::memory_order_relaxed); }
+
+  DISALLOW_COPY_AND_MOVE(CowTrie);
+
+  /** @return the current version of the trie */
+  auto GetSnapshot() -> Snapshot {
+    auto guard = epochs_.Pin();
+    return Snapshot(root_.load(std::memory_order_acquire)->node_);
+  }
+
+  /**
+   * @brief Get the value of type T stored at key in the current version. Takes no lock.
+   * @param key Key used to traverse the trie and find the correct node
+   * @param success set to whether key exists and holds a T
+   * @return the value, a default constructed T if success is false
+   */
+  template <typename T>
+  auto GetValue(std::string_view key, bool *success) -> T {
+    auto guard = epochs_.Pin();
+    return GetValueIn<T>(root_.load(std::memory_order_acquire)->node_.get(), key, success);
+  }
+
+  /**
+   * @brief Insert key-value pair into a new version of the trie. Fails if the key is empty or already exists.
+   * @return True if insertion succeeds, false otherwise
+   */
+  template <typename T>
+  auto Insert(std::string_view key, T value) -> bool {
+    if (key.empty()) {
+      return false;
+    }
+    std::scoped_lock lock(write_latch_);
+    std::vector<const CowTrieNode *> path = GetPath(key);
+    std::shared_ptr<const CowTrieNode> node;
+    if (path.size() == key.size() + 1) {
+      const CowTrieNode *old = path.back();
+      if (old->IsEndNode()) {
+        return false;
+      }
+      node = std::make_shared<const CowTrieNodeWithValue<T>>(old->GetKeyChar(), old->GetChildren(),
+                                                             std::make_shared<const T>(std::move(value)));
+      path.pop_back();
+    } else {
+      // Build the missing tail of the key bottom up.
+      node = std::make_shared<const CowTrieNodeWithValue<T>>(key.back(), CowTrieNode::Children{},
+                                                             std::make_shared<const T>(std::move(value)));
+      for (size_t i = key.size() - 1; i >= path.size(); i--) {
+        auto parent = std::make_unique<CowTrieNode>(key[i - 1]);
+        parent->SetChildNode(key[i], std::move(node));
+        node = std::move(parent);
+      }
+    }
+    Publish(CopyPath(path, key, std::move(node)));
+    return true;
+  }
+
+  /**
+   * @brief Remove key from a new version of the trie, along with the nodes no other key needs.
+   * @return True if the key exists and is removed, false otherwise
+   */
+  auto Remove(std::string_view key) -> bool {
+    if (key.empty()) {
+      return false;
+    }
+    std::scoped_lock lock(write_latch_);
+    std::vector<const CowTrieNode *> path = GetPath(key);
+    if (path.size() != key.size() + 1 || !path.back()->IsEndNode()) {
+      return false;
+    }
+    std::shared_ptr<const CowTrieNode> node;
+    if (path.back()->HasChildren()) {
+      node = std::make_shared<const CowTrieNode>(path.back()->GetKeyChar(), path.back()->GetChildren());
+    }
+    path.pop_back();
+    // Drop the ancestors left without a purpose, then copy the rest of the path.
+    if (node == nullptr) {
+      while (path.size() > 1 && !path.back()->IsEndNode() && path.back()->GetChildren().size() == 1) {
+        path.pop_back();
+      }
+    }
+    if (node == nullptr) {
+      auto parent = path.back()->Clone();
+      parent->RemoveChildNode(key[path.size() - 1]);
+      path.pop_back();
+      node = std::move(parent);
+    }
+    Publish(path.empty() ? std::move(node) : CopyPath(path, key, std::move(node)));
+    return true;
+  }
+
+ private:
+  /** A published version. Swapped in whole so readers load the root with one atomic pointer read. */
+  struct Root {
+    std::shared_ptr<const CowTrieNode> node_;
+  };
+
+  /** @return the node holding the value of key if it holds a T, nullptr otherwise */
+  template <typename T>
+  static auto FindValueNode(const CowTrieNode *node, std::string_view key) -> const CowTrieNodeWithValue<T> * {
+    if (key.empty()) {
+      return nullptr;
+    }
+    for (char ch : key) {
+      node = node->GetChildNode(ch);
+      if (node == nullptr) {
+        return nullptr;
+      }
+    }
+    return dynamic_cast<const CowTrieNodeWithValue<T> *>(node);
+  }
+
+  template <typename T>
+  static auto GetValueIn(const CowTrieNode *root, std::string_view key, bool *success) -> T {
+    auto node = FindValueNode<T>(root, key);
+    *success = node != nullptr;
+    return node == nullptr ? T{} : *node->GetValue();
+  }
+
+  /** @return the nodes on the path of key in the current version, from the root to the deepest existing one */
+  auto GetPath(std::string_view key) const -> std::vector<const CowTrieNode *> {
+    std::vector<const CowTrieNode *> path{root_.load(std::memory_order_relaxed)->node_.get()};
+    for (char ch : key) {
+      const CowTrieNode *child = path.back()->GetChildNode(ch);
+      if (child == nullptr) {
+        break;
+      }
+      path.push_back(child);
+    }
+    return path;
+  }
+
+  /**
+   * @brief Copy the nodes of path bottom up, each pointing at the copy below it, with node as the new child of the
+   * last one.
+   * @return the new root
+   */
+  static auto CopyPath(const std::vector<const CowTrieNode *> &path, std::string_view key,
+                       std::shared_ptr<const CowTrieNode> node) -> std::shared_ptr<const CowTrieNode> {
+    for (size_t i = path.size(); i-- > 0;) {
+      auto copy = path[i]->Clone();
+      copy->SetChildNode(key[i], std::move(node));
+      node = std::move(copy);
+    }
+    return node;
+  }
+
+  /** @brief Make root the current version. Readers of the old version keep it until they unpin. */
+  void Publish(std::shared_ptr<const CowTrieNode> root) {
+    Root *old = root_.exchange(new Root{std::move(root)}, std::memory_order_acq_rel);
+    epochs_.Retire(old);
+  }
+
+  /** The current version */
+  std::atomic<Root *> root_;
+  /** Serializes writers */
+  std::mutex write_latch_;
+  /** Defers freeing replaced versions until the readers that may be walking them are done */
+  EpochManager epochs_;
+};
+
+}  // namespace bustub
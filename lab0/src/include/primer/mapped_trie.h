@@ -0,0 +1,291 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mapped_trie.h
+//
+// Identification: src/include/primer/mapped_trie.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/macros.h"
+#include "primer/p0_trie.h"
+
+namespace bustub {
+
+/**
+ * The flat trie file format shared by TrieFileBuilder and MappedTrie.
+ *
+ * A file is a sequence of 4-byte aligned records addressed by their offset in 4-byte words, so it holds no pointers
+ * and can be used in place wherever it is mapped. It starts with a Header, and every other record is a node or a
+ * value:
+ *
+ *   node:  uint32 value word (0 if no key ends here) | uint32 n | n key chars, sorted | padding | n uint32 child words
+ *   value: sizeof(T) bytes for fixed size values, or uint32 length | bytes for strings; padded to 4 bytes
+ *
+ * Numbers are stored in host byte order; a file from a host of the other order fails the magic check.
+ */
+struct TrieFileFormat {
+  static constexpr uint64_t MAGIC = 0x3130454952544242;  // "BBTRIE01"
+  static constexpr uint32_t VERSION = 1;
+  /** Header::value_size_ of a file of string values. */
+  static constexpr uint32_t STRING_VALUE = UINT32_MAX;
+  static constexpr size_t WORD_SIZE = 4;
+
+  struct Header {
+    uint64_t magic_;
+    uint32_t version_;
+    /** sizeof the value type, or STRING_VALUE */
+    uint32_t value_size_;
+    uint64_t num_keys_;
+    /** File size in bytes */
+    uint64_t file_size_;
+    /** Word of the root node */
+    uint32_t root_word_;
+    uint32_t reserved_;
+  };
+
+  /** @return the value_size_ of a file of T values */
+  template <typename T>
+  static constexpr auto ValueSizeOf() -> uint32_t {
+    if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+      return STRING_VALUE;
+    } else {
+      static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values and strings can be stored");
+      return sizeof(T);
+    }
+  }
+};
+
+/**
+ * TrieFileBuilder writes a flat trie file from keys given in ascending order.
+ *
+ * Nodes are written bottom up as soon as no later key can reach them, so the builder keeps only the path of the
+ * last key in memory and the file is written in one sequential pass.
+ */
+class TrieFileBuilder {
+ public:
+  /**
+   * @brief Start a file. Throws Exception if it cannot be created.
+   * @param value_size the TrieFileFormat::Header::value_size_ of the values that will be added
+   */
+  TrieFileBuilder(const std::string &path, uint32_t value_size);
+
+  DISALLOW_COPY_AND_MOVE(TrieFileBuilder);
+
+  /**
+   * @brief Add a key and the bytes of its value.
+   * @param key a non-empty key greater than every key added before
+   * @param value value_size bytes, or the string for a file of strings
+   */
+  void Add(std::string_view key, std::string_view value);
+
+  /** @brief Write the nodes still open and the header. No key can be added afterwards. */
+  void Finish();
+
+  /**
+   * @brief Write every key of trie holding a value of type T to a file, in one ordered scan of the trie. Keys that
+   * hold values of other types are skipped.
+   * @return number of keys written
+   */
+  template <typename T>
+  static auto Write(Trie *trie, const std::string &path) -> size_t {
+    TrieFileBuilder builder(path, TrieFileFormat::ValueSizeOf<T>());
+    size_t count = 0;
+    for (auto it = trie->ScanPrefix(""); !it.IsEnd(); ++it) {
+      const T *value = it.GetValue<T>();
+      if (value == nullptr) {
+        continue;
+      }
+      if constexpr (std::is_same_v<T, std::string>) {
+        builder.Add(it.Key(), *value);
+      } else {
+        builder.Add(it.Key(), std::string_view(reinterpret_cast<const char *>(value), sizeof(T)));
+      }
+      count++;
+    }
+    builder.Finish();
+    return count;
+  }
+
+ private:
+  /** A node on the path of the last key, whose subtree may still grow. */
+  struct OpenNode {
+    uint32_t value_word_{0};
+    std::vector<std::pair<char, uint32_t>> children_;
+  };
+
+  /** @brief Write the deepest open node and link it into its parent. */
+  void CloseNode();
+
+  /** @brief Append bytes padded to a whole word. @return the word they start at */
+  auto Append(const void *data, size_t size) -> uint32_t;
+
+  std::ofstream out_;
+  uint32_t value_size_;
+  /** Bytes written so far. */
+  uint64_t size_{0};
+  uint64_t num_keys_{0};
+  std::string last_key_;
+  /** The nodes on the path of last_key_, stack_[i] reached by its first i chars. */
+  std::vector<OpenNode> stack_;
+  bool finished_{false};
+};
+
+/**
+ * MappedTrie is a read-only view of a flat trie file. The file is mapped, not read: opening it costs the same for
+ * any size, lookups walk the mapped nodes directly, and processes mapping the same file share its pages through the
+ * page cache.
+ *
+ * Only the header is checked when the file is opened; the rest of the file is trusted.
+ */
+class MappedTrie {
+ public:
+  /** @brief Map the file at path. Throws Exception if it cannot be mapped or is not a trie file. */
+  explicit MappedTrie(const std::string &path);
+
+  ~MappedTrie();
+
+  DISALLOW_COPY_AND_MOVE(MappedTrie);
+
+  /**
+   * @brief Get the value of type T stored at key.
+   *
+   * T is the value type the file was written with. For a file of strings, T may be std::string, or std::string_view
+   * for a view into the mapping that stays valid for the life of the MappedTrie.
+   *
+   * @param key Key used to traverse the trie and find the correct node
+   * @param success set to whether key exists and T matches the values of the file
+   * @return the value, a default constructed T if success is false
+   */
+  template <typename T>
+  auto GetValue(std::string_view key, bool *success) const -> T {
+    *success = false;
+    if (TrieFileFormat::ValueSizeOf<T>() != header_->value_size_ || key.empty()) {
+      return T{};
+    }
+    uint32_t node = header_->root_word_;
+    for (char ch : key) {
+      node = FindChild(node, ch);
+      if (node == 0) {
+        return T{};
+      }
+    }
+    const uint32_t value = Word(node);
+    if (value == 0) {
+      return T{};
+    }
+    *success = true;
+    return Decode<T>(value);
+  }
+
+  /**
+   * @brief Call visitor(key, value) for the keys starting with prefix, in lexicographic order. The walk stops after
+   * limit keys, so only the nodes leading to them are touched.
+   * @return number of keys visited
+   */
+  template <typename T, typename F>
+  auto ScanPrefix(std::string_view prefix, size_t limit, F &&visitor) const -> size_t {
+    if (TrieFileFormat::ValueSizeOf<T>() != header_->value_size_ || limit == 0) {
+      return 0;
+    }
+    uint32_t node = header_->root_word_;
+    for (char ch : prefix) {
+      node = FindChild(node, ch);
+      if (node == 0) {
+        return 0;
+      }
+    }
+    std::string key(prefix);
+    size_t count = 0;
+    Visit<T>(node, &key, limit, &count, visitor);
+    return count;
+  }
+
+  /** @return number of keys in the file */
+  auto GetNumKeys() const -> uint64_t { return header_->num_keys_; }
+
+ private:
+  auto Word(uint32_t word) const -> uint32_t {
+    uint32_t result;
+    std::memcpy(&result, data_ + static_cast<size_t>(word) * TrieFileFormat::WORD_SIZE, sizeof(result));
+    return result;
+  }
+
+  auto Bytes(uint32_t word) const -> const char * {
+    return data_ + static_cast<size_t>(word) * TrieFileFormat::WORD_SIZE;
+  }
+
+  /** @return the number of children of node and their key chars */
+  auto Keys(uint32_t node, const uint8_t **keys) const -> uint32_t {
+    *keys = reinterpret_cast<const uint8_t *>(Bytes(node + 2));
+    return Word(node + 1);
+  }
+
+  /** @return the word of the i-th of the n children of node */
+  auto ChildWord(uint32_t node, uint32_t n, uint32_t i) const -> uint32_t {
+    return Word(node + 2 + (n + TrieFileFormat::WORD_SIZE - 1) / TrieFileFormat::WORD_SIZE + i);
+  }
+
+  /** @return the word of the child of node with key char key_char, 0 if there is none */
+  auto FindChild(uint32_t node, char key_char) const -> uint32_t {
+    const uint8_t *keys;
+    const uint32_t n = Keys(node, &keys);
+    const auto key = static_cast<uint8_t>(key_char);
+    const uint8_t *it = std::lower_bound(keys, keys + n, key);
+    if (it == keys + n || *it != key) {
+      return 0;
+    }
+    return ChildWord(node, n, static_cast<uint32_t>(it - keys));
+  }
+
+  template <typename T>
+  auto Decode(uint32_t value) const -> T {
+    if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+      return T(Bytes(value + 1), Word(value));
+    } else {
+      T result;
+      std::memcpy(&result, Bytes(value), sizeof(T));
+      return result;
+    }
+  }
+
+  template <typename T, typename F>
+  void Visit(uint32_t node, std::string *key, size_t limit, size_t *count, F &visitor) const {
+    const uint32_t value = Word(node);
+    if (value != 0) {
+      visitor(static_cast<const std::string &>(*key), Decode<T>(value));
+      if (++*count == limit) {
+        return;
+      }
+    }
+    const uint8_t *keys;
+    const uint32_t n = Keys(node, &keys);
+    for (uint32_t i = 0; i < n && *count < limit; i++) {
+      key->push_back(static_cast<char>(keys[i]));
+      Visit<T>(ChildWord(node, n, i), key, limit, count, visitor);
+      key->pop_back();
+    }
+  }
+
+  const char *data_{nullptr};
+  size_t size_{0};
+  const TrieFileFormat::Header *header_{nullptr};
+};
+
+}  // namespace bustub
@@ -12,23 +12,80 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <thread>  // NOLINT
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "common/epoch_manager.h"
 #include "common/exception.h"
-#include "common/rwlatch.h"
+#include "primer/trie_arena.h"
+#include "primer/trie_children.h"
 
 namespace bustub {
 
 /**
  * TrieNode is a generic container for any node in Trie.
+ *
+ * Nodes are read without latches. Each node carries a version word that writers lock and bump, and readers
+ * validate the versions they read against it (optimistic lock coupling). The children of a node are never modified
+ * in place: a single child is stored inline in the children word, and more children live in an immutable
+ * TrieChildren set that writers replace, so a reader never sees a half-updated child set.
+ *
+ * A node is allocated either with new or from a TrieArena, see Make(). Nodes are released with Destroy(), which
+ * TrieNode::Ptr calls; a std::unique_ptr<TrieNode> of a node made with new converts to it.
  */
 class TrieNode {
  public:
+  /** Releases a node with Destroy(). */
+  struct Deleter {
+    Deleter() = default;
+    template <typename U>
+    Deleter(const std::default_delete<U> & /*unused*/) {}  // NOLINT: unique_ptr<TrieNode> converts to Ptr
+    void operator()(TrieNode *node) const { Destroy(node); }
+  };
+  using Ptr = std::unique_ptr<TrieNode, Deleter>;
+
+  /**
+   * @brief Construct a node of type N in arena, or with new if arena is nullptr or N is too large for it.
+   * Its child sets come from the same arena.
+   */
+  template <typename N, typename... Args>
+  static Ptr Make(TrieArena *arena, Args &&...args) {
+    uint8_t size_class;
+    void *block = arena == nullptr ? nullptr : arena->Allocate(sizeof(N), &size_class);
+    if (block == nullptr) {
+      return Ptr(new N(std::forward<Args>(args)...));
+    }
+    N *node = new (block) N(std::forward<Args>(args)...);
+    node->alloc_class_ = size_class;
+    return Ptr(node);
+  }
+
+  /** @brief Destroy a node and its children and release their memory, whichever way it was allocated. */
+  static void Destroy(TrieNode *node) {
+    if (node == nullptr) {
+      return;
+    }
+    if (node->alloc_class_ == 0) {
+      delete node;
+      return;
+    }
+    const uint8_t size_class = node->alloc_class_;
+    TrieArena *arena = TrieArena::Owner(node);
+    node->~TrieNode();
+    arena->Deallocate(node, size_class);
+  }
+
   /**
    * TODO(P0): Add implementation
    *
@@ -37,31 +94,29 @@ class TrieNode {
    *
    * @param key_char Key character of this trie node
    */
-  explicit TrieNode(char key_char) {
-    this->is_end_ = false;
-    this->key_char_ = key_char;
-    children_.clear();
-  }
+  explicit TrieNode(char key_char) : key_char_(key_char) {}
 
   /**
    * TODO(P0): Add implementation
    *
-   * @brief Move constructor for trie node object. The unique pointers stored
-   * in children_ should be moved from other_trie_node to new trie node.
+   * @brief Move constructor for trie node object. The children of other_trie_node
+   * are moved to the new trie node.
    *
    * @param other_trie_node Old trie node.
    */
-  TrieNode(TrieNode &&other_trie_node) noexcept {
-    this->is_end_ = other_trie_node.is_end_;
-    this->key_char_ = other_trie_node.key_char_;
-    // children_.swap(other_trie_node.children_);
-    children_.swap(other_trie_node.children_);
-  }
+  TrieNode(TrieNode &&other_trie_node) noexcept
+      : key_char_(other_trie_node.key_char_),
+        is_end_(other_trie_node.is_end_.load(std::memory_order_relaxed)),
+        children_(other_trie_node.children_.exchange(0, std::memory_order_acq_rel)) {}
 
   /**
-   * @brief Destroy the TrieNode object.
+   * @brief Destroy the TrieNode object and all of its children.
    */
-  virtual ~TrieNode() = default;
+  virtual ~TrieNode() {
+    const uintptr_t children = children_.load(std::memory_order_relaxed);
+    ForEachChildIn(children, [](const TrieChildren::Entry &child) { Destroy(child.second); });
+    TrieChildren::Destroy(AsSet(children));
+  }
 
   /**
    * TODO(P0): Add implementation
@@ -71,7 +126,7 @@ class TrieNode {
    * @param key_char Key char of child node.
    * @return True if this trie node has a child with given key, false otherwise.
    */
-  bool HasChild(char key_char) const { return (children_.find(key_char) != children_.end()); }
+  bool HasChild(char key_char) const { return GetChildNode(key_char) != nullptr; }
 
   /**
    * TODO(P0): Add implementation
@@ -81,7 +136,16 @@ class TrieNode {
    *
    * @return True if this trie node has any child node, false if it has no child node.
    */
-  bool HasChildren() const { return !children_.empty(); }
+  bool HasChildren() const { return children_.load(std::memory_order_acquire) != 0; }
+
+  /** @return the number of children of this trie node */
+  size_t GetNumChildren() const {
+    const uintptr_t children = children_.load(std::memory_order_acquire);
+    if (children == 0) {
+      return 0;
+    }
+    return AsSet(children) == nullptr ? 1 : AsSet(children)->Size();
+  }
 
   /**
    * TODO(P0): Add implementation
@@ -90,7 +154,7 @@ class TrieNode {
    *
    * @return True if is_end_ flag is true, false if is_end_ is false.
    */
-  bool IsEndNode() const { return is_end_; }
+  bool IsEndNode() const { return is_end_.load(std::memory_order_acquire); }
 
   /**
    * TODO(P0): Add implementation
@@ -104,61 +168,94 @@ class TrieNode {
   /**
    * TODO(P0): Add implementation
    *
-   * @brief Insert a child node for this trie node into children_ map, given the key char and
-   * unique_ptr of the child node. If specified key_char already exists in children_,
-   * return nullptr. If parameter `child`'s key char is different than parameter
-   * `key_char`, return nullptr.
+   * @brief Insert a child node for this trie node, given the key char and unique_ptr of the child node.
+   * If the node already has a child with key_char, return nullptr. If parameter `child`'s key char is
+   * different than parameter `key_char`, return nullptr.
    *
-   * Note that parameter `child` is rvalue and should be moved when it is
-   * inserted into children_map.
+   * Unlike the P0 handout, which returns a pointer to the unique_ptr held in the children map, this returns the
+   * child itself: the children word holds raw node pointers, so there is no unique_ptr to point to. Use
+   * `child->GetKeyChar()` where the handout has `(*child)->GetKeyChar()`.
    *
-   * The return value is a pointer to unique_ptr because pointer to unique_ptr can access the
-   * underlying data without taking ownership of the unique_ptr. Further, we can set the return
-   * value to nullptr when error occurs.
+   * The child set is replaced, not modified. Once this node is reachable by readers the caller must hold its
+   * write lock and pass old_children, so that the old set can be retired after the readers are done with it.
    *
-   * @param key Key of child node
-   * @param child Unique pointer created for the child node. This should be added to children_ map.
-   * @return Pointer to unique_ptr of the inserted child node. If insertion fails, return nullptr.
+   * @param key_char Key of child node
+   * @param child Unique pointer created for the child node. The node takes ownership of it on success.
+   * @param[out] old_children receives the replaced set, nullptr to free it right away
+   * @return Pointer to the inserted child node. If insertion fails, return nullptr.
    */
-  std::unique_ptr<TrieNode> *InsertChildNode(char key_char, std::unique_ptr<TrieNode> &&child) {
-    if (key_char == child->GetKeyChar() && children_.find(key_char) == children_.end()) {
-      children_[key_char] = std::move(child);
-      return &children_[key_char];
+  TrieNode *InsertChildNode(char key_char, Ptr &&child, TrieChildren::Ptr *old_children = nullptr) {
+    if (key_char != child->GetKeyChar() || HasChild(key_char)) {
+      return nullptr;
     }
+    ChildList children(children_.load(std::memory_order_relaxed));
+    TrieNode *raw = child.release();
+    children.Insert(children.LowerBound(key_char), {key_char, raw});
+    Publish(children, old_children);
+    return raw;
+  }
 
-    return nullptr;
+  /**
+   * @brief Replace the child node with the given key char. Same locking rules as InsertChildNode().
+   *
+   * @param key_char Key of child node
+   * @param child the new child node, it must have the same key char
+   * @param[out] old_children receives the replaced set, nullptr to free it right away
+   * @return The replaced child node, nullptr if there was no child with given key.
+   */
+  Ptr ReplaceChildNode(char key_char, Ptr &&child, TrieChildren::Ptr *old_children = nullptr) {
+    if (key_char != child->GetKeyChar()) {
+      return nullptr;
+    }
+    ChildList children(children_.load(std::memory_order_relaxed));
+    auto *it = children.LowerBound(key_char);
+    if (it == children.end() || it->first != key_char) {
+      return nullptr;
+    }
+    Ptr old_child(it->second);
+    it->second = child.release();
+    Publish(children, old_children);
+    return old_child;
   }
 
   /**
    * TODO(P0): Add implementation
    *
    * @brief Get the child node given its key char. If child node for given key char does
-   * not exist, return nullptr.
+   * not exist, return nullptr. Like InsertChildNode(), this returns the child rather than a pointer to a unique_ptr.
+   * Readers that may race with writers must go through Trie, which validates the node version around the call.
    *
-   * @param key Key of child node
-   * @return Pointer to unique_ptr of the child node, nullptr if child
-   *         node does not exist.
+   * @param key_char Key of child node
+   * @return Pointer to the child node, nullptr if child node does not exist.
    */
-  std::unique_ptr<TrieNode> *GetChildNode(char key_char) {
-    auto it = children_.find(key_char);
-    return it == children_.end() ? nullptr : &(*it).second;
+  TrieNode *GetChildNode(char key_char) const {
+    return FindChildIn(children_.load(std::memory_order_acquire), key_char);
   }
 
   /**
    * TODO(P0): Add implementation
    *
-   * @brief Remove child node from children_ map.
-   * If key_char does not exist in children_, return immediately.
+   * @brief Remove child node from the children of this node.
+   * If the node has no child with key_char, return nullptr and change nothing. Same locking rules as
+   * InsertChildNode().
+   *
+   * The removed child is handed back instead of destroyed, so that Trie can retire it once no reader holds it.
+   * Discarding the result destroys it right away, which is what the void P0 handout version does.
    *
    * @param key_char Key char of child node to be removed
+   * @param[out] old_children receives the replaced set, nullptr to free it right away
+   * @return The removed child node, nullptr if there was no child with given key.
    */
-  void RemoveChildNode(char key_char) {
-    auto it = children_.find(key_char);
-    if (it == children_.end()) {
-      return;
+  Ptr RemoveChildNode(char key_char, TrieChildren::Ptr *old_children = nullptr) {
+    ChildList children(children_.load(std::memory_order_relaxed));
+    auto *it = children.LowerBound(key_char);
+    if (it == children.end() || it->first != key_char) {
+      return nullptr;
     }
-
-    children_.erase(it);
+    Ptr old_child(it->second);
+    children.Erase(it);
+    Publish(children, old_children);
+    return old_child;
   }
 
   /**
@@ -168,16 +265,153 @@ class TrieNode {
    *
    * @param is_end Whether this trie node is ending char of a key string
    */
-  void SetEndNode(bool is_end) { this->is_end_ = is_end; }
+  void SetEndNode(bool is_end) { is_end_.store(is_end, std::memory_order_release); }
 
  protected:
   /** Key character of this trie node */
   char key_char_;
   /** whether this node marks the end of a key */
-  bool is_end_{false};
-  /** A map of all child nodes of this trie node, which can be accessed by each
-   * child node's key char. */
-  std::unordered_map<char, std::unique_ptr<TrieNode>> children_;
+  std::atomic<bool> is_end_{false};
+  /** TrieArena size class of this node, 0 if it was allocated with new. Not moved by the move constructor. */
+  uint8_t alloc_class_{0};
+  /**
+   * Children of this trie node: 0 if it has none, the only child tagged with SINGLE_CHILD, or a TrieChildren set.
+   * Owns the set and the child nodes.
+   */
+  std::atomic<uintptr_t> children_{0};
+
+ private:
+  friend class Trie;
+
+  /** Version bit set once the node is unlinked from the trie. */
+  static constexpr uint64_t OBSOLETE = 1;
+  /** Version bit held by the writer of the node. Unlocking adds it again, which bumps the version. */
+  static constexpr uint64_t LOCKED = 2;
+  /** Tag of a children word that holds a single child inline. */
+  static constexpr uintptr_t SINGLE_CHILD = 1;
+
+  /**
+   * @return the child with the smallest key char above after, compared as unsigned char, nullptr if there is none
+   * @param after a key char as unsigned char, -1 for the first child
+   */
+  TrieNode *GetNextChild(int after) const {
+    const uintptr_t children = children_.load(std::memory_order_acquire);
+    if ((children & SINGLE_CHILD) != 0) {
+      auto *child = reinterpret_cast<TrieNode *>(children & ~SINGLE_CHILD);
+      return static_cast<unsigned char>(child->key_char_) > after ? child : nullptr;
+    }
+    return children == 0 ? nullptr : AsSet(children)->FindNext(after);
+  }
+
+  /** @return the child with the given key char in a children word, nullptr if there is none */
+  static TrieNode *FindChildIn(uintptr_t children, char key_char) {
+    if ((children & SINGLE_CHILD) != 0) {
+      auto *child = reinterpret_cast<TrieNode *>(children & ~SINGLE_CHILD);
+      return child->key_char_ == key_char ? child : nullptr;
+    }
+    return children == 0 ? nullptr : AsSet(children)->Find(key_char);
+  }
+
+  /** @return the child set of a children word, nullptr if it holds no set */
+  static const TrieChildren *AsSet(uintptr_t children) {
+    return (children & SINGLE_CHILD) != 0 ? nullptr : reinterpret_cast<const TrieChildren *>(children);
+  }
+
+  template <typename F>
+  static void ForEachChildIn(uintptr_t children, F &&f) {
+    if ((children & SINGLE_CHILD) != 0) {
+      auto *child = reinterpret_cast<TrieNode *>(children & ~SINGLE_CHILD);
+      f(TrieChildren::Entry{child->key_char_, child});
+    } else if (children != 0) {
+      AsSet(children)->ForEach(f);
+    }
+  }
+
+  /** The children of a node copied out of its children word for editing, in key char order. No allocation. */
+  class ChildList {
+   public:
+    explicit ChildList(uintptr_t children) {
+      ForEachChildIn(children, [this](const TrieChildren::Entry &child) { entries_[size_++] = child; });
+    }
+
+    auto begin() -> TrieChildren::Entry * { return entries_.data(); }  // NOLINT
+    auto end() -> TrieChildren::Entry * { return entries_.data() + size_; }  // NOLINT
+    auto Size() const -> size_t { return size_; }
+
+    auto LowerBound(char key_char) -> TrieChildren::Entry * {
+      return std::lower_bound(begin(), end(), key_char, [](const TrieChildren::Entry &child, char key) {
+        return static_cast<unsigned char>(child.first) < static_cast<unsigned char>(key);
+      });
+    }
+
+    void Insert(TrieChildren::Entry *pos, const TrieChildren::Entry &child) {
+      std::move_backward(pos, end(), end() + 1);
+      *pos = child;
+      size_++;
+    }
+
+    void Erase(TrieChildren::Entry *pos) {
+      std::move(pos + 1, end(), pos);
+      size_--;
+    }
+
+   private:
+    std::array<TrieChildren::Entry, TrieChildren::MAX_CHILDREN> entries_;
+    size_t size_{0};
+  };
+
+  /** @return the arena this node was allocated from, nullptr if it was allocated with new */
+  TrieArena *GetArena() const { return alloc_class_ == 0 ? nullptr : TrieArena::Owner(this); }
+
+  /** @brief Swap in the given children and hand the replaced set to old_children. */
+  void Publish(ChildList &list, TrieChildren::Ptr *old_children) {
+    uintptr_t children = 0;
+    if (list.Size() == 1) {
+      children = reinterpret_cast<uintptr_t>(list.begin()->second) | SINGLE_CHILD;
+    } else if (list.Size() > 1) {
+      children = reinterpret_cast<uintptr_t>(TrieChildren::Build(list.begin(), list.Size(), GetArena()));
+    }
+    const TrieChildren *set = AsSet(children_.exchange(children, std::memory_order_acq_rel));
+    if (old_children != nullptr) {
+      old_children->reset(set);
+    } else {
+      TrieChildren::Destroy(set);
+    }
+  }
+
+  /**
+   * @brief Read the version of this node, waiting out a writer that holds it.
+   * @param[out] version the unlocked version
+   * @return false if the node is obsolete and the operation must restart from the root
+   */
+  bool ReadLockOrRestart(uint64_t *version) const {
+    uint64_t v = version_.load(std::memory_order_acquire);
+    while ((v & LOCKED) != 0) {
+      std::this_thread::yield();
+      v = version_.load(std::memory_order_acquire);
+    }
+    *version = v;
+    return (v & OBSOLETE) == 0;
+  }
+
+  /**
+   * @return true if nothing wrote this node since version was read, i.e. the reads in between are consistent.
+   * Those reads are all acquire loads, so none of them can be ordered after the check.
+   */
+  bool CheckOrRestart(uint64_t version) const { return version_.load(std::memory_order_acquire) == version; }
+
+  /** @return true if the write lock was taken, false if the node changed since version was read */
+  bool UpgradeToWriteLockOrRestart(uint64_t version) {
+    return version_.compare_exchange_strong(version, version + LOCKED, std::memory_order_acq_rel);
+  }
+
+  void WriteUnlock() { version_.fetch_add(LOCKED, std::memory_order_release); }
+
+  /** @brief Release the write lock of a node that was unlinked, readers that reach it will restart. */
+  void WriteUnlockObsolete() { version_.fetch_add(LOCKED + OBSOLETE, std::memory_order_release); }
+
+  /** Modification counter, see OBSOLETE and LOCKED. */
+  std::atomic<uint64_t> version_{0};
 };
 
 /**
@@ -187,7 +421,7 @@ class TrieNode {
 template <typename T>
 class TrieNodeWithValue : public TrieNode {
  private:
-  /* Value held by this trie node. */
+  /* Value held by this trie node. It is never modified, so readers may copy it without a latch. */
   T value_;
 
  public:
@@ -197,8 +431,8 @@ class TrieNodeWithValue : public TrieNode {
    * @brief Construct a new TrieNodeWithValue object from a TrieNode object and specify its value.
    * This is used when a non-terminal TrieNode is converted to terminal TrieNodeWithValue.
    *
-   * The children_ map of TrieNode should be moved to the new TrieNodeWithValue object.
-   * Since it contains unique pointers, the first parameter is a rvalue reference.
+   * The children of TrieNode should be moved to the new TrieNodeWithValue object.
+   * Since the node owns them, the first parameter is a rvalue reference.
    *
    * You should:
    * 1) invoke TrieNode's move constructor to move data from TrieNode to
@@ -209,7 +443,9 @@ class TrieNodeWithValue : public TrieNode {
    * @param trieNode TrieNode whose data is to be moved to TrieNodeWithValue
    * @param value
    */
-  TrieNodeWithValue(TrieNode &&trieNode, T value) : TrieNode(std::move(trieNode)), value_(value) { SetEndNode(true); }
+  TrieNodeWithValue(TrieNode &&trieNode, T value) : TrieNode(std::move(trieNode)), value_(std::move(value)) {
+    SetEndNode(true);
+  }
 
   /**
    * TODO(P0): Add implementation
@@ -224,7 +460,7 @@ class TrieNodeWithValue : public TrieNode {
    * @param key_char Key char of this node
    * @param value Value of this node
    */
-  TrieNodeWithValue(char key_char, T value) : TrieNode(key_char), value_(value) { SetEndNode(true); }
+  TrieNodeWithValue(char key_char, T value) : TrieNode(key_char), value_(std::move(value)) { SetEndNode(true); }
 
   /**
    * @brief Destroy the Trie Node With Value object
@@ -237,18 +473,346 @@ class TrieNodeWithValue : public TrieNode {
    * @return Value of type T stored in this node
    */
   T GetValue() const { return value_; }
+
+  /**
+   * @brief Get a reference to the stored value_, valid for as long as the node is.
+   *
+   * @return Value of type T stored in this node
+   */
+  const T &GetValueRef() const { return value_; }
 };
 
 /**
  * Trie is a concurrent key-value store. Each key is a string and its corresponding
  * value can be any type.
+ *
+ * Lookups take no latches: they descend optimistically, validate every version they read and restart from the root
+ * when a writer interfered. Writers lock only the nodes they modify and never change a node in place beyond its
+ * child set, so a node that gains or loses its value is replaced. Unlinked nodes and child sets are retired to an
+ * epoch manager and deleted once no reader can still be looking at them.
+ *
+ * A trie built with an arena allocates its nodes and child sets from a TrieArena of its own. Nodes freed by Remove
+ * are reused by later inserts, and if no value needs its destructor run the whole trie is released chunk by chunk.
  */
 class Trie {
  private:
-  /* Root node of the trie */
-  std::unique_ptr<TrieNode> root_;
-  /* Read-write lock for the trie */
-  ReaderWriterLatch latch_;
+  /* Allocator of the nodes, nullptr to use new. Declared first so it outlives every node. */
+  std::unique_ptr<TrieArena> arena_;
+  /* Whether a node holds a value that must be destroyed, either for its destructor or because it is on the heap */
+  std::atomic<bool> needs_destroy_{false};
+  /* Root node of the trie. It is never replaced nor made obsolete. */
+  TrieNode::Ptr root_;
+  /* Defers deleting unlinked nodes and child sets until concurrent readers are done with them */
+  EpochManager epochs_;
+
+  /** @brief Build the chain of nodes for key[depth:], ending in a node holding value. */
+  template <typename T>
+  TrieNode::Ptr MakeChain(std::string_view key, size_t depth, T &&value) {
+    TrieNode::Ptr chain = TrieNode::Make<TrieNodeWithValue<T>>(arena_.get(), key.back(), std::move(value));
+    for (size_t i = key.size() - 1; i > depth; i--) {
+      auto parent = TrieNode::Make<TrieNode>(arena_.get(), key[i - 1]);
+      parent->InsertChildNode(key[i], std::move(chain));
+      chain = std::move(parent);
+    }
+    return chain;
+  }
+
+  /** @brief Remember that the trie must be walked on destruction once it holds a T. */
+  template <typename T>
+  void NoteValueType() {
+    if constexpr (!std::is_trivially_destructible_v<T> || sizeof(TrieNodeWithValue<T>) > TrieArena::MAX_BLOCK_SIZE) {
+      if (arena_ != nullptr && !needs_destroy_.load(std::memory_order_relaxed)) {
+        needs_destroy_.store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Find the node holding the value of key, if it holds a T. No latch is taken: the version of each node is
+   * validated after reading its child, and of the result after the type check, and the lookup restarts from the
+   * root if any of them changed. The caller must be pinned to epochs_ for as long as it uses the result.
+   *
+   * @return the node, nullptr if key is empty, absent, or holds a value of another type
+   */
+  template <typename T>
+  const TrieNodeWithValue<T> *FindValueNode(std::string_view key) const {
+    if (key.empty()) {
+      return nullptr;
+    }
+    while (true) {
+      const TrieNode *node = root_.get();
+      uint64_t version;
+      if (!node->ReadLockOrRestart(&version)) {
+        continue;
+      }
+
+      bool restart = false;
+      for (char ch : key) {
+        const TrieNode *child = node->GetChildNode(ch);
+        if (child == nullptr) {
+          if (!node->CheckOrRestart(version)) {
+            restart = true;
+            break;
+          }
+          return nullptr;
+        }
+        uint64_t child_version;
+        if (!child->ReadLockOrRestart(&child_version) || !node->CheckOrRestart(version)) {
+          restart = true;
+          break;
+        }
+        node = child;
+        version = child_version;
+      }
+      if (restart) {
+        continue;
+      }
+
+      auto p = dynamic_cast<const TrieNodeWithValue<T> *>(node);
+      if (!node->CheckOrRestart(version)) {
+        continue;
+      }
+      return p;
+    }
+  }
+
+  /**
+   * The nodes on the path of the last key of a batch and the versions they were read at, path[i] reached by the
+   * first i chars of the key. The next key of the batch resumes from the deepest of them it shares.
+   */
+  using Path = std::vector<std::pair<TrieNode *, uint64_t>>;
+
+  static size_t CommonPrefixLength(std::string_view a, std::string_view b) {
+    const size_t length = std::min(a.size(), b.size());
+    return static_cast<size_t>(std::mismatch(a.begin(), a.begin() + length, b.begin()).first - a.begin());
+  }
+
+  /**
+   * @brief Keep the first shared + 1 nodes of path, for a key sharing its first shared chars with the key path was
+   * walked for, if the last of them is unchanged since it was read. Start again from the root otherwise. A node
+   * whose version is unchanged is still in the trie: unlinking or replacing a node marks it obsolete.
+   */
+  void ResumePath(Path *path, size_t shared) const {
+    path->resize(std::min(shared + 1, path->size()));
+    if (!path->empty() && path->back().first->CheckOrRestart(path->back().second)) {
+      return;
+    }
+    path->clear();
+    uint64_t version;
+    root_->ReadLockOrRestart(&version);  // the root is never obsolete
+    path->emplace_back(root_.get(), version);
+  }
+
+  /** Number of lookups LookUpBatch() walks down the trie at the same time. */
+  static constexpr size_t MULTI_GET_WIDTH = 8;
+  /** Number of keys InsertBatch() brings the paths of into cache before inserting them. */
+  static constexpr size_t INSERT_BATCH_CHUNK = 32;
+
+  /**
+   * A lookup of LookUpBatch() in progress. Each step of a lookup reads at most one node or child set that is likely
+   * not cached, and prefetches what the next step reads, so the lookups of a batch wait for memory together.
+   */
+  struct Probe {
+    /** Position of the key in the batch. */
+    size_t index_;
+    /** The node to enter next, or whose children_ to search if find_ is set. */
+    const TrieNode *node_;
+    uint64_t version_;
+    /** The parent of node_ and the version its child pointer was read at, nullptr for the root. */
+    const TrieNode *parent_;
+    uint64_t parent_version_;
+    /** Number of key chars matched to reach node_. */
+    size_t depth_;
+    /** The children word of node_, read once it was entered. */
+    uintptr_t children_;
+    bool find_;
+  };
+
+  void StartProbe(Probe *probe, size_t index) const {
+    *probe = Probe{index, root_.get(), 0, nullptr, 0, 0, 0, false};
+  }
+
+  /**
+   * @brief Advance a lookup of LookUpBatch() by one step, restarting it from the root if a writer interfered.
+   * @param[out] result the node holding the value of key if it holds a T, nullptr otherwise, once the lookup ends
+   * @return true once the lookup ended
+   */
+  template <typename T>
+  bool StepProbe(Probe *probe, std::string_view key, const TrieNodeWithValue<T> **result) const {
+    if (!probe->find_) {
+      // Enter node_, validating its parent after reading its version.
+      uint64_t version;
+      if (!probe->node_->ReadLockOrRestart(&version) ||
+          (probe->parent_ != nullptr && !probe->parent_->CheckOrRestart(probe->parent_version_))) {
+        StartProbe(probe, probe->index_);
+        return false;
+      }
+      probe->version_ = version;
+      if (probe->depth_ == key.size()) {
+        auto p = dynamic_cast<const TrieNodeWithValue<T> *>(probe->node_);
+        if (!probe->node_->CheckOrRestart(version)) {
+          StartProbe(probe, probe->index_);
+          return false;
+        }
+        *result = p;
+        return true;
+      }
+      probe->children_ = probe->node_->children_.load(std::memory_order_acquire);
+      probe->find_ = true;
+      if (const TrieChildren *set = TrieNode::AsSet(probe->children_); set != nullptr) {
+        __builtin_prefetch(set);
+        return false;
+      }
+    }
+
+    const TrieNode *child = TrieNode::FindChildIn(probe->children_, key[probe->depth_]);
+    if (child == nullptr) {
+      if (!probe->node_->CheckOrRestart(probe->version_)) {
+        StartProbe(probe, probe->index_);
+        return false;
+      }
+      *result = nullptr;
+      return true;
+    }
+    __builtin_prefetch(child);
+    probe->parent_ = probe->node_;
+    probe->parent_version_ = probe->version_;
+    probe->node_ = child;
+    probe->depth_++;
+    probe->find_ = false;
+    return false;
+  }
+
+  /**
+   * @brief Look up keys MULTI_GET_WIDTH at a time, interleaving the steps of the lookups. The caller must be pinned.
+   * @param f called with the position of each key and the node holding its value if it holds a T, or nullptr
+   */
+  template <typename T, typename F>
+  void LookUpBatch(const std::string_view *keys, size_t num_keys, F &&f) const {
+    std::array<Probe, MULTI_GET_WIDTH> probes;
+    size_t num_probes = 0;
+    size_t next = 0;
+    while (num_probes > 0 || next < num_keys) {
+      // Keep every probe busy, then step each of them once.
+      while (num_probes < MULTI_GET_WIDTH && next < num_keys) {
+        if (keys[next].empty()) {
+          f(next, nullptr);
+        } else {
+          StartProbe(&probes[num_probes++], next);
+        }
+        next++;
+      }
+      for (size_t i = 0; i < num_probes;) {
+        const TrieNodeWithValue<T> *node;
+        if (!StepProbe<T>(&probes[i], keys[probes[i].index_], &node)) {
+          i++;
+          continue;
+        }
+        f(probes[i].index_, node);
+        probes[i] = probes[--num_probes];
+      }
+    }
+  }
+
+  /**
+   * @brief Insert() from the deepest node of path on the way to key, see ResumePath(). The node written is left
+   * last in path with the version the write gave it, so the next key of a batch can resume from it.
+   * @param shared number of chars key shares with the key path was walked for
+   */
+  template <typename T>
+  bool InsertAlong(std::string_view key, T &&value, size_t shared, Path *path) {
+    while (true) {
+      // Descend to the parent of the terminal node, or to the first node that misses the next char.
+      ResumePath(path, std::min(shared, key.size() - 1));
+      TrieNode *child;
+      bool restart = false;
+      while (true) {
+        auto [node, version] = path->back();
+        child = node->GetChildNode(key[path->size() - 1]);
+        if (child == nullptr || path->size() == key.size()) {
+          break;
+        }
+        uint64_t child_version;
+        if (!child->ReadLockOrRestart(&child_version) || !node->CheckOrRestart(version)) {
+          restart = true;
+          break;
+        }
+        path->emplace_back(child, child_version);
+      }
+      if (restart) {
+        path->clear();
+        continue;
+      }
+
+      auto [node, version] = path->back();
+      if (child == nullptr) {
+        if (!node->UpgradeToWriteLockOrRestart(version)) {
+          path->clear();
+          continue;
+        }
+        TrieChildren::Ptr old_children;
+        NoteValueType<T>();
+        node->InsertChildNode(key[path->size() - 1], MakeChain(key, path->size() - 1, std::move(value)),
+                              &old_children);
+        node->WriteUnlock();
+        path->back().second = version + 2 * TrieNode::LOCKED;
+        RetireChildren(std::move(old_children));
+        return true;
+      }
+
+      uint64_t child_version;
+      if (!child->ReadLockOrRestart(&child_version) || !node->CheckOrRestart(version)) {
+        path->clear();
+        continue;
+      }
+      if (child->IsEndNode()) {
+        if (!child->CheckOrRestart(child_version)) {
+          path->clear();
+          continue;
+        }
+        path->emplace_back(child, child_version);
+        return false;
+      }
+      if (!node->UpgradeToWriteLockOrRestart(version)) {
+        path->clear();
+        continue;
+      }
+      if (!child->UpgradeToWriteLockOrRestart(child_version)) {
+        node->WriteUnlock();
+        path->clear();
+        continue;
+      }
+      NoteValueType<T>();
+      ReplaceLocked(node, child,
+                    TrieNode::Make<TrieNodeWithValue<T>>(arena_.get(), std::move(*child), std::move(value)));
+      path->back().second = version + 2 * TrieNode::LOCKED;
+      return true;
+    }
+  }
+
+  void RetireNode(TrieNode::Ptr node) {
+    epochs_.Retire(node.release(), [](void *object) { TrieNode::Destroy(static_cast<TrieNode *>(object)); });
+  }
+
+  void RetireChildren(TrieChildren::Ptr children) {
+    if (children != nullptr) {
+      epochs_.Retire(const_cast<TrieChildren *>(children.release()),
+                     [](void *set) { TrieChildren::Destroy(static_cast<TrieChildren *>(set)); });
+    }
+  }
+
+  /**
+   * @brief Swap the locked child of a locked parent for replacement, then unlock both and retire the old child.
+   * The children of the old child move to the replacement.
+   */
+  void ReplaceLocked(TrieNode *parent, TrieNode *child, TrieNode::Ptr &&replacement) {
+    TrieChildren::Ptr old_children;
+    auto old_child = parent->ReplaceChildNode(child->GetKeyChar(), std::move(replacement), &old_children);
+    child->WriteUnlockObsolete();
+    parent->WriteUnlock();
+    RetireNode(std::move(old_child));
+    RetireChildren(std::move(old_children));
+  }
 
  public:
   /**
@@ -257,7 +821,27 @@ class Trie {
    * @brief Construct a new Trie object. Initialize the root node with '\0'
    * character.
    */
-  Trie() { root_ = std::make_unique<TrieNode>('\0'); }
+  Trie() : Trie(false) {}
+
+  /**
+   * @brief Construct a new Trie object.
+   * @param use_arena whether to allocate the nodes from an arena owned by the trie rather than with new
+   */
+  explicit Trie(bool use_arena) {
+    if (use_arena) {
+      arena_ = std::make_unique<TrieArena>();
+    }
+    root_ = TrieNode::Make<TrieNode>(arena_.get(), '\0');
+  }
+
+  /**
+   * @brief Destroy the trie. Without values to destroy, a trie on an arena leaves its nodes to the arena release.
+   */
+  ~Trie() {
+    if (arena_ != nullptr && !needs_destroy_.load(std::memory_order_relaxed)) {
+      root_.release();  // NOLINT: the arena frees the nodes
+    }
+  }
 
   /**
    * TODO(P0): Add implementation
@@ -271,59 +855,64 @@ class Trie {
    *
    * When you reach the ending character of a key:
    * 1. If TrieNode with this ending character does not exist, create new TrieNodeWithValue
-   * and add it to parent node's children_ map.
-   * 2. If the terminal node is a TrieNode, then convert it into TrieNodeWithValue by
-   * invoking the appropriate constructor.
+   * and add it to parent node's children.
+   * 2. If the terminal node is a TrieNode, then replace it with a TrieNodeWithValue that takes over its children.
    * 3. If it is already a TrieNodeWithValue,
    * then insertion fails and returns false. Do not overwrite existing data with new data.
    *
-   * You can quickly check whether a TrieNode pointer holds TrieNode or TrieNodeWithValue
-   * by checking the is_end_ flag. If is_end_ == false, then it points to TrieNode. If
-   * is_end_ == true, it points to TrieNodeWithValue.
+   * Only the node that gains a child, or the terminal node and its parent, are write locked.
    *
    * @param key Key used to traverse the trie and find the correct node
-   * @param value Value to be inserted
+   * @param value Value to be inserted. It is moved into the new node, never copied.
    * @return True if insertion succeeds, false if the key already exists
    */
   template <typename T>
-  bool Insert(const std::string &key, T value) {
+  bool Insert(std::string_view key, T value) {
     if (key.empty()) {
       return false;
     }
-    latch_.WLock();
-    // int len = key.size();
-    auto node = &root_;
+    auto guard = epochs_.Pin();
+    Path path;
+    path.reserve(key.size() + 1);
+    return InsertAlong(key, std::move(value), 0, &path);
+  }
 
-    if (key.size() > 1) {
-      for (char ch : key.substr(0, key.size() - 1)) {
-        auto next = node->get()->GetChildNode(ch);
-        if (next == nullptr) {
-          // auto p = std::make_unique<TrieNode>();
-          next = node->get()->InsertChildNode(ch, std::make_unique<TrieNode>(ch));
+  /**
+   * @brief Insert a batch of key-value pairs, as if by Insert() for each of them, for bulk loads.
+   *
+   * The keys are inserted in order under one epoch pin, INSERT_BATCH_CHUNK at a time: the paths of a chunk are
+   * first walked together as by MultiGet(), so the inserts find their nodes in cache. Each insert descends from the
+   * deepest node it shares with the previous key that no other writer changed since rather than from the root,
+   * which saves most of the descent when the keys are sorted.
+   *
+   * @param keys the keys, of which duplicates are inserted once, the first time
+   * @param values the value of each key, moved from if the key is inserted
+   * @param num_keys number of keys and values
+   * @param[out] inserted num_keys flags set to whether each key was inserted, or nullptr
+   * @return number of keys inserted
+   */
+  template <typename T>
+  size_t InsertBatch(const std::string_view *keys, T *values, size_t num_keys, bool *inserted = nullptr) {
+    auto guard = epochs_.Pin();
+    Path path;
+    std::string_view previous;
+    size_t count = 0;
+    for (size_t begin = 0; begin < num_keys; begin += INSERT_BATCH_CHUNK) {
+      const size_t end = std::min(num_keys, begin + INSERT_BATCH_CHUNK);
+      LookUpBatch<T>(keys + begin, end - begin, [](size_t, const TrieNodeWithValue<T> *) {});
+      for (size_t i = begin; i < end; i++) {
+        bool ok = false;
+        if (!keys[i].empty()) {
+          ok = InsertAlong(keys[i], std::move(values[i]), CommonPrefixLength(keys[i], previous), &path);
+          previous = keys[i];
+        }
+        count += ok ? 1 : 0;
+        if (inserted != nullptr) {
+          inserted[i] = ok;
         }
-        node = next;
       }
     }
-
-    char ch = key[key.size() - 1];
-    auto p = node->get()->GetChildNode(ch);
-    bool ret;
-
-    if (p == nullptr) {
-      node->get()->InsertChildNode(ch, std::make_unique<TrieNodeWithValue<T>>(ch, value));
-
-      ret = true;
-    } else if (!p->get()->IsEndNode()) {
-      auto node1 = new TrieNodeWithValue<T>(std::move(*(p->get())), value);
-      p->reset(node1);
-
-      ret = true;
-    } else {
-      ret = false;
-    }
-
-    latch_.WUnlock();
-    return ret;
+    return count;
   }
 
   /**
@@ -335,50 +924,102 @@ class Trie {
    *
    * You should:
    * 1) Find the terminal node for the given key.
-   * 2) If this terminal node does not have any children, remove it from its
-   * parent's children_ map.
-   * 3) Recursively remove nodes that have no children and are not terminal node
-   * of another key.
+   * 2) If this terminal node has children, replace it with a plain TrieNode that takes over the children.
+   * 3) Otherwise unlink the chain of nodes ending at it that are not part of another key from the lowest node that
+   * is. Only the nodes of that chain and the node it hangs from are write locked.
    *
    * @param key Key used to traverse the trie and find the correct node
    * @return True if the key exists and is removed, false otherwise
    *
    */
-  bool Remove(const std::string &key) {
+  bool Remove(std::string_view key) {
     if (key.empty()) {
       return false;
     }
-    latch_.WLock();
-    std::vector<std::unique_ptr<TrieNode> *> storage;
-    std::unique_ptr<TrieNode> *node = &root_;
-    for (char ch : key) {
-      storage.emplace_back(node);
-      std::unique_ptr<TrieNode> *next = node->get()->GetChildNode(ch);
+    auto guard = epochs_.Pin();
+    // path[i] is the node reached by key[0:i] and the version it was read at.
+    std::vector<std::pair<TrieNode *, uint64_t>> path;
+    path.reserve(key.size() + 1);
+    while (true) {
+      path.clear();
+      TrieNode *node = root_.get();
+      uint64_t version;
+      if (!node->ReadLockOrRestart(&version)) {
+        continue;
+      }
+      path.emplace_back(node, version);
+
+      bool restart = false;
+      for (char ch : key) {
+        TrieNode *child = node->GetChildNode(ch);
+        if (child == nullptr) {
+          if (!node->CheckOrRestart(version)) {
+            restart = true;
+            break;
+          }
+          return false;
+        }
+        if (!child->ReadLockOrRestart(&version) || !node->CheckOrRestart(path.back().second)) {
+          restart = true;
+          break;
+        }
+        node = child;
+        path.emplace_back(node, version);
+      }
+      if (restart) {
+        continue;
+      }
 
-      if (next == nullptr) {
-        latch_.WUnlock();
+      if (!node->IsEndNode()) {
+        if (!node->CheckOrRestart(version)) {
+          continue;
+        }
         return false;
       }
 
-      node = next;
-    }
+      size_t last = key.size();
+      TrieNode *parent = path[last - 1].first;
+      if (node->HasChildren()) {
+        if (!parent->UpgradeToWriteLockOrRestart(path[last - 1].second)) {
+          continue;
+        }
+        if (!node->UpgradeToWriteLockOrRestart(version)) {
+          parent->WriteUnlock();
+          continue;
+        }
+        auto plain = TrieNode::Make<TrieNode>(arena_.get(), std::move(*node));
+        plain->SetEndNode(false);
+        ReplaceLocked(parent, node, std::move(plain));
+        return true;
+      }
 
-    if (node->get()->HasChildren()) {
-      // node = node->get()->GetChildNode(key[key.size()-1]);
-      node->get()->SetEndNode(false);
-    } else {
-      for (int i = storage.size() - 1; i >= 0; i--) {
-        std::unique_ptr<TrieNode> *pre = storage[i];
-        if ((i < static_cast<int>(key.size() - 1)) && (node->get()->IsEndNode() || node->get()->HasChildren())) {
-          break;
+      // The chain to unlink hangs from the lowest node that stays: the root, an end node or a node with other
+      // children. Upgrading checks the versions the chain was read at, so it cannot have changed since.
+      size_t anchor = last - 1;
+      while (anchor > 0 && !path[anchor].first->IsEndNode() && path[anchor].first->GetNumChildren() == 1) {
+        anchor--;
+      }
+      size_t locked = anchor;
+      while (locked <= last && path[locked].first->UpgradeToWriteLockOrRestart(path[locked].second)) {
+        locked++;
+      }
+      if (locked <= last) {
+        for (size_t i = anchor; i < locked; i++) {
+          path[i].first->WriteUnlock();
         }
-        pre->get()->RemoveChildNode(key[i]);
-        node = pre;
+        continue;
       }
-    }
 
-    latch_.WUnlock();
-    return true;
+      TrieChildren::Ptr old_children;
+      auto chain = path[anchor].first->RemoveChildNode(key[anchor], &old_children);
+      for (size_t i = anchor + 1; i <= last; i++) {
+        path[i].first->WriteUnlockObsolete();
+      }
+      path[anchor].first->WriteUnlock();
+      RetireNode(std::move(chain));
+      RetireChildren(std::move(old_children));
+      return true;
+    }
   }
 
   /**
@@ -395,39 +1036,275 @@ class Trie {
    * the terminal TrieNode to TrieNodeWithValue<T>. If the casted result
    * is not nullptr, then type T is the correct type.
    *
+   * No latch is taken, see VisitValue() to read a value without copying it.
+   *
    * @param key Key used to traverse the trie and find the correct node
    * @param success Whether GetValue is successful or not
    * @return Value of type T if type matches
    */
   template <typename T>
-  T GetValue(const std::string &key, bool *success) {
-    if (key.empty()) {
-      *success = false;
-      return {};
-    }
-    latch_.RLock();
-    std::unique_ptr<TrieNode> *node = &root_;
-    for (char ch : key) {
-      auto next = node->get()->GetChildNode(ch);
-      if (next == nullptr) {
-        *success = false;
-        latch_.RUnlock();
-        return {};
-      }
-      node = next;
-    }
-
-    T ret;
-    auto p = dynamic_cast<TrieNodeWithValue<T> *>(node->get());
-    if (p != nullptr) {
-      *success = true;
-      ret = p->GetValue();
-    } else {
-      *success = false;
-      ret = {};
+  T GetValue(std::string_view key, bool *success) {
+    auto guard = epochs_.Pin();
+    const TrieNodeWithValue<T> *node = FindValueNode<T>(key);
+    *success = node != nullptr;
+    return node == nullptr ? T{} : node->GetValue();
+  }
+
+  /**
+   * @brief Call visitor with a reference to the value of type T stored at key, without copying it.
+   *
+   * The node holding the value cannot be freed while visitor runs, and values are never modified in place, so the
+   * reference is stable for the whole call. A concurrent Remove or re-Insert of the key does not affect it.
+   * visitor must not modify the trie, nor keep the reference after it returns.
+   *
+   * @param key Key used to traverse the trie and find the correct node
+   * @param visitor callable taking const T &
+   * @return True if the key holds a value of type T and visitor was called, false otherwise
+   */
+  template <typename T, typename F>
+  bool VisitValue(std::string_view key, F &&visitor) {
+    auto guard = epochs_.Pin();
+    const TrieNodeWithValue<T> *node = FindValueNode<T>(key);
+    if (node == nullptr) {
+      return false;
+    }
+    std::forward<F>(visitor)(node->GetValueRef());
+    return true;
+  }
+
+  /**
+   * @brief Get the values of type T of a batch of keys, as if by GetValue() for each of them.
+   *
+   * The keys are looked up under one epoch pin, MULTI_GET_WIDTH at a time with their steps interleaved: each lookup
+   * prefetches the node or child set it reads next and lets the others advance meanwhile, so the cache misses of a
+   * batch overlap instead of adding up.
+   *
+   * @param keys the keys to look up
+   * @param num_keys number of keys
+   * @param[out] values num_keys values, set to the value of each key found and to T{} for the others
+   * @param[out] success num_keys flags, set to whether each key exists and holds a T
+   * @return number of keys found
+   */
+  template <typename T>
+  size_t MultiGet(const std::string_view *keys, size_t num_keys, T *values, bool *success) {
+    auto guard = epochs_.Pin();
+    size_t count = 0;
+    LookUpBatch<T>(keys, num_keys, [&](size_t index, const TrieNodeWithValue<T> *node) {
+      success[index] = node != nullptr;
+      values[index] = node == nullptr ? T{} : node->GetValue();
+      count += node == nullptr ? 0 : 1;
+    });
+    return count;
+  }
+
+  /**
+   * Iterator walks the keys of a Trie in lexicographic order, one node at a time: advancing descends to the next
+   * key from the current one rather than collecting the keys up front, so a scan that stops early only touches the
+   * nodes on the way to the keys it returned.
+   *
+   * The iterator takes no latch and is weakly consistent: it returns every key present for its whole lifetime, none
+   * that was absent, and each key at most once; keys inserted or removed meanwhile may or may not show up. A node
+   * the iterator went through that a writer replaces makes it seek again from the root after its current key.
+   *
+   * An iterator pins the epoch of its trie for its whole lifetime, so the values it returns stay valid for as long as
+   * the iterator lives. Any number of iterators may live at once without blocking other operations, but each holds
+   * back the reclamation of the nodes removed meanwhile, so iterators should still be short-lived.
+   */
+  class Iterator {
+   public:
+    /** @return true once the iterator went past the last key in its range */
+    bool IsEnd() const { return current_ == nullptr; }
+
+    /** @return the current key */
+    const std::string &Key() const { return key_; }
+
+    /**
+     * @return the value of the current key if it is a T, nullptr otherwise. Valid until the iterator is destroyed.
+     */
+    template <typename T>
+    const T *GetValue() const {
+      auto node = dynamic_cast<const TrieNodeWithValue<T> *>(current_);
+      return node == nullptr ? nullptr : &node->GetValueRef();
+    }
+
+    /** @brief Advance to the next key in the range. */
+    Iterator &operator++() {
+      BUSTUB_ASSERT(!IsEnd(), "cannot advance past the end");
+      if (remaining_ == 0) {
+        current_ = nullptr;
+        return *this;
+      }
+      last_key_.assign(key_);
+      if (!Advance(-1)) {
+        Seek(last_key_, true);
+      }
+      CheckBounds();
+      return *this;
     }
-    latch_.RUnlock();
-    return ret;
+
+   private:
+    friend class Trie;
+
+    Iterator(Trie *trie, std::string_view prefix, std::string_view begin, std::string_view end, size_t limit)
+        : guard_(new EpochManager::Guard(trie->epochs_.Pin())),
+          root_(trie->root_.get()),
+          prefix_(prefix),
+          end_(end),
+          remaining_(limit) {
+      if (remaining_ == 0) {
+        return;
+      }
+      Seek(std::string(begin), false);
+      CheckBounds();
+    }
+
+    /** @brief End the iteration once the current key reaches end_, or count it against the limit. */
+    void CheckBounds() {
+      if (current_ == nullptr) {
+        return;
+      }
+      if (!end_.empty() && key_ >= end_) {
+        current_ = nullptr;
+        return;
+      }
+      remaining_--;
+    }
+
+    /**
+     * @brief Position the iterator on the first key at or, if strict, after target, restarting from the root until
+     * no writer interferes.
+     */
+    void Seek(const std::string &target, bool strict) {
+      while (true) {
+        stack_.clear();
+        key_.clear();
+        current_ = nullptr;
+        const TrieNode *node = root_;
+        uint64_t version;
+        if (!node->ReadLockOrRestart(&version)) {
+          continue;
+        }
+        stack_.push_back(node);
+
+        // Follow target as far as it exists.
+        bool restart = false;
+        while (key_.size() < target.size()) {
+          const TrieNode *child = node->GetChildNode(target[key_.size()]);
+          if (child == nullptr) {
+            restart = !node->CheckOrRestart(version);
+            break;
+          }
+          uint64_t child_version;
+          if (!child->ReadLockOrRestart(&child_version) || !node->CheckOrRestart(version)) {
+            restart = true;
+            break;
+          }
+          node = child;
+          version = child_version;
+          stack_.push_back(node);
+          key_.push_back(target[key_.size()]);
+        }
+        if (restart) {
+          continue;
+        }
+
+        if (key_.size() < prefix_.size()) {
+          return;  // nothing under the prefix
+        }
+        if (key_.size() == target.size()) {
+          if (!strict && stack_.size() > 1 && node->IsEndNode()) {
+            current_ = node;
+            return;
+          }
+          if (Advance(-1)) {
+            return;
+          }
+        } else if (Advance(static_cast<unsigned char>(target[key_.size()]))) {
+          return;
+        }
+      }
+    }
+
+    /**
+     * @brief Move to the first end node among the children of the top of the stack with a key char above after,
+     * or their subtrees, climbing up while there is none.
+     * @return false if a writer changed a node on the way, the position is then undefined
+     */
+    bool Advance(int after) {
+      while (true) {
+        const TrieNode *node = stack_.back();
+        uint64_t version;
+        if (!node->ReadLockOrRestart(&version)) {
+          return false;
+        }
+        const TrieNode *child = node->GetNextChild(after);
+        if (!node->CheckOrRestart(version)) {
+          return false;
+        }
+        if (child == nullptr) {
+          if (key_.size() <= prefix_.size()) {
+            current_ = nullptr;
+            return true;
+          }
+          after = static_cast<unsigned char>(key_.back());
+          key_.pop_back();
+          stack_.pop_back();
+          continue;
+        }
+        uint64_t child_version;
+        if (!child->ReadLockOrRestart(&child_version)) {
+          return false;
+        }
+        stack_.push_back(child);
+        key_.push_back(child->GetKeyChar());
+        if (child->IsEndNode()) {
+          current_ = child;
+          return true;
+        }
+        after = -1;
+      }
+    }
+
+    /** Keeps the nodes the iterator can reach, and the values it returned, from being freed. */
+    std::unique_ptr<EpochManager::Guard> guard_;
+    const TrieNode *root_;
+    /** Every key returned starts with prefix_. */
+    std::string prefix_;
+    /** Keys returned are below end_, no upper bound if it is empty. */
+    std::string end_;
+    /** Number of keys the iterator may still return. */
+    size_t remaining_;
+    /** The current key, and the nodes on its path from the root. */
+    std::string key_;
+    std::vector<const TrieNode *> stack_;
+    /** The key before the current one while advancing, where to seek again from if a writer interferes. */
+    std::string last_key_;
+    /** The node of the current key, nullptr at the end. */
+    const TrieNode *current_{nullptr};
+  };
+
+  /**
+   * @brief Iterate over the keys starting with prefix, in lexicographic order.
+   * @param prefix the common prefix of the keys, empty to iterate over every key
+   * @param limit the largest number of keys to return
+   */
+  Iterator ScanPrefix(std::string_view prefix, size_t limit = std::numeric_limits<size_t>::max()) {
+    return Iterator(this, prefix, prefix, {}, limit);
+  }
+
+  /** @brief Iterate over the keys at or after key, in lexicographic order. */
+  Iterator LowerBound(std::string_view key) {
+    return Iterator(this, {}, key, {}, std::numeric_limits<size_t>::max());
+  }
+
+  /**
+   * @brief Iterate over the keys in [begin, end), in lexicographic order.
+   * @param begin the first key of the range
+   * @param end the key after the range, empty for no upper bound
+   * @param limit the largest number of keys to return
+   */
+  Iterator Range(std::string_view begin, std::string_view end, size_t limit = std::numeric_limits<size_t>::max()) {
+    return Iterator(this, {}, begin, end, limit);
   }
 };
 }  // namespace bustub
@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// trie_arena.h
+//
+// Identification: src/include/primer/trie_arena.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>  // NOLINT
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TrieArena is a slab allocator for the nodes and child sets of one Trie.
+ *
+ * Memory is carved out of CHUNK_SIZE aligned chunks in size classes of SIZE_CLASS_GRANULARITY bytes. A freed block
+ * goes on the free list of its class and is handed out again before the chunks grow, and all chunks are released
+ * at once when the arena is destroyed. Since chunks are aligned to their size, Owner() finds the arena of any
+ * block without a per-block header.
+ */
+class TrieArena {
+ public:
+  /** Allocation granularity and alignment of every block. */
+  static constexpr size_t SIZE_CLASS_GRANULARITY = 16;
+  /** Size class 0 means "not from an arena", so the largest class is 255 granules. */
+  static constexpr size_t MAX_BLOCK_SIZE = 255 * SIZE_CLASS_GRANULARITY;
+  /** Size and alignment of a chunk. */
+  static constexpr size_t CHUNK_SIZE = 1 << 16;
+
+  TrieArena() = default;
+  DISALLOW_COPY_AND_MOVE(TrieArena);
+
+  /** @brief Release every chunk. Blocks still handed out become invalid, their destructors are not run. */
+  ~TrieArena();
+
+  /**
+   * @brief Allocate a block of at least size bytes.
+   * @param size number of bytes, at most MAX_BLOCK_SIZE
+   * @param[out] size_class the class of the block, to pass back to Deallocate()
+   * @return the block, nullptr if size is larger than MAX_BLOCK_SIZE
+   */
+  auto Allocate(size_t size, uint8_t *size_class) -> void *;
+
+  /** @brief Return a block to the free list of its size class. */
+  void Deallocate(void *block, uint8_t size_class);
+
+  /** @return the arena that handed out block */
+  static auto Owner(const void *block) -> TrieArena * {
+    return reinterpret_cast<const Chunk *>(reinterpret_cast<uintptr_t>(block) & ~(CHUNK_SIZE - 1))->arena_;
+  }
+
+  /** @return number of bytes held in chunks. */
+  auto GetReservedBytes() -> size_t;
+
+ private:
+  /** Header at the start of every chunk. */
+  struct alignas(SIZE_CLASS_GRANULARITY) Chunk {
+    TrieArena *arena_;
+    Chunk *next_;
+  };
+  /** A block on a free list. */
+  struct FreeBlock {
+    FreeBlock *next_;
+  };
+
+  /** Serializes allocation, writers of a trie allocate concurrently. */
+  std::mutex latch_;
+  /** Free list head of each size class. */
+  FreeBlock *free_lists_[256]{};
+  /** The chunks, newest first. Blocks are bumped out of the newest. */
+  Chunk *chunks_{nullptr};
+  /** Next unused byte of the newest chunk, and its end. */
+  char *cursor_{nullptr};
+  char *end_{nullptr};
+  size_t num_chunks_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,336 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// trie_children.h
+//
+// Identification: src/include/primer/trie_children.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "common/macros.h"
+#include "primer/trie_arena.h"
+
+namespace bustub {
+
+class TrieNode;
+
+/**
+ * BasicTrieChildren is the child set of a trie node with two or more children, laid out like the inner nodes of an
+ * adaptive radix tree: up to 4 or 16 sorted key chars next to their children, a 256 entry index into 48 children,
+ * or 256 children addressed by key char directly. A set is immutable once built; a writer builds a new set in the
+ * smallest layout that fits and swaps it in. Sets of a node allocated from a TrieArena come from the same arena.
+ *
+ * Key chars are ordered as unsigned char, the order std::string compares in. The set only points at its children,
+ * which are of the node type Node of the trie using it; TrieChildren is the child set of a TrieNode.
+ */
+template <typename Node>
+class BasicTrieChildren {
+ public:
+  /** A key char and its child node. */
+  using Entry = std::pair<char, Node *>;
+
+  enum class Kind : uint8_t { Node4 = 0, Node16, Node48, Node256 };
+
+  /** Number of distinct key chars. */
+  static constexpr size_t MAX_CHILDREN = 256;
+
+  struct Deleter {
+    void operator()(const BasicTrieChildren *children) const { Destroy(children); }
+  };
+  using Ptr = std::unique_ptr<const BasicTrieChildren, Deleter>;
+
+  /**
+   * @brief Build a child set.
+   * @param entries the children sorted by key char, with distinct key chars
+   * @param count number of entries, 2 to 256
+   * @param arena the arena to allocate from, nullptr for the heap
+   */
+  static auto Build(const Entry *entries, size_t count, TrieArena *arena = nullptr) -> BasicTrieChildren *;
+
+  /** @brief Free a set made by Build(), heap or arena alike. The children themselves are not freed. */
+  static void Destroy(const BasicTrieChildren *children);
+
+  /** @return the child with the given key char, nullptr if there is none */
+  auto Find(char key_char) const -> Node *;
+
+  /**
+   * @return the child with the smallest key char above after, compared as unsigned char, nullptr if there is none
+   * @param after a key char as unsigned char, -1 for the first child
+   */
+  auto FindNext(int after) const -> Node *;
+
+  /** @brief Call f(Entry) for every child in key char order. */
+  template <typename F>
+  void ForEach(F &&f) const;
+
+  auto Size() const -> size_t { return size_; }
+
+  auto GetKind() const -> Kind { return kind_; }
+
+  DISALLOW_COPY_AND_MOVE(BasicTrieChildren);
+
+ private:
+  static constexpr size_t NODE4_CAPACITY = 4;
+  static constexpr size_t NODE16_CAPACITY = 16;
+  static constexpr size_t NODE48_CAPACITY = 48;
+
+  /** Node4 and Node16: the key chars sorted, each next to its child at the same position. */
+  template <size_t N>
+  struct Sorted;
+  /** Node48: index_[key char] is one past the position of the child, 0 if there is none. */
+  struct Indexed;
+  /** Node256: one slot per key char. */
+  struct Direct;
+
+  BasicTrieChildren(Kind kind, size_t size) : kind_(kind), size_(static_cast<uint16_t>(size)) {}
+  ~BasicTrieChildren() = default;
+
+  static auto KeyIndex(char key_char) -> uint8_t { return static_cast<uint8_t>(key_char); }
+
+  template <typename N>
+  static auto New(TrieArena *arena, const Entry *entries, size_t count) -> BasicTrieChildren *;
+
+  template <typename N>
+  static void Free(const N *children);
+
+  Kind kind_;
+  /** TrieArena size class of this set, 0 if it was allocated with new. */
+  uint8_t alloc_class_{0};
+  uint16_t size_;
+};
+
+using TrieChildren = BasicTrieChildren<TrieNode>;
+
+template <typename Node>
+template <size_t N>
+struct BasicTrieChildren<Node>::Sorted : BasicTrieChildren {
+  Sorted(const Entry *entries, size_t count)
+      : BasicTrieChildren(N == NODE4_CAPACITY ? Kind::Node4 : Kind::Node16, count) {
+    for (size_t i = 0; i < count; i++) {
+      keys_[i] = KeyIndex(entries[i].first);
+      children_[i] = entries[i].second;
+    }
+  }
+
+  auto Find(uint8_t key) const -> Node * {
+#ifdef __SSE2__
+    if constexpr (N == NODE16_CAPACITY) {
+      const __m128i needle = _mm_set1_epi8(static_cast<char>(key));
+      const __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys_));
+      auto matches = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(keys, needle)));
+      matches &= (1U << size_) - 1;
+      return matches == 0 ? nullptr : children_[__builtin_ctz(matches)];
+    }
+#endif
+    for (size_t i = 0; i < size_; i++) {
+      if (keys_[i] == key) {
+        return children_[i];
+      }
+    }
+    return nullptr;
+  }
+
+  auto FindNext(int after) const -> Node * {
+    for (size_t i = 0; i < size_; i++) {
+      if (keys_[i] > after) {
+        return children_[i];
+      }
+    }
+    return nullptr;
+  }
+
+  /** Unused key slots stay zero, the SIMD search reads all N of them. */
+  uint8_t keys_[N]{};
+  Node *children_[N];
+};
+
+template <typename Node>
+struct BasicTrieChildren<Node>::Indexed : BasicTrieChildren {
+  Indexed(const Entry *entries, size_t count) : BasicTrieChildren(Kind::Node48, count) {
+    for (size_t i = 0; i < count; i++) {
+      index_[KeyIndex(entries[i].first)] = static_cast<uint8_t>(i + 1);
+      children_[i] = entries[i].second;
+    }
+  }
+
+  uint8_t index_[MAX_CHILDREN]{};
+  Node *children_[NODE48_CAPACITY];
+};
+
+template <typename Node>
+struct BasicTrieChildren<Node>::Direct : BasicTrieChildren {
+  Direct(const Entry *entries, size_t count) : BasicTrieChildren(Kind::Node256, count) {
+    for (size_t i = 0; i < count; i++) {
+      children_[KeyIndex(entries[i].first)] = entries[i].second;
+    }
+  }
+
+  Node *children_[MAX_CHILDREN]{};
+};
+
+template <typename Node>
+template <typename N>
+auto BasicTrieChildren<Node>::New(TrieArena *arena, const Entry *entries, size_t count) -> BasicTrieChildren * {
+  uint8_t size_class;
+  void *block = arena == nullptr ? nullptr : arena->Allocate(sizeof(N), &size_class);
+  if (block == nullptr) {
+    return new N(entries, count);
+  }
+  auto *children = new (block) N(entries, count);
+  children->alloc_class_ = size_class;
+  return children;
+}
+
+template <typename Node>
+template <typename N>
+void BasicTrieChildren<Node>::Free(const N *children) {
+  if (children->alloc_class_ == 0) {
+    delete children;
+    return;
+  }
+  const uint8_t size_class = children->alloc_class_;
+  children->~N();
+  TrieArena::Owner(children)->Deallocate(const_cast<N *>(children), size_class);
+}
+
+template <typename Node>
+auto BasicTrieChildren<Node>::Build(const Entry *entries, size_t count, TrieArena *arena) -> BasicTrieChildren * {
+  BUSTUB_ASSERT(count >= 2 && count <= MAX_CHILDREN, "a child set holds 2 to 256 children");
+  if (count <= NODE4_CAPACITY) {
+    return New<Sorted<NODE4_CAPACITY>>(arena, entries, count);
+  }
+  if (count <= NODE16_CAPACITY) {
+    return New<Sorted<NODE16_CAPACITY>>(arena, entries, count);
+  }
+  if (count <= NODE48_CAPACITY) {
+    return New<Indexed>(arena, entries, count);
+  }
+  return New<Direct>(arena, entries, count);
+}
+
+template <typename Node>
+void BasicTrieChildren<Node>::Destroy(const BasicTrieChildren *children) {
+  if (children == nullptr) {
+    return;
+  }
+  switch (children->kind_) {
+    case Kind::Node4:
+      Free(static_cast<const Sorted<NODE4_CAPACITY> *>(children));
+      break;
+    case Kind::Node16:
+      Free(static_cast<const Sorted<NODE16_CAPACITY> *>(children));
+      break;
+    case Kind::Node48:
+      Free(static_cast<const Indexed *>(children));
+      break;
+    case Kind::Node256:
+      Free(static_cast<const Direct *>(children));
+      break;
+  }
+}
+
+template <typename Node>
+auto BasicTrieChildren<Node>::Find(char key_char) const -> Node * {
+  const uint8_t key = KeyIndex(key_char);
+  switch (kind_) {
+    case Kind::Node4:
+      return static_cast<const Sorted<NODE4_CAPACITY> *>(this)->Find(key);
+    case Kind::Node16:
+      return static_cast<const Sorted<NODE16_CAPACITY> *>(this)->Find(key);
+    case Kind::Node48: {
+      const auto *node = static_cast<const Indexed *>(this);
+      const uint8_t slot = node->index_[key];
+      return slot == 0 ? nullptr : node->children_[slot - 1];
+    }
+    case Kind::Node256:
+      return static_cast<const Direct *>(this)->children_[key];
+  }
+  return nullptr;
+}
+
+template <typename Node>
+auto BasicTrieChildren<Node>::FindNext(int after) const -> Node * {
+  switch (kind_) {
+    case Kind::Node4:
+      return static_cast<const Sorted<NODE4_CAPACITY> *>(this)->FindNext(after);
+    case Kind::Node16:
+      return static_cast<const Sorted<NODE16_CAPACITY> *>(this)->FindNext(after);
+    case Kind::Node48: {
+      const auto *node = static_cast<const Indexed *>(this);
+      for (auto key = static_cast<size_t>(after + 1); key < MAX_CHILDREN; key++) {
+        if (node->index_[key] != 0) {
+          return node->children_[node->index_[key] - 1];
+        }
+      }
+      return nullptr;
+    }
+    case Kind::Node256: {
+      const auto *node = static_cast<const Direct *>(this);
+      for (auto key = static_cast<size_t>(after + 1); key < MAX_CHILDREN; key++) {
+        if (node->children_[key] != nullptr) {
+          return node->children_[key];
+        }
+      }
+      return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+template <typename Node>
+template <typename F>
+void BasicTrieChildren<Node>::ForEach(F &&f) const {
+  switch (kind_) {
+    case Kind::Node4:
+    case Kind::Node16: {
+      const uint8_t *keys;
+      Node *const *children;
+      if (kind_ == Kind::Node4) {
+        keys = static_cast<const Sorted<NODE4_CAPACITY> *>(this)->keys_;
+        children = static_cast<const Sorted<NODE4_CAPACITY> *>(this)->children_;
+      } else {
+        keys = static_cast<const Sorted<NODE16_CAPACITY> *>(this)->keys_;
+        children = static_cast<const Sorted<NODE16_CAPACITY> *>(this)->children_;
+      }
+      for (size_t i = 0; i < size_; i++) {
+        f(Entry{static_cast<char>(keys[i]), children[i]});
+      }
+      break;
+    }
+    case Kind::Node48: {
+      const auto *node = static_cast<const Indexed *>(this);
+      for (size_t key = 0; key < MAX_CHILDREN; key++) {
+        if (node->index_[key] != 0) {
+          f(Entry{static_cast<char>(key), node->children_[node->index_[key] - 1]});
+        }
+      }
+      break;
+    }
+    case Kind::Node256: {
+      const auto *node = static_cast<const Direct *>(this);
+      for (size_t key = 0; key < MAX_CHILDREN; key++) {
+        if (node->children_[key] != nullptr) {
+          f(Entry{static_cast<char>(key), node->children_[key]});
+        }
+      }
+      break;
+    }
+  }
+}
+
+}  // namespace bustub
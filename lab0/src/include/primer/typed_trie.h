@@ -0,0 +1,349 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// typed_trie.h
+//
+// Identification: src/include/primer/typed_trie.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "common/epoch_manager.h"
+#include "common/macros.h"
+#include "primer/trie_children.h"
+
+namespace bustub {
+
+template <typename T>
+class TypedTrie;
+
+/**
+ * TypedTrieNode is a node of a TypedTrie<T>. Its value, if it has one, is stored inline like in a std::optional<T>,
+ * and the node has no virtual functions, so a node is its children word, its key char and the value.
+ *
+ * A node never changes once readers can reach it, except for its children word: a single child is stored inline,
+ * more children live in an immutable BasicTrieChildren set, and writers swap in a new word. A node that gains or
+ * loses its value is replaced by a copy that shares its children.
+ */
+template <typename T>
+class TypedTrieNode {
+ public:
+  using Children = BasicTrieChildren<TypedTrieNode>;
+
+  explicit TypedTrieNode(char key_char) : key_char_(key_char) {}
+
+  TypedTrieNode(char key_char, T value) : key_char_(key_char), has_value_(true) {
+    new (&value_) T(std::move(value));
+  }
+
+  /** @brief Destroy the node alone. Its children are owned by the trie, see TypedTrie::DestroyTree(). */
+  ~TypedTrieNode() {
+    if (has_value_) {
+      value_.~T();
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(TypedTrieNode);
+
+  auto GetKeyChar() const -> char { return key_char_; }
+
+  /** @return whether a key ends at this node */
+  auto HasValue() const -> bool { return has_value_; }
+
+  /** @return the value of the key ending at this node, which must have one */
+  auto GetValue() const -> const T & {
+    BUSTUB_ASSERT(has_value_, "the node holds no value");
+    return value_;
+  }
+
+  auto HasChildren() const -> bool { return children_.load(std::memory_order_acquire) != 0; }
+
+  auto GetNumChildren() const -> size_t {
+    const uintptr_t children = children_.load(std::memory_order_acquire);
+    if (children == 0) {
+      return 0;
+    }
+    return AsSet(children) == nullptr ? 1 : AsSet(children)->Size();
+  }
+
+  /** @return the child with the given key char, nullptr if there is none */
+  auto GetChildNode(char key_char) const -> TypedTrieNode * {
+    const uintptr_t children = children_.load(std::memory_order_acquire);
+    if ((children & SINGLE_CHILD) != 0) {
+      auto *child = reinterpret_cast<TypedTrieNode *>(children & ~SINGLE_CHILD);
+      return child->key_char_ == key_char ? child : nullptr;
+    }
+    return children == 0 ? nullptr : AsSet(children)->Find(key_char);
+  }
+
+ private:
+  friend class TypedTrie<T>;
+
+  /** Tag of a children word that holds a single child inline. */
+  static constexpr uintptr_t SINGLE_CHILD = 1;
+
+  /** @brief Construct a replacement for other that shares its children, without a value. */
+  TypedTrieNode(const TypedTrieNode &other, uintptr_t children) : key_char_(other.key_char_) {
+    children_.store(children, std::memory_order_relaxed);
+  }
+
+  /** @brief Construct a replacement for other that shares its children, with value. */
+  TypedTrieNode(const TypedTrieNode &other, uintptr_t children, T value)
+      : TypedTrieNode(other.key_char_, std::move(value)) {
+    children_.store(children, std::memory_order_relaxed);
+  }
+
+  static auto AsSet(uintptr_t children) -> const Children * {
+    return (children & SINGLE_CHILD) != 0 ? nullptr : reinterpret_cast<const Children *>(children);
+  }
+
+  template <typename F>
+  static void ForEachChildIn(uintptr_t children, F &&f) {
+    if ((children & SINGLE_CHILD) != 0) {
+      auto *child = reinterpret_cast<TypedTrieNode *>(children & ~SINGLE_CHILD);
+      f(typename Children::Entry{child->key_char_, child});
+    } else if (children != 0) {
+      AsSet(children)->ForEach(f);
+    }
+  }
+
+  /**
+   * @brief Point key_char at child, replacing the child it had, or drop key_char if child is nullptr. The caller
+   * serializes writers; readers see either the old or the new children.
+   * @return the replaced child set, to free once no reader can be using it. nullptr if there was none.
+   */
+  auto SetChild(char key_char, TypedTrieNode *child) -> const Children * {
+    std::array<typename Children::Entry, Children::MAX_CHILDREN> entries;
+    size_t size = 0;
+    const uintptr_t old_children = children_.load(std::memory_order_relaxed);
+    ForEachChildIn(old_children, [&](const typename Children::Entry &entry) { entries[size++] = entry; });
+
+    auto *end = entries.data() + size;
+    auto *it = std::lower_bound(entries.data(), end, key_char, [](const typename Children::Entry &entry, char key) {
+      return static_cast<unsigned char>(entry.first) < static_cast<unsigned char>(key);
+    });
+    const bool found = it != end && it->first == key_char;
+    if (child == nullptr) {
+      if (found) {
+        std::move(it + 1, end, it);
+        size--;
+      }
+    } else if (found) {
+      it->second = child;
+    } else {
+      std::move_backward(it, end, end + 1);
+      *it = {key_char, child};
+      size++;
+    }
+
+    uintptr_t children = 0;
+    if (size == 1) {
+      children = reinterpret_cast<uintptr_t>(entries[0].second) | SINGLE_CHILD;
+    } else if (size > 1) {
+      children = reinterpret_cast<uintptr_t>(Children::Build(entries.data(), size));
+    }
+    children_.store(children, std::memory_order_release);
+    return AsSet(old_children);
+  }
+
+  /** 0 if the node has no children, the only child tagged with SINGLE_CHILD, or a Children set. */
+  std::atomic<uintptr_t> children_{0};
+  char key_char_;
+  bool has_value_{false};
+  /** Constructed if and only if has_value_. Never modified, so readers may use it without a latch. */
+  union {
+    T value_;
+  };
+};
+
+/**
+ * TypedTrie is a concurrent key-value store like Trie whose values all have the type T.
+ *
+ * Since the value type is known at compile time, a value lives inline in its node, lookups check a flag where Trie
+ * needs a dynamic_cast, and nodes carry neither a vtable pointer nor an is_end_ flag beside the value. Use Trie when
+ * one trie must hold values of several types.
+ *
+ * Lookups take no latches and never restart: nodes change only by swapping their children word, so a lookup sees
+ * each node it walks as it was at some point during the lookup. Writers are serialized by a latch. Nodes and child
+ * sets replaced or unlinked by a writer are retired to an epoch manager and deleted once readers are done with them.
+ */
+template <typename T>
+class TypedTrie {
+ public:
+  using Node = TypedTrieNode<T>;
+
+  TypedTrie() : root_(new Node('\0')) {}
+
+  ~TypedTrie() { DestroyTree(root_); }
+
+  DISALLOW_COPY_AND_MOVE(TypedTrie);
+
+  /**
+   * @brief Insert key-value pair into the trie. Fails if the key is empty or already exists, an existing value is
+   * never overwritten.
+   * @param value Value to be inserted. It is moved into the new node, never copied.
+   * @return True if insertion succeeds, false otherwise
+   */
+  auto Insert(std::string_view key, T value) -> bool {
+    if (key.empty()) {
+      return false;
+    }
+    std::scoped_lock lock(write_latch_);
+    Node *parent = root_;
+    size_t depth = 0;
+    Node *node = parent->GetChildNode(key[0]);
+    while (node != nullptr && depth + 1 < key.size()) {
+      parent = node;
+      node = parent->GetChildNode(key[++depth]);
+    }
+
+    if (node == nullptr) {
+      RetireChildren(parent->SetChild(key[depth], MakeChain(key, depth, std::move(value))));
+      return true;
+    }
+    if (node->HasValue()) {
+      return false;
+    }
+    Replace(parent, node, new Node(*node, node->children_.load(std::memory_order_relaxed), std::move(value)));
+    return true;
+  }
+
+  /**
+   * @brief Remove key from the trie, along with the nodes no other key needs.
+   * @return True if the key exists and is removed, false otherwise
+   */
+  auto Remove(std::string_view key) -> bool {
+    if (key.empty()) {
+      return false;
+    }
+    std::scoped_lock lock(write_latch_);
+    // path[i] is the node reached by key[0:i].
+    std::vector<Node *> path{root_};
+    path.reserve(key.size() + 1);
+    for (char ch : key) {
+      Node *child = path.back()->GetChildNode(ch);
+      if (child == nullptr) {
+        return false;
+      }
+      path.push_back(child);
+    }
+    Node *node = path.back();
+    if (!node->HasValue()) {
+      return false;
+    }
+
+    const size_t last = key.size();
+    if (node->HasChildren()) {
+      Replace(path[last - 1], node, new Node(*node, node->children_.load(std::memory_order_relaxed)));
+      return true;
+    }
+    // Unlink the chain of nodes only this key needs from the lowest node that stays.
+    size_t anchor = last - 1;
+    while (anchor > 0 && !path[anchor]->HasValue() && path[anchor]->GetNumChildren() == 1) {
+      anchor--;
+    }
+    RetireChildren(path[anchor]->SetChild(key[anchor], nullptr));
+    epochs_.Retire(path[anchor + 1], [](void *chain) { DestroyTree(static_cast<Node *>(chain)); });
+    return true;
+  }
+
+  /**
+   * @brief Get the value stored at key. Takes no latch.
+   * @param key Key used to traverse the trie and find the correct node
+   * @param success set to whether key exists
+   * @return the value, a default constructed T if success is false
+   */
+  auto GetValue(std::string_view key, bool *success) -> T {
+    auto guard = epochs_.Pin();
+    const Node *node = FindValueNode(key);
+    *success = node != nullptr;
+    return node == nullptr ? T{} : node->GetValue();
+  }
+
+  /**
+   * @brief Call visitor with a reference to the value stored at key, without copying it. The value cannot be freed
+   * nor modified while visitor runs; visitor must not modify the trie, nor keep the reference after it returns.
+   * @return True if the key exists and visitor was called, false otherwise
+   */
+  template <typename F>
+  auto VisitValue(std::string_view key, F &&visitor) -> bool {
+    auto guard = epochs_.Pin();
+    const Node *node = FindValueNode(key);
+    if (node == nullptr) {
+      return false;
+    }
+    std::forward<F>(visitor)(node->GetValue());
+    return true;
+  }
+
+ private:
+  /** @return the node holding the value of key, nullptr if there is none. The caller must be pinned. */
+  auto FindValueNode(std::string_view key) const -> const Node * {
+    if (key.empty()) {
+      return nullptr;
+    }
+    const Node *node = root_;
+    for (char ch : key) {
+      node = node->GetChildNode(ch);
+      if (node == nullptr) {
+        return nullptr;
+      }
+    }
+    return node->HasValue() ? node : nullptr;
+  }
+
+  /** @brief Build the chain of nodes for key[depth:], ending in a node holding value. */
+  static auto MakeChain(std::string_view key, size_t depth, T &&value) -> Node * {
+    Node *chain = new Node(key.back(), std::move(value));
+    for (size_t i = key.size() - 1; i > depth; i--) {
+      auto *parent = new Node(key[i - 1]);
+      parent->SetChild(key[i], chain);
+      chain = parent;
+    }
+    return chain;
+  }
+
+  /** @brief Replace child of parent with replacement, which took over its children. */
+  void Replace(Node *parent, Node *child, Node *replacement) {
+    RetireChildren(parent->SetChild(child->GetKeyChar(), replacement));
+    epochs_.Retire(child);
+  }
+
+  void RetireChildren(const typename Node::Children *children) {
+    if (children != nullptr) {
+      epochs_.Retire(const_cast<typename Node::Children *>(children),
+                     [](void *set) { Node::Children::Destroy(static_cast<typename Node::Children *>(set)); });
+    }
+  }
+
+  /** @brief Delete node with its child sets and every node below it. */
+  static void DestroyTree(Node *node) {
+    const uintptr_t children = node->children_.load(std::memory_order_relaxed);
+    Node::ForEachChildIn(children, [](const typename Node::Children::Entry &child) { DestroyTree(child.second); });
+    Node::Children::Destroy(Node::AsSet(children));
+    delete node;
+  }
+
+  /** Root node of the trie. It never holds a value and is never replaced. */
+  Node *root_;
+  /** Serializes writers */
+  std::mutex write_latch_;
+  /** Defers deleting replaced nodes and child sets until the readers that may be walking them are done */
+  EpochManager epochs_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mapped_trie.cpp
+//
+// Identification: src/primer/mapped_trie.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "primer/mapped_trie.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bustub {
+
+TrieFileBuilder::TrieFileBuilder(const std::string &path, uint32_t value_size)
+    : out_(path, std::ios::binary | std::ios::trunc), value_size_(value_size) {
+  if (!out_.is_open()) {
+    throw Exception(ExceptionType::INVALID, "cannot create trie file " + path);
+  }
+  // The header is rewritten with its final contents by Finish().
+  TrieFileFormat::Header header{};
+  Append(&header, sizeof(header));
+  stack_.emplace_back();
+}
+
+void TrieFileBuilder::Add(std::string_view key, std::string_view value) {
+  BUSTUB_ASSERT(!finished_, "the file is finished");
+  BUSTUB_ASSERT(!key.empty() && (num_keys_ == 0 || key > last_key_), "keys must be non-empty and ascending");
+  BUSTUB_ASSERT(value_size_ == TrieFileFormat::STRING_VALUE || value.size() == value_size_, "wrong value size");
+
+  size_t common = 0;
+  while (common < key.size() && common < last_key_.size() && key[common] == last_key_[common]) {
+    common++;
+  }
+  while (stack_.size() > common + 1) {
+    CloseNode();
+  }
+  while (stack_.size() < key.size() + 1) {
+    stack_.emplace_back();
+  }
+
+  if (value_size_ == TrieFileFormat::STRING_VALUE) {
+    const auto length = static_cast<uint32_t>(value.size());
+    std::string record(reinterpret_cast<const char *>(&length), sizeof(length));
+    record.append(value);
+    stack_.back().value_word_ = Append(record.data(), record.size());
+  } else {
+    stack_.back().value_word_ = Append(value.data(), value.size());
+  }
+  last_key_.assign(key);
+  num_keys_++;
+}
+
+void TrieFileBuilder::Finish() {
+  BUSTUB_ASSERT(!finished_, "the file is finished");
+  while (stack_.size() > 1) {
+    CloseNode();
+  }
+  // Park the root under a dummy parent so it is written like any other node; its key char is never read.
+  last_key_.push_back('\0');
+  stack_.emplace(stack_.begin());
+  CloseNode();
+
+  TrieFileFormat::Header header{};
+  header.magic_ = TrieFileFormat::MAGIC;
+  header.version_ = TrieFileFormat::VERSION;
+  header.value_size_ = value_size_;
+  header.num_keys_ = num_keys_;
+  header.file_size_ = size_;
+  header.root_word_ = stack_.back().children_.back().second;
+  out_.seekp(0);
+  out_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out_.close();
+  if (out_.fail()) {
+    throw Exception(ExceptionType::INVALID, "cannot write trie file");
+  }
+  finished_ = true;
+}
+
+void TrieFileBuilder::CloseNode() {
+  OpenNode node = std::move(stack_.back());
+  stack_.pop_back();
+  const auto n = static_cast<uint32_t>(node.children_.size());
+  std::string record(2 * sizeof(uint32_t), '\0');
+  std::memcpy(record.data(), &node.value_word_, sizeof(uint32_t));
+  std::memcpy(record.data() + sizeof(uint32_t), &n, sizeof(uint32_t));
+  for (const auto &child : node.children_) {
+    record.push_back(child.first);
+  }
+  record.resize((record.size() + TrieFileFormat::WORD_SIZE - 1) / TrieFileFormat::WORD_SIZE *
+                TrieFileFormat::WORD_SIZE);
+  for (const auto &child : node.children_) {
+    record.append(reinterpret_cast<const char *>(&child.second), sizeof(uint32_t));
+  }
+  // Children were closed in key order, so the parent learns about them sorted.
+  stack_.back().children_.emplace_back(last_key_[stack_.size() - 1], Append(record.data(), record.size()));
+}
+
+auto TrieFileBuilder::Append(const void *data, size_t size) -> uint32_t {
+  BUSTUB_ENSURE(size_ / TrieFileFormat::WORD_SIZE < UINT32_MAX, "trie file exceeds the addressable size");
+  const auto word = static_cast<uint32_t>(size_ / TrieFileFormat::WORD_SIZE);
+  out_.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+  static constexpr char PADDING[TrieFileFormat::WORD_SIZE] = {};
+  const size_t padding = (TrieFileFormat::WORD_SIZE - size % TrieFileFormat::WORD_SIZE) % TrieFileFormat::WORD_SIZE;
+  out_.write(PADDING, static_cast<std::streamsize>(padding));
+  size_ += size + padding;
+  return word;
+}
+
+MappedTrie::MappedTrie(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw Exception(ExceptionType::INVALID, "cannot open trie file " + path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TrieFileFormat::Header)) {
+    close(fd);
+    throw Exception(ExceptionType::INVALID, "not a trie file: " + path);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  void *data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    throw Exception(ExceptionType::INVALID, "cannot map trie file " + path);
+  }
+  data_ = static_cast<const char *>(data);
+  header_ = reinterpret_cast<const TrieFileFormat::Header *>(data_);
+  if (header_->magic_ != TrieFileFormat::MAGIC || header_->version_ != TrieFileFormat::VERSION ||
+      header_->file_size_ != size_ || static_cast<size_t>(header_->root_word_) * TrieFileFormat::WORD_SIZE >= size_) {
+    munmap(data, size_);
+    throw Exception(ExceptionType::INVALID, "not a trie file: " + path);
+  }
+}
+
+MappedTrie::~MappedTrie() { munmap(const_cast<char *>(data_), size_); }
+
+}  // namespace bustub
@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// trie_arena.cpp
+//
+// Identification: src/primer/trie_arena.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "primer/trie_arena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace bustub {
+
+TrieArena::~TrieArena() {
+  while (chunks_ != nullptr) {
+    Chunk *next = chunks_->next_;
+    std::free(chunks_);
+    chunks_ = next;
+  }
+}
+
+auto TrieArena::Allocate(size_t size, uint8_t *size_class) -> void * {
+  if (size > MAX_BLOCK_SIZE) {
+    return nullptr;
+  }
+  const size_t granules = (std::max<size_t>(size, 1) + SIZE_CLASS_GRANULARITY - 1) / SIZE_CLASS_GRANULARITY;
+  *size_class = static_cast<uint8_t>(granules);
+
+  std::scoped_lock lock(latch_);
+  FreeBlock *block = free_lists_[granules];
+  if (block != nullptr) {
+    free_lists_[granules] = block->next_;
+    return block;
+  }
+
+  const size_t block_size = granules * SIZE_CLASS_GRANULARITY;
+  if (static_cast<size_t>(end_ - cursor_) < block_size) {
+    // Whatever is left of the old chunk is less than one block of this class and stays unused.
+    void *memory = std::aligned_alloc(CHUNK_SIZE, CHUNK_SIZE);
+    if (memory == nullptr) {
+      throw std::bad_alloc();
+    }
+    auto *chunk = new (memory) Chunk{this, chunks_};
+    chunks_ = chunk;
+    cursor_ = static_cast<char *>(memory) + sizeof(Chunk);
+    end_ = static_cast<char *>(memory) + CHUNK_SIZE;
+    num_chunks_++;
+  }
+  void *result = cursor_;
+  cursor_ += block_size;
+  return result;
+}
+
+void TrieArena::Deallocate(void *block, uint8_t size_class) {
+  BUSTUB_ASSERT(size_class != 0, "the block was not allocated from an arena");
+  std::scoped_lock lock(latch_);
+  free_lists_[size_class] = new (block) FreeBlock{free_lists_[size_class]};
+}
+
+auto TrieArena::GetReservedBytes() -> size_t {
+  std::scoped_lock lock(latch_);
+  return num_chunks_ * CHUNK_SIZE;
+}
+
+}  // namespace bustub
@@ -0,0 +1,213 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// trie_concurrent_test.cpp
+//
+// Identification: test/primer/trie_concurrent_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "primer/p0_trie.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return a random key of up to max_length characters over a small alphabet, so that keys share prefixes */
+auto RandomKey(std::mt19937 *rng, size_t max_length) -> std::string {
+  std::string key(1 + (*rng)() % max_length, 'a');
+  for (auto &c : key) {
+    c = "abc"[(*rng)() % 3];
+  }
+  return key;
+}
+
+/** @brief Check that a full scan of trie returns exactly the keys and values of model, in order. */
+void ExpectSameKeys(Trie *trie, const std::map<std::string, int> &model) {
+  auto expected = model.begin();
+  for (auto it = trie->LowerBound(""); !it.IsEnd(); ++it, ++expected) {
+    ASSERT_NE(expected, model.end()) << "unexpected key " << it.Key();
+    EXPECT_EQ(it.Key(), expected->first);
+    ASSERT_NE(it.GetValue<int>(), nullptr);
+    EXPECT_EQ(*it.GetValue<int>(), expected->second);
+  }
+  EXPECT_EQ(expected, model.end());
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(TrieConcurrentTest, MatchesMapModel) {
+  for (bool use_arena : {false, true}) {
+    Trie trie(use_arena);
+    std::map<std::string, int> model;
+    std::mt19937 rng(1);
+    for (int i = 0; i < 20000; i++) {
+      const std::string key = RandomKey(&rng, 6);
+      switch (rng() % 3) {
+        case 0: {
+          const int value = static_cast<int>(rng() % 1000);
+          EXPECT_EQ(trie.Insert(key, value), model.emplace(key, value).second);
+          break;
+        }
+        case 1:
+          EXPECT_EQ(trie.Remove(key), model.erase(key) == 1);
+          break;
+        default: {
+          bool success;
+          const int value = trie.GetValue<int>(key, &success);
+          const auto it = model.find(key);
+          ASSERT_EQ(success, it != model.end());
+          if (success) {
+            EXPECT_EQ(value, it->second);
+          }
+        }
+      }
+      if (i % 1000 == 0) {
+        ExpectSameKeys(&trie, model);
+      }
+    }
+    ExpectSameKeys(&trie, model);
+
+    // A value of another type is not found under the key.
+    trie.Insert<std::string>("typed", "value");
+    bool success;
+    trie.GetValue<int>("typed", &success);
+    EXPECT_FALSE(success);
+    EXPECT_EQ(trie.GetValue<std::string>("typed", &success), "value");
+    EXPECT_TRUE(success);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(TrieConcurrentTest, SharedPrefixInsertRemoveLookup) {
+  constexpr int num_writers = 4;
+  constexpr int num_readers = 2;
+  constexpr int num_ops = 20000;
+  Trie trie;
+  // Keys that stay put, on the paths the writers insert below and remove from.
+  const std::vector<std::string> stable = {"a", "ab", "abc", "b", "ba", "c"};
+  for (const auto &key : stable) {
+    ASSERT_TRUE(trie.Insert(key, static_cast<int>(key.size())));
+  }
+
+  std::vector<std::thread> threads;
+  for (int writer = 0; writer < num_writers; writer++) {
+    threads.emplace_back([&trie, writer] {
+      // Every writer owns the keys containing its digit, so it knows exactly which of them exist.
+      std::mt19937 rng(writer);
+      std::set<std::string> mine;
+      for (int i = 0; i < num_ops; i++) {
+        std::string key = RandomKey(&rng, 3);
+        key.insert(rng() % (key.size() + 1), 1, static_cast<char>('0' + writer));
+        switch (rng() % 3) {
+          case 0:
+            EXPECT_EQ(trie.Insert(key, writer), mine.insert(key).second);
+            break;
+          case 1:
+            EXPECT_EQ(trie.Remove(key), mine.erase(key) == 1);
+            break;
+          default: {
+            bool success;
+            const int value = trie.GetValue<int>(key, &success);
+            EXPECT_EQ(success, mine.count(key) == 1);
+            if (success) {
+              EXPECT_EQ(value, writer);
+            }
+          }
+        }
+      }
+    });
+  }
+  for (int reader = 0; reader < num_readers; reader++) {
+    threads.emplace_back([&trie, &stable, reader] {
+      std::mt19937 rng(100 + reader);
+      for (int i = 0; i < num_ops; i++) {
+        const auto &key = stable[rng() % stable.size()];
+        bool success;
+        const int value = trie.GetValue<int>(key, &success);
+        EXPECT_TRUE(success);
+        EXPECT_EQ(value, static_cast<int>(key.size()));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (const auto &key : stable) {
+    bool success;
+    EXPECT_EQ(trie.GetValue<int>(key, &success), static_cast<int>(key.size()));
+    EXPECT_TRUE(success);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(TrieConcurrentTest, IteratorOrderUnderConcurrentWrites) {
+  constexpr int num_writers = 2;
+  constexpr int num_scans = 200;
+  Trie trie;
+  // The keys of even numbers stay for the whole test, writers toggle those of odd numbers and extensions of even ones.
+  std::set<std::string> stable;
+  for (int i = 0; i < 200; i++) {
+    const std::string key = "k" + std::to_string(i * 2);
+    stable.insert(key);
+    ASSERT_TRUE(trie.Insert(key, i * 2));
+  }
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> writers;
+  for (int writer = 0; writer < num_writers; writer++) {
+    writers.emplace_back([&trie, &done, writer] {
+      std::mt19937 rng(writer);
+      while (!done.load()) {
+        // Writers own disjoint numbers, and the keys ending in x extend stable keys, so they share their nodes.
+        const int number = static_cast<int>(rng() % 100) * 2 * num_writers + 2 * writer + 1;
+        const std::string key = "k" + std::to_string(number);
+        if (!trie.Insert(key, number)) {
+          trie.Remove(key);
+        }
+        trie.Insert("k" + std::to_string(number - 1) + "x", number);
+        trie.Remove("k" + std::to_string(number - 1) + "x");
+      }
+    });
+  }
+
+  for (int scan = 0; scan < num_scans; scan++) {
+    std::string previous;
+    size_t stable_seen = 0;
+    for (auto it = trie.LowerBound(""); !it.IsEnd(); ++it) {
+      // Keys come in strictly increasing order, so none is returned twice.
+      EXPECT_LT(previous, it.Key());
+      previous = it.Key();
+      const int *value = it.GetValue<int>();
+      ASSERT_NE(value, nullptr);
+      const std::string number = it.Key().substr(1, it.Key().find('x') - 1);
+      if (it.Key().back() == 'x') {
+        EXPECT_EQ(*value, std::stoi(number) + 1);
+      } else {
+        EXPECT_EQ(*value, std::stoi(number));
+      }
+      stable_seen += stable.count(it.Key());
+    }
+    // Every key present for the whole scan is returned.
+    EXPECT_EQ(stable_seen, stable.size());
+  }
+  done.store(true);
+  for (auto &thread : writers) {
+    thread.join();
+  }
+}
+
+}  // namespace bustub
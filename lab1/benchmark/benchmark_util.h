@@ -0,0 +1,301 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// benchmark_util.h
+//
+// Identification: benchmark/benchmark_util.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace bustub {
+
+/** Key access patterns every benchmark runs, see WorkloadGenerator. */
+enum class Workload { Uniform = 0, Zipfian, Scan, Mixed };
+
+static constexpr Workload ALL_WORKLOADS[] = {Workload::Uniform, Workload::Zipfian, Workload::Scan, Workload::Mixed};
+
+inline auto WorkloadName(Workload workload) -> const char * {
+  switch (workload) {
+    case Workload::Uniform:
+      return "uniform";
+    case Workload::Zipfian:
+      return "zipfian";
+    case Workload::Scan:
+      return "scan";
+    case Workload::Mixed:
+      return "mixed";
+  }
+  return "unknown";
+}
+
+/** What one operation of a workload does to the structure under test. */
+enum class OpType { Read = 0, Write, Scan };
+
+/** One operation: a point read or write of key, or a scan of length keys starting at key. */
+struct Operation {
+  OpType type_;
+  uint64_t key_;
+  size_t length_;
+};
+
+/**
+ * Constants of a Zipfian distribution over [0, n), computed once and shared by the generators of all threads.
+ * Computing zeta(n) is O(n), so it must not be done per thread.
+ */
+class ZipfianDistribution {
+ public:
+  /**
+   * @param num_keys size of the key space
+   * @param theta skew, 0.99 as in YCSB. Key 0 is the hottest, then key 1 and so on.
+   */
+  explicit ZipfianDistribution(uint64_t num_keys, double theta = 0.99)
+      : num_keys_(num_keys), theta_(theta), alpha_(1.0 / (1.0 - theta)) {
+    zeta_n_ = Zeta(num_keys, theta);
+    const double zeta_2 = Zeta(2, theta);
+    eta_ = (1.0 - std::pow(2.0 / static_cast<double>(num_keys), 1.0 - theta)) / (1.0 - zeta_2 / zeta_n_);
+  }
+
+  /**
+   * @brief Draw a key from a uniform variate u in [0, 1), as in Gray et al., "Quickly Generating Billion-Record
+   * Synthetic Databases".
+   */
+  auto KeyOf(double u) const -> uint64_t {
+    const double uz = u * zeta_n_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, theta_)) {
+      return 1;
+    }
+    const auto key = static_cast<uint64_t>(static_cast<double>(num_keys_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return key < num_keys_ ? key : num_keys_ - 1;
+  }
+
+ private:
+  static auto Zeta(uint64_t n, double theta) -> double {
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i), theta);
+    }
+    return sum;
+  }
+
+  uint64_t num_keys_;
+  double theta_;
+  double alpha_;
+  double zeta_n_;
+  double eta_;
+};
+
+/**
+ * WorkloadGenerator produces the operations of one thread. Generators are seeded explicitly, so a run is
+ * reproducible: the same seed and thread index give the same operations.
+ *
+ * - Uniform: point reads of keys drawn uniformly from [0, num_keys).
+ * - Zipfian: point reads of Zipfian keys, the first keys being the hottest.
+ * - Scan: scans of SCAN_LENGTH consecutive keys, each thread sweeping the key space from its own starting point.
+ * - Mixed: 70% Zipfian reads, 20% Zipfian writes and 10% scans starting at uniform keys.
+ */
+class WorkloadGenerator {
+ public:
+  /** Number of keys a scan operation covers. */
+  static constexpr size_t SCAN_LENGTH = 64;
+
+  /**
+   * @param workload the access pattern
+   * @param num_keys size of the key space, the keys of a scan wrap around at its end
+   * @param zipfian distribution of the Zipfian keys, only used by Workload::Zipfian and Workload::Mixed
+   * @param seed seed of this thread's generator
+   */
+  WorkloadGenerator(Workload workload, uint64_t num_keys, const ZipfianDistribution *zipfian, uint64_t seed)
+      : workload_(workload), num_keys_(num_keys), zipfian_(zipfian), rng_(seed), next_scan_(rng_() % num_keys) {}
+
+  auto Next() -> Operation {
+    switch (workload_) {
+      case Workload::Uniform:
+        return {OpType::Read, Uniform(), 1};
+      case Workload::Zipfian:
+        return {OpType::Read, Zipfian(), 1};
+      case Workload::Scan: {
+        const uint64_t start = next_scan_;
+        next_scan_ = (next_scan_ + SCAN_LENGTH) % num_keys_;
+        return {OpType::Scan, start, SCAN_LENGTH};
+      }
+      case Workload::Mixed: {
+        const uint64_t dice = rng_() % 10;
+        if (dice < 7) {
+          return {OpType::Read, Zipfian(), 1};
+        }
+        if (dice < 9) {
+          return {OpType::Write, Zipfian(), 1};
+        }
+        return {OpType::Scan, Uniform(), SCAN_LENGTH};
+      }
+    }
+    return {OpType::Read, 0, 1};
+  }
+
+ private:
+  auto Uniform() -> uint64_t { return rng_() % num_keys_; }
+
+  auto Zipfian() -> uint64_t {
+    // The top 53 bits make a double in [0, 1) without rounding up to 1.
+    return zipfian_->KeyOf(static_cast<double>(rng_() >> 11) * 0x1.0p-53);
+  }
+
+  Workload workload_;
+  uint64_t num_keys_;
+  const ZipfianDistribution *zipfian_;
+  std::mt19937_64 rng_;
+  uint64_t next_scan_;
+};
+
+/**
+ * @brief Generate the operations of every thread up front, so the timed part of a run does not draw random numbers.
+ * @return the operations of thread i at index i, generated with seed + i
+ */
+inline auto GenerateOperations(Workload workload, uint64_t num_keys, const ZipfianDistribution &zipfian,
+                               uint64_t seed, size_t threads, uint64_t ops_per_thread)
+    -> std::vector<std::vector<Operation>> {
+  std::vector<std::vector<Operation>> operations(threads);
+  for (size_t i = 0; i < threads; i++) {
+    WorkloadGenerator generator(workload, num_keys, &zipfian, seed + i);
+    operations[i].reserve(ops_per_thread);
+    for (uint64_t j = 0; j < ops_per_thread; j++) {
+      operations[i].push_back(generator.Next());
+    }
+  }
+  return operations;
+}
+
+/** Command line options shared by the benchmarks. */
+struct BenchmarkOptions {
+  /** Thread counts to run every benchmark with. */
+  std::vector<size_t> threads_{1, 2, 4, 8};
+  /** Operations each thread runs per benchmark. */
+  uint64_t ops_per_thread_{200000};
+  /** Seed of the generators, thread i uses seed + i. */
+  uint64_t seed_{42};
+  /** Only benchmarks whose name contains this are run. */
+  std::string filter_;
+
+  /** @return whether the benchmark called name is selected by --filter */
+  auto Selected(const std::string &name) const -> bool { return name.find(filter_) != std::string::npos; }
+};
+
+/**
+ * @brief Parse --threads=1,2,4, --ops=N, --seed=N and --filter=substring. Unknown arguments print the usage and
+ * exit, so a typo does not silently run the defaults.
+ */
+inline auto ParseBenchmarkOptions(int argc, char **argv) -> BenchmarkOptions {
+  BenchmarkOptions options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    auto value_of = [&arg](const char *flag) -> const char * {
+      const size_t length = std::strlen(flag);
+      return arg.compare(0, length, flag) == 0 ? arg.c_str() + length : nullptr;
+    };
+    if (const char *value = value_of("--threads=")) {
+      options.threads_.clear();
+      const std::string list = value;
+      for (size_t pos = 0; pos < list.size();) {
+        const size_t comma = std::min(list.find(',', pos), list.size());
+        const size_t threads = std::strtoull(list.substr(pos, comma - pos).c_str(), nullptr, 10);
+        options.threads_.push_back(std::max<size_t>(threads, 1));
+        pos = comma + 1;
+      }
+    } else if (const char *value = value_of("--ops=")) {
+      options.ops_per_thread_ = std::strtoull(value, nullptr, 10);
+    } else if (const char *value = value_of("--seed=")) {
+      options.seed_ = std::strtoull(value, nullptr, 10);
+    } else if (const char *value = value_of("--filter=")) {
+      options.filter_ = value;
+    } else {
+      std::fprintf(stderr, "usage: %s [--threads=1,2,4,8] [--ops=N] [--seed=N] [--filter=substring]\n", argv[0]);
+      std::exit(1);
+    }
+  }
+  return options;
+}
+
+/**
+ * @brief Run body(thread_index) on num_threads threads that start together.
+ * @return the wall time in seconds from the start of the threads until the last one finished
+ */
+template <typename Body>
+auto RunThreads(size_t num_threads, const Body &body) -> double {
+  std::atomic<size_t> ready{0};
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      ready.fetch_add(1);
+      while (!go.load()) {
+        std::this_thread::yield();
+      }
+      body(i);
+    });
+  }
+  while (ready.load() != num_threads) {
+    std::this_thread::yield();
+  }
+  const auto start = std::chrono::steady_clock::now();
+  go.store(true);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @brief Print the column headers of ReportBenchmark(). */
+inline void PrintBenchmarkHeader() {
+  std::printf("%-60s %12s %12s  %s\n", "Benchmark", "Time/op", "Throughput", "Counters");
+}
+
+/**
+ * @brief Print one result row, in the spirit of Google Benchmark's console output.
+ * @param name benchmark name, e.g. "BM_LRUK/zipfian/threads:4"
+ * @param threads number of threads that ran
+ * @param ops operations run by all threads together
+ * @param seconds wall time of the run
+ * @param counters extra counters to print, e.g. "hit=0.93"
+ */
+inline void ReportBenchmark(const std::string &name, size_t threads, uint64_t ops, double seconds,
+                            const std::string &counters = "") {
+  const double ns_per_op = seconds * 1e9 * static_cast<double>(threads) / static_cast<double>(ops);
+  const double mops = static_cast<double>(ops) / seconds / 1e6;
+  std::printf("%-60s %9.1f ns %8.3f M/s  %s\n", name.c_str(), ns_per_op, mops, counters.c_str());
+  std::fflush(stdout);
+}
+
+/** @return the name of a benchmark run, "prefix/workload/threads:n" */
+inline auto BenchmarkName(const std::string &prefix, Workload workload, size_t threads) -> std::string {
+  return prefix + "/" + WorkloadName(workload) + "/threads:" + std::to_string(threads);
+}
+
+/** @brief Keep the compiler from optimizing away a result the benchmark does not otherwise use. */
+template <typename T>
+inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}  // namespace bustub
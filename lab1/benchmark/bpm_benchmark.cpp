@@ -0,0 +1,177 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bpm_benchmark.cpp
+//
+// Identification: benchmark/bpm_benchmark.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * MemoryDiskManager keeps the database in memory, so the benchmark measures the buffer pool rather than the disk.
+ * Page I/O still copies a page under a latch, like a disk manager that serializes its file access.
+ */
+class MemoryDiskManager : public DiskManager {
+ public:
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    std::scoped_lock<std::mutex> lock(latch_);
+    const auto index = static_cast<size_t>(page_id);
+    if (pages_.size() <= index) {
+      pages_.resize(index + 1);
+    }
+    if (pages_[index] == nullptr) {
+      pages_[index] = std::make_unique<char[]>(BUSTUB_PAGE_SIZE);
+    }
+    std::memcpy(pages_[index].get(), page_data, BUSTUB_PAGE_SIZE);
+  }
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    std::scoped_lock<std::mutex> lock(latch_);
+    const auto index = static_cast<size_t>(page_id);
+    if (index < pages_.size() && pages_[index] != nullptr) {
+      std::memcpy(page_data, pages_[index].get(), BUSTUB_PAGE_SIZE);
+    } else {
+      std::memset(page_data, 0, BUSTUB_PAGE_SIZE);
+    }
+  }
+
+ private:
+  std::mutex latch_;
+  std::vector<std::unique_ptr<char[]>> pages_;
+};
+
+/** Frames of every buffer pool under test, split evenly over the instances of a parallel one. */
+static constexpr size_t POOL_FRAMES = 1024;
+/** Pages of the database, 8 times the pool so that uniform accesses mostly miss. */
+static constexpr size_t DATABASE_PAGES = 8 * POOL_FRAMES;
+/** Instances of the parallel buffer pool. */
+static constexpr size_t PARALLEL_INSTANCES = 4;
+
+/**
+ * @brief Run one workload against a buffer pool filled with DATABASE_PAGES pages. Reads take a read guard, writes a
+ * write guard and scans fetch with AccessType::Scan.
+ */
+template <typename BufferPool>
+void RunBufferPool(const std::string &prefix, BufferPool *bpm, Workload workload, size_t threads,
+                   const ZipfianDistribution &zipfian, const BenchmarkOptions &options) {
+  std::vector<page_id_t> pages(DATABASE_PAGES);
+  for (auto &page_id : pages) {
+    bpm->NewPage(&page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  const auto operations =
+      GenerateOperations(workload, DATABASE_PAGES, zipfian, options.seed_, threads, options.ops_per_thread_);
+  const BufferPoolStats before = bpm->GetStats();
+
+  std::atomic<uint64_t> total_ops{0};
+  const double seconds = RunThreads(threads, [&](size_t thread_index) {
+    uint64_t ops = 0;
+    for (const Operation &op : operations[thread_index]) {
+      if (op.type_ == OpType::Read) {
+        auto guard = bpm->FetchPageRead(pages[op.key_], AccessType::Lookup);
+        if (guard.IsValid()) {
+          DoNotOptimize(guard.GetData()[0]);
+        }
+      } else if (op.type_ == OpType::Write) {
+        auto guard = bpm->FetchPageWrite(pages[op.key_]);
+        if (guard.IsValid()) {
+          guard.GetDataMut()[0]++;
+        }
+      } else {
+        for (size_t j = 0; j < op.length_; j++) {
+          auto guard = bpm->FetchPageRead(pages[(op.key_ + j) % DATABASE_PAGES], AccessType::Scan);
+          if (guard.IsValid()) {
+            DoNotOptimize(guard.GetData()[0]);
+          }
+        }
+      }
+      ops += op.length_;
+    }
+    total_ops.fetch_add(ops);
+  });
+
+  const BufferPoolStats after = bpm->GetStats();
+  const uint64_t fetches = after.fetches_ - before.fetches_;
+  const double hit_ratio =
+      fetches == 0 ? 0.0 : static_cast<double>(after.fetch_hits_ - before.fetch_hits_) / static_cast<double>(fetches);
+  char counters[160];
+  std::snprintf(counters, sizeof(counters), "hit=%.3f evict=%llu dirty_evict=%llu fail=%llu", hit_ratio,
+                static_cast<unsigned long long>(after.evictions_ - before.evictions_),              // NOLINT
+                static_cast<unsigned long long>(after.dirty_evictions_ - before.dirty_evictions_),  // NOLINT
+                static_cast<unsigned long long>(after.fetch_failures_ - before.fetch_failures_));   // NOLINT
+  ReportBenchmark(BenchmarkName(prefix, workload, threads), threads, total_ops.load(), seconds, counters);
+}
+
+auto ReplacerName(ReplacerType type) -> const char * {
+  switch (type) {
+    case ReplacerType::LRUK:
+      return "LRUK";
+    case ReplacerType::Clock:
+      return "Clock";
+    case ReplacerType::TwoQueue:
+      return "TwoQueue";
+    case ReplacerType::ARC:
+      return "ARC";
+  }
+  return "unknown";
+}
+
+}  // namespace bustub
+
+/**
+ * Buffer pool benchmark: every workload at every thread count, against a BufferPoolManagerInstance with each
+ * replacement policy and against a ParallelBufferPoolManager. Each run starts from a fresh pool. Operations count
+ * pages, so a scan of 64 pages counts as 64 operations.
+ */
+auto main(int argc, char **argv) -> int {
+  using bustub::BenchmarkName;
+  const bustub::BenchmarkOptions options = bustub::ParseBenchmarkOptions(argc, argv);
+  const bustub::ZipfianDistribution zipfian(bustub::DATABASE_PAGES);
+  bustub::PrintBenchmarkHeader();
+
+  for (auto type : {bustub::ReplacerType::LRUK, bustub::ReplacerType::Clock, bustub::ReplacerType::TwoQueue,
+                    bustub::ReplacerType::ARC}) {
+    const std::string prefix = std::string("BM_BufferPool/") + bustub::ReplacerName(type);
+    for (auto workload : bustub::ALL_WORKLOADS) {
+      for (size_t threads : options.threads_) {
+        if (!options.Selected(BenchmarkName(prefix, workload, threads))) {
+          continue;
+        }
+        bustub::MemoryDiskManager disk_manager;
+        bustub::BufferPoolManagerInstance bpm(bustub::POOL_FRAMES, &disk_manager, bustub::LRUK_REPLACER_K, nullptr,
+                                              type);
+        bustub::RunBufferPool(prefix, &bpm, workload, threads, zipfian, options);
+      }
+    }
+  }
+
+  const std::string prefix = "BM_ParallelBufferPool/LRUK";
+  for (auto workload : bustub::ALL_WORKLOADS) {
+    for (size_t threads : options.threads_) {
+      if (!options.Selected(BenchmarkName(prefix, workload, threads))) {
+        continue;
+      }
+      bustub::MemoryDiskManager disk_manager;
+      bustub::ParallelBufferPoolManager bpm(bustub::PARALLEL_INSTANCES,
+                                            bustub::POOL_FRAMES / bustub::PARALLEL_INSTANCES, &disk_manager);
+      bustub::RunBufferPool(prefix, &bpm, workload, threads, zipfian, options);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_benchmark.cpp
+//
+// Identification: benchmark/hash_table_benchmark.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "container/hash/extendible_hash_table.h"
+
+namespace bustub {
+
+/** Keys in the table when a run starts. */
+static constexpr size_t NUM_KEYS = 1 << 20;
+
+/**
+ * @brief Run one workload against an ExtendibleHashTable holding NUM_KEYS keys. Reads are Find(), writes remove the
+ * key and insert it again, so the table keeps its size while splitting and merging, and scans are a FindBatch() of
+ * consecutive keys.
+ */
+void RunHashTable(size_t bucket_size, Workload workload, size_t threads, const ZipfianDistribution &zipfian,
+                  const BenchmarkOptions &options) {
+  ExtendibleHashTable<int, int> table(bucket_size);
+  std::vector<std::pair<int, int>> entries;
+  entries.reserve(NUM_KEYS);
+  for (size_t key = 0; key < NUM_KEYS; key++) {
+    entries.emplace_back(static_cast<int>(key), static_cast<int>(key));
+  }
+  table.Reserve(NUM_KEYS);
+  table.InsertBatch(entries);
+  const auto operations =
+      GenerateOperations(workload, NUM_KEYS, zipfian, options.seed_, threads, options.ops_per_thread_);
+  const ExtendibleHashTableStats before = table.GetStats();
+
+  std::atomic<uint64_t> total_ops{0};
+  const double seconds = RunThreads(threads, [&](size_t thread_index) {
+    std::vector<int> keys(WorkloadGenerator::SCAN_LENGTH);
+    std::vector<int> values;
+    std::vector<bool> found;
+    uint64_t ops = 0;
+    for (const Operation &op : operations[thread_index]) {
+      const auto key = static_cast<int>(op.key_);
+      if (op.type_ == OpType::Read) {
+        int value;
+        DoNotOptimize(table.Find(key, value));
+      } else if (op.type_ == OpType::Write) {
+        table.Remove(key);
+        table.Insert(key, key);
+      } else {
+        keys.resize(op.length_);
+        for (size_t j = 0; j < op.length_; j++) {
+          keys[j] = static_cast<int>((op.key_ + j) % NUM_KEYS);
+        }
+        DoNotOptimize(table.FindBatch(keys, &values, &found));
+      }
+      ops += op.length_;
+    }
+    total_ops.fetch_add(ops);
+  });
+
+  const ExtendibleHashTableStats after = table.GetStats();
+  char counters[160];
+  std::snprintf(counters, sizeof(counters), "splits=%llu merges=%llu retries=%llu depth=%d",
+                static_cast<unsigned long long>(after.splits_ - before.splits_),    // NOLINT
+                static_cast<unsigned long long>(after.merges_ - before.merges_),    // NOLINT
+                static_cast<unsigned long long>(after.latch_retries_ - before.latch_retries_),  // NOLINT
+                after.global_depth_);
+  ReportBenchmark(BenchmarkName("BM_ExtendibleHashTable/bucket:" + std::to_string(bucket_size), workload, threads),
+                  threads, total_ops.load(), seconds, counters);
+}
+
+}  // namespace bustub
+
+/**
+ * Hash table benchmark: every workload at every thread count, against an ExtendibleHashTable<int, int> with the
+ * page table's bucket size of 4 and with larger buckets. Operations count keys, so a scan of 64 keys counts as 64.
+ */
+auto main(int argc, char **argv) -> int {
+  using bustub::BenchmarkName;
+  const bustub::BenchmarkOptions options = bustub::ParseBenchmarkOptions(argc, argv);
+  const bustub::ZipfianDistribution zipfian(bustub::NUM_KEYS);
+  bustub::PrintBenchmarkHeader();
+
+  for (size_t bucket_size : {4, 32}) {
+    for (auto workload : bustub::ALL_WORKLOADS) {
+      for (size_t threads : options.threads_) {
+        const std::string name =
+            BenchmarkName("BM_ExtendibleHashTable/bucket:" + std::to_string(bucket_size), workload, threads);
+        if (options.Selected(name)) {
+          bustub::RunHashTable(bucket_size, workload, threads, zipfian, options);
+        }
+      }
+    }
+  }
+  return 0;
+}
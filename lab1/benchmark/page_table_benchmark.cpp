@@ -0,0 +1,189 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_benchmark.cpp
+//
+// Identification: benchmark/page_table_benchmark.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "container/hash/dense_page_table.h"
+#include "container/hash/extendible_hash_table.h"
+
+namespace bustub {
+
+/** Bucket size of the ExtendibleHashTable page table, the one BufferPoolManagerInstance uses. */
+static constexpr size_t PAGE_TABLE_BUCKET_SIZE = 4;
+
+/** Pages of the database behind the sparse residency runs, far more than any of their pools holds. */
+static constexpr size_t SPARSE_DB_PAGES = 10000000;
+
+/** @return a page table of the given type, sized for num_pages the way BufferPoolManagerInstance sizes it */
+auto MakePageTable(bool dense, size_t num_pages) -> std::unique_ptr<HashTable<page_id_t, frame_id_t>> {
+  if (dense) {
+    return std::make_unique<DensePageTable>(1, 0, num_pages);
+  }
+  auto table = std::make_unique<ExtendibleHashTable<page_id_t, frame_id_t>>(PAGE_TABLE_BUCKET_SIZE);
+  table->Reserve(num_pages);
+  return table;
+}
+
+/**
+ * @brief Load num_pages consecutive page ids into a fresh page table, then run one workload against it. Reads are
+ * Find(), writes remove the page and insert it again as an eviction and refetch would, and scans are Find() on
+ * consecutive page ids.
+ */
+void RunPageTable(bool dense, size_t num_pages, Workload workload, size_t threads, const ZipfianDistribution &zipfian,
+                  const BenchmarkOptions &options) {
+  const std::string prefix =
+      std::string("BM_PageTable/") + (dense ? "Dense" : "ExtendibleHash") + "/pages:" + std::to_string(num_pages);
+  auto table = MakePageTable(dense, num_pages);
+  const auto load_start = std::chrono::steady_clock::now();
+  for (size_t page = 0; page < num_pages; page++) {
+    table->Insert(static_cast<page_id_t>(page), static_cast<frame_id_t>(page));
+  }
+  const double load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+  ReportBenchmark(prefix + "/load", 1, num_pages, load_seconds);
+
+  const auto operations =
+      GenerateOperations(workload, num_pages, zipfian, options.seed_, threads, options.ops_per_thread_);
+  std::atomic<uint64_t> total_ops{0};
+  const double seconds = RunThreads(threads, [&](size_t thread_index) {
+    uint64_t ops = 0;
+    for (const Operation &op : operations[thread_index]) {
+      const auto page_id = static_cast<page_id_t>(op.key_);
+      frame_id_t frame_id;
+      if (op.type_ == OpType::Read) {
+        DoNotOptimize(table->Find(page_id, frame_id));
+      } else if (op.type_ == OpType::Write) {
+        table->Remove(page_id);
+        table->Insert(page_id, static_cast<frame_id_t>(page_id));
+      } else {
+        for (size_t j = 0; j < op.length_; j++) {
+          DoNotOptimize(table->Find(static_cast<page_id_t>((op.key_ + j) % num_pages), frame_id));
+        }
+      }
+      ops += op.length_;
+    }
+    total_ops.fetch_add(ops);
+  });
+  ReportBenchmark(BenchmarkName(prefix, workload, threads), threads, total_ops.load(), seconds);
+
+  const auto drain_start = std::chrono::steady_clock::now();
+  for (size_t page = 0; page < num_pages; page++) {
+    table->Remove(static_cast<page_id_t>(page));
+  }
+  const double drain_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - drain_start).count();
+  ReportBenchmark(prefix + "/drain", 1, num_pages, drain_seconds);
+}
+
+/**
+ * @brief Run one workload over SPARSE_DB_PAGES pages through the page table of a pool of pool_frames frames, the way
+ * a buffer pool uses it when the database is much larger than the pool. Every page a read, write or scan touches is
+ * looked up with Find(); a miss evicts the oldest resident page with Remove() and maps the new one with Insert(), so
+ * the mapped pages spread thinly over the whole id space and keep moving. Misses are serialized on a latch, as they
+ * are under the buffer pool latch.
+ */
+void RunSparsePageTable(bool dense, size_t pool_frames, Workload workload, size_t threads,
+                        const ZipfianDistribution &zipfian, const BenchmarkOptions &options) {
+  const std::string prefix = std::string("BM_PageTable/") + (dense ? "Dense" : "ExtendibleHash") +
+                             "/sparse/pool:" + std::to_string(pool_frames);
+  auto table = MakePageTable(dense, pool_frames);
+  // The resident pages in the order they were mapped, a slot holds INVALID_PAGE_ID until the pool fills up.
+  std::vector<page_id_t> resident(pool_frames, INVALID_PAGE_ID);
+  size_t next_victim = 0;
+  std::mutex latch;
+  const auto operations =
+      GenerateOperations(workload, SPARSE_DB_PAGES, zipfian, options.seed_, threads, options.ops_per_thread_);
+
+  std::atomic<uint64_t> total_ops{0};
+  std::atomic<uint64_t> total_misses{0};
+  const double seconds = RunThreads(threads, [&](size_t thread_index) {
+    uint64_t ops = 0;
+    uint64_t misses = 0;
+    for (const Operation &op : operations[thread_index]) {
+      for (size_t j = 0; j < op.length_; j++) {
+        const auto page_id = static_cast<page_id_t>((op.key_ + j) % SPARSE_DB_PAGES);
+        frame_id_t frame_id;
+        if (table->Find(page_id, frame_id)) {
+          continue;
+        }
+        std::scoped_lock<std::mutex> lock(latch);
+        if (table->Find(page_id, frame_id)) {
+          continue;
+        }
+        misses++;
+        const size_t frame = next_victim;
+        next_victim = (next_victim + 1) % pool_frames;
+        if (resident[frame] != INVALID_PAGE_ID) {
+          table->Remove(resident[frame]);
+        }
+        resident[frame] = page_id;
+        table->Insert(page_id, static_cast<frame_id_t>(frame));
+      }
+      ops += op.length_;
+    }
+    total_ops.fetch_add(ops);
+    total_misses.fetch_add(misses);
+  });
+  char counters[64];
+  std::snprintf(counters, sizeof(counters), "miss=%.3f",
+                static_cast<double>(total_misses.load()) / static_cast<double>(total_ops.load()));
+  ReportBenchmark(BenchmarkName(prefix, workload, threads), threads, total_ops.load(), seconds, counters);
+}
+
+}  // namespace bustub
+
+/**
+ * Page table benchmark: DensePageTable against the ExtendibleHashTable page table, holding 10K, 1M and 10M pages,
+ * with every workload at every thread count. Each run loads a fresh table (reported as /load), runs the workload,
+ * and removes every page again (reported as /drain). The sparse runs then drive the page tables of pools of 1K and 64K
+ * frames over a database of 10M pages, where nearly every access is a miss that maps and unmaps a page.
+ */
+auto main(int argc, char **argv) -> int {
+  using bustub::BenchmarkName;
+  const bustub::BenchmarkOptions options = bustub::ParseBenchmarkOptions(argc, argv);
+  bustub::PrintBenchmarkHeader();
+
+  for (size_t num_pages : {size_t{10000}, size_t{1000000}, size_t{10000000}}) {
+    const bustub::ZipfianDistribution zipfian(num_pages);
+    for (bool dense : {true, false}) {
+      const std::string prefix = std::string("BM_PageTable/") + (dense ? "Dense" : "ExtendibleHash") +
+                                 "/pages:" + std::to_string(num_pages);
+      for (auto workload : bustub::ALL_WORKLOADS) {
+        for (size_t threads : options.threads_) {
+          if (options.Selected(BenchmarkName(prefix, workload, threads))) {
+            bustub::RunPageTable(dense, num_pages, workload, threads, zipfian, options);
+          }
+        }
+      }
+    }
+  }
+
+  const bustub::ZipfianDistribution sparse_zipfian(bustub::SPARSE_DB_PAGES);
+  for (size_t pool_frames : {size_t{1024}, size_t{65536}}) {
+    for (bool dense : {true, false}) {
+      const std::string prefix = std::string("BM_PageTable/") + (dense ? "Dense" : "ExtendibleHash") +
+                                 "/sparse/pool:" + std::to_string(pool_frames);
+      for (auto workload : bustub::ALL_WORKLOADS) {
+        for (size_t threads : options.threads_) {
+          if (options.Selected(BenchmarkName(prefix, workload, threads))) {
+            bustub::RunSparsePageTable(dense, pool_frames, workload, threads, sparse_zipfian, options);
+          }
+        }
+      }
+    }
+  }
+  return 0;
+}
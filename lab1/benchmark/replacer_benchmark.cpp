@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_benchmark.cpp
+//
+// Identification: benchmark/replacer_benchmark.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_queue_replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/** Frames of every replacer under test. */
+static constexpr size_t NUM_FRAMES = 1024;
+/** Pages of the simulated database, 8 times the frames. */
+static constexpr size_t NUM_PAGES = 8 * NUM_FRAMES;
+/** Accesses LRUKReplacer buffers per stripe in its batched configuration. */
+static constexpr size_t ACCESS_BATCH = 64;
+
+/** A replacer configuration under test. */
+struct ReplacerConfig {
+  const char *name_;
+  std::unique_ptr<Replacer> (*make_)();
+};
+
+static const ReplacerConfig REPLACERS[] = {
+    {"LRUK", [] { return std::unique_ptr<Replacer>(new LRUKReplacer(NUM_FRAMES, LRUK_REPLACER_K)); }},
+    {"LRUK-batch",
+     [] { return std::unique_ptr<Replacer>(new LRUKReplacer(NUM_FRAMES, LRUK_REPLACER_K, ACCESS_BATCH)); }},
+    {"Clock", [] { return std::unique_ptr<Replacer>(new ClockReplacer(NUM_FRAMES)); }},
+    {"TwoQueue", [] { return std::unique_ptr<Replacer>(new TwoQueueReplacer(NUM_FRAMES)); }},
+    {"ARC", [] { return std::unique_ptr<Replacer>(new ARCReplacer(NUM_FRAMES)); }},
+};
+
+/**
+ * A buffer pool reduced to its bookkeeping: which page each frame holds, behind one latch like the pool latch. Every
+ * access pins and unpins its frame the way BufferPoolManagerInstance does, so the hit ratio is the one the policy
+ * would give the pool, without page I/O and copies.
+ */
+class SimulatedPool {
+ public:
+  explicit SimulatedPool(Replacer *replacer)
+      : replacer_(replacer), frame_of_(NUM_PAGES, INVALID_FRAME), page_of_(NUM_FRAMES, INVALID_PAGE_ID) {}
+
+  void Access(uint64_t page, AccessType access_type) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    frame_id_t frame_id = frame_of_[page];
+    if (frame_id != INVALID_FRAME) {
+      hits_++;
+      replacer_->SetEvictable(frame_id, false);
+      replacer_->RecordAccess(frame_id, access_type);
+      replacer_->SetEvictable(frame_id, true);
+      return;
+    }
+    misses_++;
+    if (next_free_ < NUM_FRAMES) {
+      frame_id = static_cast<frame_id_t>(next_free_++);
+    } else {
+      replacer_->Evict(&frame_id);
+      frame_of_[page_of_[frame_id]] = INVALID_FRAME;
+    }
+    frame_of_[page] = frame_id;
+    page_of_[frame_id] = static_cast<page_id_t>(page);
+    replacer_->SetFramePage(frame_id, static_cast<page_id_t>(page));
+    replacer_->RecordAccess(frame_id, access_type);
+    replacer_->SetEvictable(frame_id, true);
+  }
+
+  auto HitRatio() const -> double { return static_cast<double>(hits_) / static_cast<double>(hits_ + misses_); }
+
+ private:
+  static constexpr frame_id_t INVALID_FRAME = -1;
+
+  Replacer *replacer_;
+  std::mutex latch_;
+  std::vector<frame_id_t> frame_of_;
+  std::vector<page_id_t> page_of_;
+  size_t next_free_{0};
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+};
+
+/** @brief Run one workload through a SimulatedPool, reporting the policy's hit ratio. */
+void RunSimulation(const ReplacerConfig &config, Workload workload, size_t threads, const ZipfianDistribution &zipfian,
+                   const BenchmarkOptions &options) {
+  auto replacer = config.make_();
+  SimulatedPool pool(replacer.get());
+  const auto operations =
+      GenerateOperations(workload, NUM_PAGES, zipfian, options.seed_, threads, options.ops_per_thread_);
+  std::atomic<uint64_t> total_ops{0};
+  const double seconds = RunThreads(threads, [&](size_t thread_index) {
+    uint64_t ops = 0;
+    for (const Operation &op : operations[thread_index]) {
+      const AccessType access_type = op.type_ == OpType::Scan ? AccessType::Scan : AccessType::Lookup;
+      for (size_t j = 0; j < op.length_; j++) {
+        pool.Access((op.key_ + j) % NUM_PAGES, access_type);
+      }
+      ops += op.length_;
+    }
+    total_ops.fetch_add(ops);
+  });
+  char counters[32];
+  std::snprintf(counters, sizeof(counters), "hit=%.3f", pool.HitRatio());
+  ReportBenchmark(BenchmarkName(std::string("BM_Replacer/") + config.name_, workload, threads), threads,
+                  total_ops.load(), seconds, counters);
+}
+
+/**
+ * @brief Measure the hit path alone: every frame is resident and each access is a RecordAccess() on it, without a
+ * pool latch around it. This is where the replacer's own latch is contended.
+ */
+void RunHitPath(const ReplacerConfig &config, Workload workload, size_t threads, const ZipfianDistribution &zipfian,
+                const BenchmarkOptions &options) {
+  auto replacer = config.make_();
+  for (size_t frame = 0; frame < NUM_FRAMES; frame++) {
+    const auto frame_id = static_cast<frame_id_t>(frame);
+    replacer->SetFramePage(frame_id, frame_id);
+    replacer->RecordAccess(frame_id);
+    replacer->SetEvictable(frame_id, true);
+  }
+  const auto operations =
+      GenerateOperations(workload, NUM_FRAMES, zipfian, options.seed_, threads, options.ops_per_thread_);
+  std::atomic<uint64_t> total_ops{0};
+  const double seconds = RunThreads(threads, [&](size_t thread_index) {
+    uint64_t ops = 0;
+    for (const Operation &op : operations[thread_index]) {
+      const AccessType access_type = op.type_ == OpType::Scan ? AccessType::Scan : AccessType::Lookup;
+      for (size_t j = 0; j < op.length_; j++) {
+        replacer->RecordAccess(static_cast<frame_id_t>((op.key_ + j) % NUM_FRAMES), access_type);
+      }
+      ops += op.length_;
+    }
+    total_ops.fetch_add(ops);
+  });
+  ReportBenchmark(BenchmarkName(std::string("BM_ReplacerHit/") + config.name_, workload, threads), threads,
+                  total_ops.load(), seconds);
+}
+
+}  // namespace bustub
+
+/**
+ * Replacer benchmark, for every replacement policy and workload at every thread count:
+ * - BM_Replacer runs the workload through a simulated pool and reports the hit ratio of the policy.
+ * - BM_ReplacerHit records accesses to resident frames from all threads at once, the replacer's hot path.
+ */
+auto main(int argc, char **argv) -> int {
+  using bustub::BenchmarkName;
+  const bustub::BenchmarkOptions options = bustub::ParseBenchmarkOptions(argc, argv);
+  const bustub::ZipfianDistribution page_zipfian(bustub::NUM_PAGES);
+  const bustub::ZipfianDistribution frame_zipfian(bustub::NUM_FRAMES);
+  bustub::PrintBenchmarkHeader();
+
+  for (const auto &config : bustub::REPLACERS) {
+    for (auto workload : bustub::ALL_WORKLOADS) {
+      for (size_t threads : options.threads_) {
+        if (options.Selected(BenchmarkName(std::string("BM_Replacer/") + config.name_, workload, threads))) {
+          bustub::RunSimulation(config, workload, threads, page_zipfian, options);
+        }
+      }
+    }
+  }
+  for (const auto &config : bustub::REPLACERS) {
+    for (auto workload : bustub::ALL_WORKLOADS) {
+      for (size_t threads : options.threads_) {
+        if (options.Selected(BenchmarkName(std::string("BM_ReplacerHit/") + config.name_, workload, threads))) {
+          bustub::RunHitPath(config, workload, threads, frame_zipfian, options);
+        }
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// trie_benchmark.cpp
+//
+// Identification: benchmark/trie_benchmark.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "primer/p0_trie.h"
+#include "primer/typed_trie.h"
+
+namespace bustub {
+
+/** Keys in the trie when a run starts. */
+static constexpr size_t NUM_KEYS = 1 << 18;
+
+/** @return the key string of key number i, zero padded so the lexicographic order is the numeric one */
+auto TrieKey(uint64_t i) -> std::string {
+  char key[24];
+  std::snprintf(key, sizeof(key), "key%08llu", static_cast<unsigned long long>(i));  // NOLINT
+  return key;
+}
+
+/** Runs operations against the type-erased Trie. Scans iterate from LowerBound(). */
+struct TrieTarget {
+  static constexpr const char *NAME = "BM_Trie";
+  Trie trie_;
+
+  void Insert(const std::string &key, uint64_t value) { trie_.Insert<uint64_t>(key, value); }
+  void Remove(const std::string &key) { trie_.Remove(key); }
+  auto Get(const std::string &key) -> uint64_t {
+    bool success;
+    return trie_.GetValue<uint64_t>(key, &success);
+  }
+  auto Scan(const std::string &key, size_t length) -> uint64_t {
+    uint64_t sum = 0;
+    for (auto it = trie_.LowerBound(key); !it.IsEnd() && length > 0; ++it, length--) {
+      sum += *it.GetValue<uint64_t>();
+    }
+    return sum;
+  }
+};
+
+/** Runs operations against TypedTrie<uint64_t>, which has no iterator, so scans look their keys up one by one. */
+struct TypedTrieTarget {
+  static constexpr const char *NAME = "BM_TypedTrie";
+  TypedTrie<uint64_t> trie_;
+  const std::vector<std::string> *keys_;
+
+  void Insert(const std::string &key, uint64_t value) { trie_.Insert(key, value); }
+  void Remove(const std::string &key) { trie_.Remove(key); }
+  auto Get(const std::string &key) -> uint64_t {
+    bool success;
+    return trie_.GetValue(key, &success);
+  }
+  auto Scan(const std::string &key, size_t length) -> uint64_t {
+    uint64_t sum = 0;
+    const uint64_t first = std::strtoull(key.c_str() + 3, nullptr, 10);
+    for (size_t j = 0; j < length; j++) {
+      sum += Get((*keys_)[(first + j) % NUM_KEYS]);
+    }
+    return sum;
+  }
+};
+
+/**
+ * @brief Run one workload against a trie holding NUM_KEYS keys. Reads are point lookups, writes remove the key and
+ * insert it again, and scans read consecutive keys.
+ */
+template <typename Target>
+void RunTrie(Target *target, const std::vector<std::string> &keys, Workload workload, size_t threads,
+             const ZipfianDistribution &zipfian, const BenchmarkOptions &options) {
+  for (uint64_t i = 0; i < NUM_KEYS; i++) {
+    target->Insert(keys[i], i);
+  }
+  const auto operations =
+      GenerateOperations(workload, NUM_KEYS, zipfian, options.seed_, threads, options.ops_per_thread_);
+
+  std::atomic<uint64_t> total_ops{0};
+  const double seconds = RunThreads(threads, [&](size_t thread_index) {
+    uint64_t ops = 0;
+    for (const Operation &op : operations[thread_index]) {
+      const std::string &key = keys[op.key_];
+      if (op.type_ == OpType::Read) {
+        DoNotOptimize(target->Get(key));
+      } else if (op.type_ == OpType::Write) {
+        target->Remove(key);
+        target->Insert(key, op.key_);
+      } else {
+        DoNotOptimize(target->Scan(key, op.length_));
+      }
+      ops += op.length_;
+    }
+    total_ops.fetch_add(ops);
+  });
+  ReportBenchmark(BenchmarkName(Target::NAME, workload, threads), threads, total_ops.load(), seconds);
+}
+
+}  // namespace bustub
+
+/**
+ * Trie benchmark: every workload at every thread count, against the Trie and TypedTrie of lab0 with NUM_KEYS keys
+ * of 11 characters. Each run starts from a freshly loaded trie. Operations count keys, so a scan of 64 keys counts as
+ * 64.
+ */
+auto main(int argc, char **argv) -> int {
+  using bustub::BenchmarkName;
+  const bustub::BenchmarkOptions options = bustub::ParseBenchmarkOptions(argc, argv);
+  const bustub::ZipfianDistribution zipfian(bustub::NUM_KEYS);
+  std::vector<std::string> keys;
+  keys.reserve(bustub::NUM_KEYS);
+  for (uint64_t i = 0; i < bustub::NUM_KEYS; i++) {
+    keys.push_back(bustub::TrieKey(i));
+  }
+  bustub::PrintBenchmarkHeader();
+
+  for (auto workload : bustub::ALL_WORKLOADS) {
+    for (size_t threads : options.threads_) {
+      if (options.Selected(BenchmarkName(bustub::TrieTarget::NAME, workload, threads))) {
+        bustub::TrieTarget target;
+        bustub::RunTrie(&target, keys, workload, threads, zipfian, options);
+      }
+    }
+  }
+  for (auto workload : bustub::ALL_WORKLOADS) {
+    for (size_t threads : options.threads_) {
+      if (options.Selected(BenchmarkName(bustub::TypedTrieTarget::NAME, workload, threads))) {
+        bustub::TypedTrieTarget target;
+        target.keys_ = &keys;
+        bustub::RunTrie(&target, keys, workload, threads, zipfian, options);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,188 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace bustub {
+
+ARCReplacer::ARCReplacer(size_t num_frames)
+    : replacer_size_(num_frames), frames_(num_frames), t1_(&frames_), t2_(&frames_), b1_(num_frames),
+      b2_(2 * num_frames) {}
+
+void ARCReplacer::Enter(frame_id_t frame_id, List list) {
+  auto &state = frames_[frame_id];
+  state.list_ = list;
+  state.stamp_ = next_stamp_++;
+  (list == List::T1 ? t1_size_ : t2_size_)++;
+  if (state.is_evictable_) {
+    ListOf(list).PushFront(frame_id);
+  }
+}
+
+void ARCReplacer::Leave(frame_id_t frame_id) {
+  auto &state = frames_[frame_id];
+  if (state.is_evictable_) {
+    ListOf(state.list_).Erase(frame_id);
+  }
+  (state.list_ == List::T1 ? t1_size_ : t2_size_)--;
+  state.list_ = List::None;
+}
+
+auto ARCReplacer::PreferT1(size_t t1_size) const -> bool { return t1_size > p_; }
+
+void ARCReplacer::TrimGhosts() {
+  while (b1_.Size() > 0 && t1_size_ + b1_.Size() > replacer_size_) {
+    b1_.PopBack();
+  }
+  const size_t resident = t1_size_ + t2_size_;
+  while (b2_.Size() > 0 && resident + b1_.Size() + b2_.Size() > 2 * replacer_size_) {
+    b2_.PopBack();
+  }
+}
+
+auto ARCReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (curr_size_ == 0) {
+    return false;
+  }
+  bool from_t1 = PreferT1(t1_size_);
+  if ((from_t1 ? t1_ : t2_).Empty()) {
+    from_t1 = !from_t1;
+  }
+  *frame_id = (from_t1 ? t1_ : t2_).Back();
+
+  auto &state = frames_[*frame_id];
+  Leave(*frame_id);
+  auto &ghosts = from_t1 ? b1_ : b2_;
+  if (state.page_id_ != INVALID_PAGE_ID && !ghosts.Contains(state.page_id_)) {
+    ghosts.PushFront(state.page_id_);
+  }
+  state.is_evictable_ = false;
+  state.page_id_ = INVALID_PAGE_ID;
+  curr_size_--;
+  TrimGhosts();
+  return true;
+}
+
+void ARCReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &state = frames_[frame_id];
+  if (access_type == AccessType::Scan) {
+    // Scanned pages stay in T1 and their ghost hits do not move p.
+    if (state.list_ == List::None) {
+      if (state.page_id_ != INVALID_PAGE_ID && !b1_.Erase(state.page_id_)) {
+        b2_.Erase(state.page_id_);
+      }
+      Enter(frame_id, List::T1);
+      TrimGhosts();
+    }
+    return;
+  }
+  if (state.list_ != List::None) {
+    Leave(frame_id);
+    Enter(frame_id, List::T2);
+    return;
+  }
+
+  // A ghost hit tells which list was too short when the page was evicted.
+  const size_t b1_size = b1_.Size();
+  const size_t b2_size = b2_.Size();
+  if (state.page_id_ != INVALID_PAGE_ID && b1_.Erase(state.page_id_)) {
+    p_ = std::min(replacer_size_, p_ + std::max<size_t>(b2_size / b1_size, 1));
+    Enter(frame_id, List::T2);
+  } else if (state.page_id_ != INVALID_PAGE_ID && b2_.Erase(state.page_id_)) {
+    p_ -= std::min(p_, std::max<size_t>(b1_size / b2_size, 1));
+    Enter(frame_id, List::T2);
+  } else {
+    Enter(frame_id, List::T1);
+  }
+  TrimGhosts();
+}
+
+void ARCReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &state = frames_[frame_id];
+  if (state.list_ == List::None || state.is_evictable_ == set_evictable) {
+    return;
+  }
+  state.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    ListOf(state.list_).Insert(frame_id);
+    curr_size_++;
+  } else {
+    ListOf(state.list_).Erase(frame_id);
+    curr_size_--;
+  }
+}
+
+void ARCReplacer::Remove(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &state = frames_[frame_id];
+  if (state.list_ == List::None) {
+    return;
+  }
+  if (!state.is_evictable_) {
+    throw std::exception();
+  }
+  // A removed page was deleted, so it is not worth remembering as a ghost.
+  Leave(frame_id);
+  state.is_evictable_ = false;
+  state.page_id_ = INVALID_PAGE_ID;
+  curr_size_--;
+}
+
+auto ARCReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+void ARCReplacer::EvictionOrder(size_t max_frames, std::vector<frame_id_t> *frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  frames->clear();
+  // Replay Evict()'s list choice with p held fixed: T1 is preferred while it is longer than p.
+  constexpr frame_id_t none = FrameList<FrameState>::NONE;
+  frame_id_t t1_next = t1_.Back();
+  frame_id_t t2_next = t2_.Back();
+  size_t t1_size = t1_size_;
+  while (frames->size() < max_frames && (t1_next != none || t2_next != none)) {
+    if (t1_next != none && (PreferT1(t1_size) || t2_next == none)) {
+      frames->push_back(t1_next);
+      t1_next = t1_.Prev(t1_next);
+      t1_size--;
+    } else {
+      frames->push_back(t2_next);
+      t2_next = t2_.Prev(t2_next);
+    }
+  }
+}
+
+void ARCReplacer::SetFramePage(frame_id_t frame_id, page_id_t page_id) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  frames_[frame_id].page_id_ = page_id;
+}
+
+}  // namespace bustub
@@ -12,22 +12,79 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_queue_replacer.h"
 #include "common/exception.h"
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     PageTableType page_table_type,
+                                                     const FrameMemoryOptions &frame_memory,
+                                                     size_t replacer_access_batch)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager, replacer_type, page_table_type,
+                                frame_memory, replacer_access_batch) {}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     PageTableType page_table_type,
+                                                     const FrameMemoryOptions &frame_memory,
+                                                     size_t replacer_access_batch)
+    : pool_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      next_page_id_(static_cast<page_id_t>(instance_index)),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      guard_dirtied_(pool_size),
+      scan_ring_size_(std::min(DEFAULT_SCAN_RING_SIZE, pool_size / 8)) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
   // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
-  replacer_ = new LRUKReplacer(pool_size, replacer_k);
+  frame_memory_ = std::make_unique<FrameMemory>(pool_size_, frame_memory);
+  pages_ = frame_memory_->GetPages();
+  if (page_table_type == PageTableType::ExtendibleHash) {
+    auto *page_table = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
+    // The table never holds more than pool_size_ pages, so it does not have to split its way up to that.
+    page_table->Reserve(pool_size_);
+    page_table_ = page_table;
+  } else {
+    page_table_ = new DensePageTable(num_instances_, instance_index_, pool_size_);
+  }
+  switch (replacer_type) {
+    case ReplacerType::Clock:
+      replacer_ = new ClockReplacer(pool_size);
+      break;
+    case ReplacerType::TwoQueue:
+      replacer_ = new TwoQueueReplacer(pool_size);
+      break;
+    case ReplacerType::ARC:
+      replacer_ = new ARCReplacer(pool_size);
+      break;
+    case ReplacerType::LRUK:
+    default:
+      replacer_ = new LRUKReplacer(pool_size, replacer_k, replacer_access_batch);
+      break;
+  }
+
+  io_in_progress_.resize(pool_size_, false);
+  flusher_writing_.resize(pool_size_, false);
+  prefetched_.resize(pool_size_, false);
+  scan_ring_slot_.resize(pool_size_, NOT_IN_SCAN_RING);
 
   // Initially, every page is in the free list.
+  free_list_.resize(pool_size_);
   for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+    PushFreeFrame(static_cast<frame_id_t>(i));
   }
 
   // TODO(students): remove this line after you have implemented the buffer pool manager
@@ -37,133 +94,110 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManag
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  StopFlusher();
+  StopPrefetcher();
   delete page_table_;
   delete replacer_;
 }
 
 auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  std::lock_guard<std::mutex> guard(latch_);
-  bool all_pinned = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].GetPinCount() <= 0) {
-      all_pinned = false;
-      break;
-    }
-  }
-
-  if (all_pinned) {  // 如果所有frame都被pin，则直接返回 null
-    return nullptr;
-  }
+  LatencyTimer timer(Tracked(&new_page_latency_));
+  auto &stats = stats_.Local();
+  auto lock = LockLatch();
   frame_id_t frame_id;
-  // Page *frame = nullptr;
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    auto vic = replacer_->Evict(&frame_id);
-    // frame = &pages_[frame_id];
-
-    auto evict_id = pages_[frame_id].GetPageId();
-    if (pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(evict_id, pages_[frame_id].GetData());
-      pages_[frame_id].is_dirty_ = false;
-    }
-    pages_[frame_id].ResetMemory();
-    page_table_->Remove(pages_[frame_id].GetPageId());
-    if (!vic) {
-      return nullptr;
-    }  // 如果没有frame可以驱逐，则返回null
+  page_id_t dirty_page_id;
+  if (!AcquireFrame(&frame_id, &dirty_page_id)) {  // 如果没有frame可以驱逐，则返回null
+    Bump(&stats.new_page_failures_);
+    return nullptr;
   }
+  Bump(&stats.new_pages_);
 
   *page_id = AllocatePage();  // new page
-  pages_[frame_id].page_id_ = *page_id;
-  pages_[frame_id].pin_count_ = 1;
-  page_table_->Insert(*page_id, frame_id);
-  replacer_->RecordAccess(frame_id);
-  replacer_->SetEvictable(frame_id, false);
+  PinNewFrame(frame_id, *page_id);
+  auto &frame = pages_[frame_id];
+  if (dirty_page_id == INVALID_PAGE_ID) {
+    frame.ResetMemory();
+    return &frame;
+  }
 
-  return &pages_[frame_id];
+  // The victim still has to reach the disk before the frame can be zeroed, do that without blocking other threads.
+  io_in_progress_[frame_id] = true;
+  lock.unlock();
+  disk_manager_->WritePage(dirty_page_id, frame.GetData());
+  frame.ResetMemory();
+  lock.lock();
+  FinishFrameIo(frame_id, dirty_page_id);
+  return &frame;
 }
 
 auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  std::lock_guard<std::mutex> guard(latch_);
-
-  bool all_pinned = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].GetPinCount() <= 0) {
-      all_pinned = false;
-      break;
-    }
-  }
+  return FetchPgImp(page_id, AccessType::Unknown);
+}
 
-  if (all_pinned) {  // 如果所有frame都被pin，则直接返回 null
-    return nullptr;
-  }
+auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id, AccessType access_type) -> Page * {
+  LatencyTimer timer(Tracked(&fetch_latency_));
+  auto &stats = stats_.Local();
+  Bump(&stats.fetches_);
+  auto lock = LockLatch();
   frame_id_t frame_id;
 
-  auto ret = page_table_->Find(page_id, frame_id);
-  // Page *frame = nullptr;
-  if (ret) {
-    // frame = &pages_[frame_id];
-    pages_[frame_id].pin_count_++;
-    replacer_->RecordAccess(frame_id);
-    replacer_->SetEvictable(frame_id, false);
-    return &pages_[frame_id];
+  if (read_ahead_window_ > 0) {
+    NoteFetch(page_id);
   }
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    auto vic = replacer_->Evict(&frame_id);
-
-    auto evict_id = pages_[frame_id].GetPageId();
-    if (pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(evict_id, pages_[frame_id].GetData());
-      pages_[frame_id].is_dirty_ = false;
+  if (FindFrame(page_id, &frame_id, &lock)) {
+    const bool record_access = !prefetched_[frame_id];
+    prefetched_[frame_id] = false;
+    if (access_type != AccessType::Scan) {
+      scan_ring_slot_[frame_id] = NOT_IN_SCAN_RING;
+    }
+    // Only the first pin changes evictability, later ones would just take the replacer latch for nothing.
+    if (PinFrame(frame_id) == 0) {
+      replacer_->SetEvictable(frame_id, false);
     }
-    pages_[frame_id].ResetMemory();
-    page_table_->Remove(pages_[frame_id].GetPageId());
-    if (!vic) {
-      return nullptr;
-    }  // 如果没有frame可以驱逐，则返回null
+    lock.unlock();
+    // Our pin keeps the frame from being evicted or deleted, so the access can be recorded without latch_. With
+    // replacer_access_batch set, the LRU-K replacer only buffers it, without taking its own latch either.
+    if (record_access) {
+      replacer_->RecordAccess(frame_id, access_type);
+    }
+    Bump(&stats.fetch_hits_);
+    return &pages_[frame_id];
+  }
+  page_id_t dirty_page_id;
+  const bool acquired = access_type == AccessType::Scan ? AcquireScanFrame(&frame_id, &dirty_page_id)
+                                                        : AcquireFrame(&frame_id, &dirty_page_id);
+  if (!acquired) {  // 如果没有frame可以驱逐，则返回null
+    Bump(&stats.fetch_failures_);
+    return nullptr;
   }
 
-  // auto frame = &pages_[frame_id];
-
-  pages_[frame_id].page_id_ = page_id;  // other page
-  ++pages_[frame_id].pin_count_;
-  // frame->ResetMemory();
-  replacer_->RecordAccess(frame_id);
-  replacer_->SetEvictable(frame_id, false);
-  page_table_->Insert(page_id, frame_id);
-  disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
-  // *page_id = new_page_id;
-  return &pages_[frame_id];
+  // Publish the frame before reading, so concurrent fetchers of page_id wait for this read instead of issuing their
+  // own, and fetchers of the dirty victim wait until it is safely on disk.
+  PinNewFrame(frame_id, page_id, access_type);
+  io_in_progress_[frame_id] = true;
+  lock.unlock();
+  auto &frame = pages_[frame_id];
+  if (dirty_page_id != INVALID_PAGE_ID) {
+    disk_manager_->WritePage(dirty_page_id, frame.GetData());
+  }
+  disk_manager_->ReadPage(page_id, frame.GetData());
+  lock.lock();
+  FinishFrameIo(frame_id, dirty_page_id);
+  return &frame;
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  std::lock_guard<std::mutex> guard(latch_);
+  auto lock = LockLatch();
   frame_id_t frame_id;
-  auto ret = page_table_->Find(page_id, frame_id);
-  if (!ret) {
+  if (!FindFrame(page_id, &frame_id, &lock)) {
     return false;
   }
 
-  // auto page = &pages_[frame_id];
-
-  if (pages_[frame_id].pin_count_ <= 0) {
+  if (PinCount(frame_id) <= 0) {
     return false;
   }
-  if (is_dirty) {
-    pages_[frame_id].is_dirty_ = is_dirty;
-  }
-  --pages_[frame_id].pin_count_;
-
-  if (pages_[frame_id].pin_count_ == 0) {
-    replacer_->SetEvictable(frame_id, true);
-  }
-
+  UnpinFrame(frame_id, is_dirty);
+  Bump(&stats_.Local().unpins_);
   return true;
 }
 
@@ -171,54 +205,582 @@ auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
-  // std::lock_guard<std::mutex> guard(latch_);
+  auto lock = LockLatch();
   frame_id_t frame_id;
-  auto ret = page_table_->Find(page_id, frame_id);
-  if (!ret) {
+  if (!FindFrame(page_id, &frame_id, &lock)) {
     return false;
   }
-  // auto frame = &pages_[frame_id];
-  // frame->is_dirty_ = false;
-  disk_manager_->WritePage(pages_[frame_id].GetPageId(), pages_[frame_id].GetData());
+  disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+  SetFrameDirty(frame_id, false);
+  Bump(&stats_.Local().flushes_);
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
   std::lock_guard<std::mutex> guard(latch_);
   for (size_t i = 0; i < pool_size_; i++) {
-    // auto frame = &pages_[i];
-    /* if (frame->page_id_ != INVALID_PAGE_ID && frame->IsDirty()) {
-      disk_manager_->WritePage(pages_[i].GetPageId(), pages_[i].GetData());
-      frame->is_dirty_ = false;
-    } */
-    FlushPgImp(pages_[i].GetPageId());
+    // Frames with I/O in progress are being filled or written back by their owner right now.
+    if (pages_[i].GetPageId() == INVALID_PAGE_ID || io_in_progress_[i]) {
+      continue;
+    }
+    disk_manager_->WritePage(pages_[i].GetPageId(), pages_[i].GetData());
+    SetFrameDirty(static_cast<frame_id_t>(i), false);
+    Bump(&stats_.Local().flushes_);
   }
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
-  std::lock_guard<std::mutex> guard(latch_);
+  auto lock = LockLatch();
   frame_id_t frame_id;
-  auto ret = page_table_->Find(page_id, frame_id);
-  if (!ret) {
+  if (!FindFrame(page_id, &frame_id, &lock)) {
     return true;
   }
+  while (flusher_writing_[frame_id]) {
+    // The flusher only pins the frame to write it back, the page may be unpinned (or even evicted) once it is done.
+    io_cv_.wait(lock);
+    if (!FindFrame(page_id, &frame_id, &lock)) {
+      return true;
+    }
+  }
   // auto page = &pages_[frame_id];
-  if (pages_[frame_id].GetPinCount() > 0) {
+  if (PinCount(frame_id) > 0) {
     return false;
   }
 
   replacer_->Remove(frame_id);
   // replacer_->SetEvictable(frame_id, false);
   pages_[frame_id].ResetMemory();
-  pages_[frame_id].pin_count_ = 0;
   pages_[frame_id].page_id_ = INVALID_PAGE_ID;
-  pages_[frame_id].is_dirty_ = false;
+  SetFrameDirty(frame_id, false);
   page_table_->Remove(page_id);
-  free_list_.push_back(frame_id);
+  scan_ring_slot_[frame_id] = NOT_IN_SCAN_RING;
+  PushFreeFrame(frame_id);
   DeallocatePage(page_id);
   return true;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+auto BufferPoolManagerInstance::PopFreeFrame(frame_id_t *frame_id) -> bool {
+  if (free_count_ == 0) {
+    return false;
+  }
+  *frame_id = free_list_[free_head_];
+  free_head_ = (free_head_ + 1) % pool_size_;
+  free_count_--;
+  return true;
+}
+
+void BufferPoolManagerInstance::PushFreeFrame(frame_id_t frame_id) {
+  BUSTUB_ASSERT(free_count_ < pool_size_, "a frame was returned to the free list twice");
+  free_list_[(free_head_ + free_count_) % pool_size_] = frame_id;
+  free_count_++;
+}
+
+auto BufferPoolManagerInstance::AcquireFrame(frame_id_t *frame_id, page_id_t *dirty_page_id) -> bool {
+  *dirty_page_id = INVALID_PAGE_ID;
+  if (PopFreeFrame(frame_id)) {
+    return true;
+  }
+  bool evicted;
+  {
+    LatencyTimer timer(Tracked(&evict_latency_));
+    evicted = replacer_->Evict(frame_id);
+  }
+  if (!evicted) {
+    return false;
+  }
+  Bump(&stats_.Local().evictions_);
+  scan_ring_slot_[*frame_id] = NOT_IN_SCAN_RING;
+  DetachVictim(*frame_id, dirty_page_id);
+  return true;
+}
+
+auto BufferPoolManagerInstance::AcquireScanFrame(frame_id_t *frame_id, page_id_t *dirty_page_id) -> bool {
+  if (scan_ring_size_ == 0) {
+    return AcquireFrame(frame_id, dirty_page_id);
+  }
+  if (scan_ring_.size() < scan_ring_size_) {
+    if (!AcquireFrame(frame_id, dirty_page_id)) {
+      return false;
+    }
+    scan_ring_slot_[*frame_id] = scan_ring_.size();
+    scan_ring_.push_back(*frame_id);
+    return true;
+  }
+
+  const size_t slot = scan_ring_next_;
+  scan_ring_next_ = (scan_ring_next_ + 1) % scan_ring_.size();
+  const frame_id_t ring_frame = scan_ring_[slot];
+  if (scan_ring_slot_[ring_frame] == slot && PinCount(ring_frame) == 0 && !io_in_progress_[ring_frame]) {
+    // An unpinned resident frame is always evictable, so the replacer lets go of it.
+    *dirty_page_id = INVALID_PAGE_ID;
+    replacer_->Remove(ring_frame);
+    *frame_id = ring_frame;
+    Bump(&stats_.Local().evictions_);
+    DetachVictim(ring_frame, dirty_page_id);
+    return true;
+  }
+
+  // The slot's frame is pinned or was handed to other pages, give the slot a new frame.
+  if (!AcquireFrame(frame_id, dirty_page_id)) {
+    return false;
+  }
+  scan_ring_[slot] = *frame_id;
+  scan_ring_slot_[*frame_id] = slot;
+  return true;
+}
+
+void BufferPoolManagerInstance::DetachVictim(frame_id_t frame_id, page_id_t *dirty_page_id) {
+  auto &frame = pages_[frame_id];
+  if (frame.IsDirty()) {
+    // Keep the victim in the page table, FinishFrameIo() drops it once the write-back is done.
+    *dirty_page_id = frame.GetPageId();
+    SetFrameDirty(frame_id, false);
+    Bump(&stats_.Local().dirty_evictions_);
+  } else {
+    page_table_->Remove(frame.GetPageId());
+  }
+  frame.page_id_ = INVALID_PAGE_ID;
+}
+
+void BufferPoolManagerInstance::PinNewFrame(frame_id_t frame_id, page_id_t page_id, AccessType access_type) {
+  auto &frame = pages_[frame_id];
+  frame.page_id_ = page_id;
+  frame.pin_count_.store(1, std::memory_order_release);
+  prefetched_[frame_id] = false;
+  {
+    LatencyTimer timer(Tracked(&page_table_latency_));
+    page_table_->Insert(page_id, frame_id);
+  }
+  replacer_->SetFramePage(frame_id, page_id);
+  replacer_->RecordAccess(frame_id, access_type);
+  replacer_->SetEvictable(frame_id, false);
+}
+
+auto BufferPoolManagerInstance::FindFrame(page_id_t page_id, frame_id_t *frame_id, std::unique_lock<std::mutex> *lock)
+    -> bool {
+  while (true) {
+    bool found;
+    {
+      LatencyTimer timer(Tracked(&page_table_latency_));
+      found = page_table_->Find(page_id, *frame_id);
+    }
+    if (!found) {
+      return false;
+    }
+    if (!io_in_progress_[*frame_id]) {
+      return true;
+    }
+    // The frame may hold a different page once the I/O is done (page_id was a write-back victim), look it up again.
+    io_cv_.wait(*lock);
+  }
+}
+
+void BufferPoolManagerInstance::FinishFrameIo(frame_id_t frame_id, page_id_t dirty_page_id) {
+  if (dirty_page_id != INVALID_PAGE_ID) {
+    page_table_->Remove(dirty_page_id);
+  }
+  io_in_progress_[frame_id] = false;
+  io_cv_.notify_all();
+}
+
+void BufferPoolManagerInstance::SetFrameDirty(frame_id_t frame_id, bool is_dirty) {
+  auto &frame = pages_[frame_id];
+  if (frame.is_dirty_ != is_dirty) {
+    num_dirty_ = is_dirty ? num_dirty_ + 1 : num_dirty_ - 1;
+    frame.is_dirty_ = is_dirty;
+  }
+}
+
+void BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id, bool is_dirty) {
+  // Guards that dropped their pin without the latch did so before this pin's decrement, which therefore sees their
+  // marks once it is the last one.
+  const bool unpinned = pages_[frame_id].pin_count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  if (guard_dirtied_[frame_id].exchange(false, std::memory_order_relaxed)) {
+    is_dirty = true;
+  }
+  if (is_dirty) {
+    SetFrameDirty(frame_id, true);
+    if (flusher_running_ && num_dirty_ == flusher_high_dirty_ + 1) {
+      flusher_cv_.notify_one();
+    }
+  }
+  if (unpinned) {
+    replacer_->SetEvictable(frame_id, true);
+  }
+}
+
+auto BufferPoolManagerInstance::TryUnpinFrameUnlatched(frame_id_t frame_id, bool is_dirty) -> bool {
+  std::atomic<int> &pin_count = pages_[frame_id].pin_count_;
+  int count = pin_count.load(std::memory_order_acquire);
+  if (count <= 1) {
+    return false;
+  }
+  // Mark the frame before dropping the pin, so whoever drops the last pin afterwards folds the mark in.
+  if (is_dirty) {
+    guard_dirtied_[frame_id].store(true, std::memory_order_relaxed);
+  }
+  while (count > 1) {
+    if (pin_count.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void BufferPoolManagerInstance::ReleaseFrame(Page *page, bool is_dirty) {
+  const frame_id_t frame_id = FrameOf(page);
+  auto &stats = stats_.Local();
+  Bump(&stats.unpins_);
+  if (TryUnpinFrameUnlatched(frame_id, is_dirty)) {
+    Bump(&stats.unlatched_unpins_);
+    return;
+  }
+  auto lock = LockLatch();
+  UnpinFrame(frame_id, is_dirty);
+}
+
+void BufferPoolManagerInstance::ReleaseFrames(const std::vector<std::pair<Page *, bool>> &pages) {
+  std::vector<std::pair<frame_id_t, bool>> last_pins;
+  for (const auto &[page, is_dirty] : pages) {
+    const frame_id_t frame_id = FrameOf(page);
+    if (!TryUnpinFrameUnlatched(frame_id, is_dirty)) {
+      last_pins.emplace_back(frame_id, is_dirty);
+    }
+  }
+  auto &stats = stats_.Local();
+  Bump(&stats.unpins_, pages.size());
+  Bump(&stats.unlatched_unpins_, pages.size() - last_pins.size());
+  if (last_pins.empty()) {
+    return;
+  }
+  auto lock = LockLatch();
+  for (const auto &[frame_id, is_dirty] : last_pins) {
+    UnpinFrame(frame_id, is_dirty);
+  }
+}
+
+auto BufferPoolManagerInstance::FetchPageBasic(page_id_t page_id, AccessType access_type) -> BasicPageGuard {
+  return {this, FetchPgImp(page_id, access_type)};
+}
+
+auto BufferPoolManagerInstance::FetchPageRead(page_id_t page_id, AccessType access_type) -> ReadPageGuard {
+  Page *page = FetchPgImp(page_id, access_type);
+  if (page != nullptr) {
+    page->RLatch();
+  }
+  return {this, page};
+}
+
+auto BufferPoolManagerInstance::FetchPageWrite(page_id_t page_id, AccessType access_type) -> WritePageGuard {
+  Page *page = FetchPgImp(page_id, access_type);
+  if (page != nullptr) {
+    page->WLatch();
+  }
+  return {this, page};
+}
+
+auto BufferPoolManagerInstance::NewPageGuarded(page_id_t *page_id) -> BasicPageGuard {
+  return {this, NewPgImp(page_id)};
+}
+
+void BufferPoolManagerInstance::StartFlusher(std::chrono::milliseconds interval, double high_watermark,
+                                             double low_watermark, size_t batch_size) {
+  BUSTUB_ASSERT(low_watermark <= high_watermark, "the flusher must stop below the point where it starts");
+  StopFlusher();
+  std::scoped_lock<std::mutex> lock(latch_);
+  flusher_interval_ = interval;
+  flusher_high_dirty_ = static_cast<size_t>(high_watermark * static_cast<double>(pool_size_));
+  flusher_low_dirty_ = static_cast<size_t>(low_watermark * static_cast<double>(pool_size_));
+  flusher_batch_size_ = std::max<size_t>(batch_size, 1);
+  flusher_stop_ = false;
+  flusher_running_ = true;
+  flusher_thread_ = std::thread(&BufferPoolManagerInstance::FlusherLoop, this);
+}
+
+void BufferPoolManagerInstance::StopFlusher() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (!flusher_running_) {
+      return;
+    }
+    flusher_stop_ = true;
+    flusher_running_ = false;
+  }
+  flusher_cv_.notify_all();
+  flusher_thread_.join();
+}
+
+void BufferPoolManagerInstance::FlusherLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  bool stalled = false;
+  while (!flusher_stop_) {
+    if (stalled) {
+      // The dirty frames left are all pinned, waking up on the watermark would spin while holding the latch.
+      flusher_cv_.wait_for(lock, flusher_interval_, [&] { return flusher_stop_; });
+    } else {
+      flusher_cv_.wait_for(lock, flusher_interval_, [&] { return flusher_stop_ || num_dirty_ > flusher_high_dirty_; });
+    }
+    if (flusher_stop_ || num_dirty_ <= flusher_high_dirty_) {
+      stalled = false;
+      continue;
+    }
+    while (!flusher_stop_ && num_dirty_ > flusher_low_dirty_ && FlushDirtyBatch(&lock)) {
+    }
+    stalled = num_dirty_ > flusher_high_dirty_;
+  }
+}
+
+auto BufferPoolManagerInstance::FlushDirtyBatch(std::unique_lock<std::mutex> *lock) -> bool {
+  // Start a few batches deep into the eviction order, those are the frames about to be evicted, and look twice as deep
+  // each time that does not fill the batch. Batched frames leave the eviction order (they are pinned) and clean ones
+  // are skipped again, so the walk costs at most twice the depth it ends at.
+  std::vector<frame_id_t> candidates;
+  std::vector<frame_id_t> batch;
+  for (size_t depth = flusher_batch_size_ * 8; batch.size() < flusher_batch_size_; depth *= 2) {
+    candidates.clear();
+    replacer_->EvictionOrder(depth, &candidates);
+    for (auto frame_id : candidates) {
+      auto &frame = pages_[frame_id];
+      if (!frame.IsDirty() || io_in_progress_[frame_id]) {
+        continue;
+      }
+      // Pin the frame so it is neither evicted nor deleted while being written, without recording an access.
+      if (PinFrame(frame_id) == 0) {
+        replacer_->SetEvictable(frame_id, false);
+      }
+      SetFrameDirty(frame_id, false);
+      flusher_writing_[frame_id] = true;
+      batch.push_back(frame_id);
+      if (batch.size() == flusher_batch_size_) {
+        break;
+      }
+    }
+    if (candidates.size() < depth) {
+      break;  // That was the whole eviction order.
+    }
+  }
+  if (batch.empty()) {
+    return false;
+  }
+  Bump(&stats_.Local().flusher_writes_, batch.size());
+
+  std::sort(batch.begin(), batch.end(),
+            [&](frame_id_t a, frame_id_t b) { return pages_[a].GetPageId() < pages_[b].GetPageId(); });
+  lock->unlock();
+  for (auto frame_id : batch) {
+    // Someone may have fetched the page meanwhile, the read latch keeps them from modifying it mid-write. If they do
+    // modify it afterwards, their unpin marks the frame dirty again.
+    auto &frame = pages_[frame_id];
+    frame.RLatch();
+    disk_manager_->WritePage(frame.GetPageId(), frame.GetData());
+    frame.RUnlatch();
+  }
+  lock->lock();
+
+  for (auto frame_id : batch) {
+    UnpinFrame(frame_id, false);
+    flusher_writing_[frame_id] = false;
+  }
+  io_cv_.notify_all();
+  return true;
+}
+
+void BufferPoolManagerInstance::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  EnqueuePrefetch(page_ids.data(), page_ids.size());
+}
+
+void BufferPoolManagerInstance::SetReadAhead(size_t window) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  read_ahead_window_ = window;
+  sequential_run_ = 0;
+  read_ahead_next_ = INVALID_PAGE_ID;
+}
+
+void BufferPoolManagerInstance::SetScanRingSize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (size_t slot = 0; slot < scan_ring_.size(); slot++) {
+    if (scan_ring_slot_[scan_ring_[slot]] == slot) {
+      scan_ring_slot_[scan_ring_[slot]] = NOT_IN_SCAN_RING;
+    }
+  }
+  scan_ring_.clear();
+  scan_ring_next_ = 0;
+  scan_ring_size_ = std::min(num_frames, pool_size_);
+}
+
+void BufferPoolManagerInstance::EnqueuePrefetch(const page_id_t *page_ids, size_t count) {
+  if (count == 0) {
+    return;
+  }
+  for (size_t i = 0; i < count && prefetch_queue_.size() < pool_size_; i++) {
+    prefetch_queue_.push_back(page_ids[i]);
+  }
+  if (!prefetch_running_) {
+    prefetch_running_ = true;
+    prefetch_thread_ = std::thread(&BufferPoolManagerInstance::PrefetchLoop, this);
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManagerInstance::NoteFetch(page_id_t page_id) {
+  const auto stride = static_cast<page_id_t>(num_instances_);
+  if (last_fetched_page_id_ != INVALID_PAGE_ID && page_id == last_fetched_page_id_ + stride) {
+    sequential_run_++;
+  } else if (page_id != last_fetched_page_id_) {
+    sequential_run_ = 1;
+    read_ahead_next_ = page_id + stride;
+  }
+  last_fetched_page_id_ = page_id;
+  if (sequential_run_ < READ_AHEAD_TRIGGER) {
+    return;
+  }
+
+  // Top the window up once the scan is halfway through the part already queued. Pages past the last allocated one
+  // don't exist yet.
+  const auto window = static_cast<page_id_t>(read_ahead_window_);
+  if (read_ahead_next_ > page_id + window / 2 * stride) {
+    return;
+  }
+  const page_id_t end = std::min(page_id + (window + 1) * stride, next_page_id_);
+  std::vector<page_id_t> pages;
+  for (page_id_t next = std::max(read_ahead_next_, page_id + stride); next < end; next += stride) {
+    pages.push_back(next);
+  }
+  read_ahead_next_ = std::max(read_ahead_next_, end);
+  EnqueuePrefetch(pages.data(), pages.size());
+}
+
+void BufferPoolManagerInstance::PrefetchLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    prefetch_cv_.wait(lock, [&] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+    if (prefetch_stop_) {
+      return;
+    }
+    const page_id_t page_id = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    PrefetchPage(page_id, &lock);
+  }
+}
+
+void BufferPoolManagerInstance::PrefetchPage(page_id_t page_id, std::unique_lock<std::mutex> *lock) {
+  frame_id_t frame_id;
+  if (page_id < 0 || static_cast<uint32_t>(page_id) % num_instances_ != instance_index_ ||
+      page_table_->Find(page_id, frame_id)) {
+    return;
+  }
+  page_id_t dirty_page_id;
+  if (!AcquireFrame(&frame_id, &dirty_page_id)) {
+    return;
+  }
+
+  // Same protocol as a fetch miss, the pin only keeps the frame in place until the read is done.
+  Bump(&stats_.Local().prefetch_reads_);
+  PinNewFrame(frame_id, page_id);
+  io_in_progress_[frame_id] = true;
+  lock->unlock();
+  auto &frame = pages_[frame_id];
+  if (dirty_page_id != INVALID_PAGE_ID) {
+    disk_manager_->WritePage(dirty_page_id, frame.GetData());
+  }
+  disk_manager_->ReadPage(page_id, frame.GetData());
+  lock->lock();
+  UnpinFrame(frame_id, false);
+  prefetched_[frame_id] = true;
+  FinishFrameIo(frame_id, dirty_page_id);
+}
+
+void BufferPoolManagerInstance::StopPrefetcher() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (!prefetch_running_) {
+      return;
+    }
+    prefetch_stop_ = true;
+    prefetch_running_ = false;
+  }
+  prefetch_cv_.notify_all();
+  prefetch_thread_.join();
+}
+
+auto BufferPoolManagerInstance::LockLatch() -> std::unique_lock<std::mutex> {
+  auto &stats = stats_.Local();
+  Bump(&stats.latch_acquisitions_);
+  std::unique_lock<std::mutex> lock(latch_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    Bump(&stats.latch_contentions_);
+    LatencyTimer timer(Tracked(&latch_wait_));
+    lock.lock();
+  }
+  return lock;
+}
+
+void BufferPoolStats::Merge(const BufferPoolStats &other) {
+  fetches_ += other.fetches_;
+  fetch_hits_ += other.fetch_hits_;
+  fetch_failures_ += other.fetch_failures_;
+  new_pages_ += other.new_pages_;
+  new_page_failures_ += other.new_page_failures_;
+  evictions_ += other.evictions_;
+  dirty_evictions_ += other.dirty_evictions_;
+  flusher_writes_ += other.flusher_writes_;
+  flushes_ += other.flushes_;
+  prefetch_reads_ += other.prefetch_reads_;
+  unpins_ += other.unpins_;
+  unlatched_unpins_ += other.unlatched_unpins_;
+  latch_acquisitions_ += other.latch_acquisitions_;
+  latch_contentions_ += other.latch_contentions_;
+  free_frames_ += other.free_frames_;
+  evictable_frames_ += other.evictable_frames_;
+  dirty_frames_ += other.dirty_frames_;
+  fetch_latency_.Merge(other.fetch_latency_);
+  new_page_latency_.Merge(other.new_page_latency_);
+  evict_latency_.Merge(other.evict_latency_);
+  page_table_latency_.Merge(other.page_table_latency_);
+  latch_wait_.Merge(other.latch_wait_);
+}
+
+auto BufferPoolManagerInstance::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  stats_.ForEach([&](const StatsShard &shard) {
+    stats.fetches_ += shard.fetches_.load(std::memory_order_relaxed);
+    stats.fetch_hits_ += shard.fetch_hits_.load(std::memory_order_relaxed);
+    stats.fetch_failures_ += shard.fetch_failures_.load(std::memory_order_relaxed);
+    stats.new_pages_ += shard.new_pages_.load(std::memory_order_relaxed);
+    stats.new_page_failures_ += shard.new_page_failures_.load(std::memory_order_relaxed);
+    stats.evictions_ += shard.evictions_.load(std::memory_order_relaxed);
+    stats.dirty_evictions_ += shard.dirty_evictions_.load(std::memory_order_relaxed);
+    stats.flusher_writes_ += shard.flusher_writes_.load(std::memory_order_relaxed);
+    stats.flushes_ += shard.flushes_.load(std::memory_order_relaxed);
+    stats.prefetch_reads_ += shard.prefetch_reads_.load(std::memory_order_relaxed);
+    stats.unpins_ += shard.unpins_.load(std::memory_order_relaxed);
+    stats.unlatched_unpins_ += shard.unlatched_unpins_.load(std::memory_order_relaxed);
+    stats.latch_acquisitions_ += shard.latch_acquisitions_.load(std::memory_order_relaxed);
+    stats.latch_contentions_ += shard.latch_contentions_.load(std::memory_order_relaxed);
+  });
+  stats.fetch_latency_ = fetch_latency_.Snapshot();
+  stats.new_page_latency_ = new_page_latency_.Snapshot();
+  stats.evict_latency_ = evict_latency_.Snapshot();
+  stats.page_table_latency_ = page_table_latency_.Snapshot();
+  stats.latch_wait_ = latch_wait_.Snapshot();
+
+  std::scoped_lock<std::mutex> lock(latch_);
+  stats.free_frames_ = free_count_;
+  stats.evictable_frames_ = replacer_->Size();
+  stats.dirty_frames_ = num_dirty_;
+  return stats;
+}
+
+auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
+  const page_id_t next_page_id = next_page_id_;
+  next_page_id_ += static_cast<page_id_t>(num_instances_);
+  ValidatePageId(next_page_id);
+  return next_page_id;
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
+}
 
 }  // namespace bustub
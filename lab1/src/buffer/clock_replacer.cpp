@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_replacer.cpp
+//
+// Identification: src/buffer/clock_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/clock_replacer.h"
+
+#include <exception>
+
+namespace bustub {
+
+ClockReplacer::ClockReplacer(size_t num_frames)
+    : replacer_size_(num_frames),
+      tracked_(new std::atomic<bool>[num_frames]),
+      referenced_(new std::atomic<bool>[num_frames]),
+      evictable_(num_frames, false) {
+  for (size_t i = 0; i < num_frames; i++) {
+    tracked_[i] = false;
+    referenced_[i] = false;
+  }
+}
+
+auto ClockReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (curr_size_ == 0) {
+    return false;
+  }
+  // The first sweep clears the reference bits it passes, so the second one finds a victim at the latest.
+  for (size_t step = 0; step < 2 * replacer_size_; step++) {
+    const size_t frame = hand_;
+    hand_ = (hand_ + 1) % replacer_size_;
+    if (!evictable_[frame]) {
+      continue;
+    }
+    if (referenced_[frame].exchange(false, std::memory_order_relaxed)) {
+      continue;
+    }
+    evictable_[frame] = false;
+    tracked_[frame].store(false, std::memory_order_relaxed);
+    curr_size_--;
+    *frame_id = static_cast<frame_id_t>(frame);
+    return true;
+  }
+  return false;
+}
+
+void ClockReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  // Scanned pages get no second chance.
+  const bool reference = access_type != AccessType::Scan;
+  if (tracked_[frame_id].load(std::memory_order_relaxed)) {
+    if (reference) {
+      referenced_[frame_id].store(true, std::memory_order_relaxed);
+    }
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  tracked_[frame_id].store(true, std::memory_order_relaxed);
+  referenced_[frame_id].store(reference, std::memory_order_relaxed);
+}
+
+void ClockReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (!tracked_[frame_id].load(std::memory_order_relaxed) || evictable_[frame_id] == set_evictable) {
+    return;
+  }
+  evictable_[frame_id] = set_evictable;
+  curr_size_ = set_evictable ? curr_size_ + 1 : curr_size_ - 1;
+}
+
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (!tracked_[frame_id].load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (!evictable_[frame_id]) {
+    throw std::exception();
+  }
+  evictable_[frame_id] = false;
+  tracked_[frame_id].store(false, std::memory_order_relaxed);
+  referenced_[frame_id].store(false, std::memory_order_relaxed);
+  curr_size_--;
+}
+
+auto ClockReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+void ClockReplacer::EvictionOrder(size_t max_frames, std::vector<frame_id_t> *frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  frames->clear();
+  // Unreferenced frames go in the first sweep, the referenced ones in the second, both in hand order.
+  for (int pass = 0; pass < 2; pass++) {
+    const bool want_referenced = pass == 1;
+    for (size_t i = 0; i < replacer_size_ && frames->size() < max_frames; i++) {
+      const size_t frame = (hand_ + i) % replacer_size_;
+      if (evictable_[frame] && referenced_[frame].load(std::memory_order_relaxed) == want_referenced) {
+        frames->push_back(static_cast<frame_id_t>(frame));
+      }
+    }
+  }
+}
+
+}  // namespace bustub
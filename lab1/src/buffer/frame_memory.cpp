@@ -0,0 +1,180 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_memory.cpp
+//
+// Identification: src/buffer/frame_memory.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_memory.h"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <new>
+#include <string>
+
+#include "common/exception.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t HUGE_2MB = size_t{1} << 21;
+constexpr size_t HUGE_1GB = size_t{1} << 30;
+
+auto RoundUp(size_t size, size_t alignment) -> size_t { return (size + alignment - 1) / alignment * alignment; }
+
+/** @return the nodes listed in a sysfs node list such as "0-1,3", at most the first 64 */
+auto ReadNodeMask(const std::string &path) -> uint64_t {
+  std::ifstream in(path);
+  std::string list;
+  if (!(in >> list)) {
+    return 0;
+  }
+  uint64_t mask = 0;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    const std::string range = list.substr(pos, end - pos);
+    const size_t dash = range.find('-');
+    const int first = std::stoi(range.substr(0, dash));
+    const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int node = first; node <= last && node < 64; node++) {
+      mask |= uint64_t{1} << node;
+    }
+    pos = end + 1;
+  }
+  return mask;
+}
+
+/** @return the nodes that have memory, 0 if the kernel does not say */
+auto MemoryNodeMask() -> uint64_t {
+  const uint64_t mask = ReadNodeMask("/sys/devices/system/node/has_memory");
+  return mask != 0 ? mask : ReadNodeMask("/sys/devices/system/node/online");
+}
+
+/**
+ * @return the free huge pages of huge_page_size bytes on node, 0 if the kernel does not say. Pages reserved by
+ * mappings that were not touched yet count as free.
+ */
+auto FreeHugePages(int node, size_t huge_page_size) -> uint64_t {
+  std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/hugepages/hugepages-" +
+                   std::to_string(huge_page_size >> 10) + "kB/free_hugepages");
+  uint64_t free_pages = 0;
+  return in >> free_pages ? free_pages : 0;
+}
+
+/** @return an anonymous mapping of size bytes with the given extra flags, nullptr if the kernel refuses */
+auto MapAnonymous(size_t size, int flags) -> void * {
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+  return memory == MAP_FAILED ? nullptr : memory;
+}
+
+}  // namespace
+
+FrameMemory::FrameMemory(size_t num_frames, const FrameMemoryOptions &options) : num_frames_(num_frames) {
+  static_assert(BUSTUB_PAGE_SIZE % alignof(Page) == 0, "the pages must be aligned after the frame data");
+  // The frame data comes first, so that every frame starts on a page boundary of the mapping, then the pages.
+  const size_t data_size = std::max<size_t>(num_frames_, 1) * BUSTUB_PAGE_SIZE;
+  const size_t size = data_size + std::max<size_t>(num_frames_, 1) * sizeof(Page);
+  void *memory = nullptr;
+  // Huge pages come from the pool reserved through /proc/sys/vm/nr_hugepages (or the 1GB one), which may be empty.
+  if (options.page_size_ == FramePageSize::Huge1GB) {
+    mapped_size_ = RoundUp(size, HUGE_1GB);
+    memory = MapAnonymous(mapped_size_, MAP_HUGETLB | (30 << MAP_HUGE_SHIFT));
+    page_size_ = FramePageSize::Huge1GB;
+  }
+  if (memory == nullptr && options.page_size_ != FramePageSize::Default) {
+    mapped_size_ = RoundUp(size, HUGE_2MB);
+    memory = MapAnonymous(mapped_size_, MAP_HUGETLB | (21 << MAP_HUGE_SHIFT));
+    page_size_ = FramePageSize::Huge2MB;
+  }
+  if (memory == nullptr) {
+    mapped_size_ = RoundUp(size, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+    memory = MapAnonymous(mapped_size_, 0);
+    page_size_ = FramePageSize::Default;
+    if (memory != nullptr && options.page_size_ != FramePageSize::Default) {
+      // Let transparent huge pages back what they can, without a guarantee.
+      madvise(memory, mapped_size_, MADV_HUGEPAGE);
+    }
+  }
+  if (memory == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot map the buffer pool frames");
+  }
+  data_ = static_cast<char *>(memory);
+  pages_ = reinterpret_cast<Page *>(data_ + data_size);
+
+  // The policy only applies to pages not touched yet, so place the mapping before the frames are constructed.
+  numa_placed_ = PlaceOnNodes(options);
+  for (size_t i = 0; i < num_frames_; i++) {
+    new (&pages_[i]) Page(data_ + i * BUSTUB_PAGE_SIZE);
+  }
+}
+
+FrameMemory::~FrameMemory() {
+  for (size_t i = 0; i < num_frames_; i++) {
+    pages_[i].~Page();
+  }
+  munmap(data_, mapped_size_);
+}
+
+auto FrameMemory::PlaceOnNodes(const FrameMemoryOptions &options) -> bool {
+  if (options.numa_policy_ == NumaPolicy::Default) {
+    return false;
+  }
+  uint64_t nodes = MemoryNodeMask();
+  if (nodes == 0) {
+    return false;
+  }
+  int mode = MPOL_INTERLEAVE;
+  if (options.numa_policy_ == NumaPolicy::Bind) {
+    BUSTUB_ASSERT(options.numa_node_ >= 0 && options.numa_node_ < 64, "invalid NUMA node");
+    nodes &= uint64_t{1} << options.numa_node_;
+    if (nodes == 0) {
+      return false;
+    }
+    mode = MPOL_BIND;
+  }
+  if (page_size_ != FramePageSize::Default && !HasFreeHugePages(nodes)) {
+    return false;
+  }
+  unsigned long mask = nodes;  // NOLINT
+  // mbind() is not wrapped by glibc. It fails with ENOSYS without NUMA support, the frames then stay where they are.
+  return syscall(SYS_mbind, data_, mapped_size_, mode, &mask, sizeof(mask) * 8 + 1, 0) == 0;
+}
+
+auto FrameMemory::HasFreeHugePages(uint64_t nodes) const -> bool {
+  const size_t huge_page_size = page_size_ == FramePageSize::Huge1GB ? HUGE_1GB : HUGE_2MB;
+  const uint64_t num_nodes = __builtin_popcountll(nodes);
+  // Each node takes its share of the huge pages, rounded up.
+  const uint64_t share = (mapped_size_ / huge_page_size + num_nodes - 1) / num_nodes;
+  for (int node = 0; node < 64; node++) {
+    if ((nodes & (uint64_t{1} << node)) != 0 && FreeHugePages(node, huge_page_size) < share) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto FrameMemory::GetNumaNodeCount() -> int {
+  const int count = __builtin_popcountll(MemoryNodeMask());
+  return count == 0 ? 1 : count;
+}
+
+}  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// ghost_list.cpp
+//
+// Identification: src/buffer/ghost_list.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/ghost_list.h"
+
+namespace bustub {
+
+GhostList::GhostList(size_t capacity) : capacity_(capacity), nodes_(capacity) {
+  size_t slots = 2;
+  while (slots < 2 * capacity) {
+    slots *= 2;
+  }
+  index_.assign(slots, NO_NODE);
+  mask_ = static_cast<uint32_t>(slots - 1);
+  for (size_t i = capacity; i > 0; i--) {
+    nodes_[i - 1].next_ = free_;
+    free_ = static_cast<uint32_t>(i - 1);
+  }
+}
+
+auto GhostList::HomeSlot(page_id_t page_id) const -> uint32_t {
+  // Fibonacci hashing, so that consecutive page ids do not fill one probe run.
+  const uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL;
+  return static_cast<uint32_t>(hash >> 32) & mask_;
+}
+
+auto GhostList::FindSlot(page_id_t page_id) const -> uint32_t {
+  for (uint32_t slot = HomeSlot(page_id); index_[slot] != NO_NODE; slot = (slot + 1) & mask_) {
+    if (nodes_[index_[slot]].page_id_ == page_id) {
+      return slot;
+    }
+  }
+  return NO_NODE;
+}
+
+void GhostList::EraseSlot(uint32_t slot) {
+  uint32_t hole = slot;
+  for (uint32_t next = (hole + 1) & mask_; index_[next] != NO_NODE; next = (next + 1) & mask_) {
+    // An entry may move back into the hole unless its home slot lies cyclically after the hole, up to next.
+    const uint32_t home = HomeSlot(nodes_[index_[next]].page_id_);
+    if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+      index_[hole] = index_[next];
+      hole = next;
+    }
+  }
+  index_[hole] = NO_NODE;
+}
+
+void GhostList::Release(uint32_t node) {
+  Node &entry = nodes_[node];
+  (entry.prev_ == NO_NODE ? front_ : nodes_[entry.prev_].next_) = entry.next_;
+  (entry.next_ == NO_NODE ? back_ : nodes_[entry.next_].prev_) = entry.prev_;
+  entry.next_ = free_;
+  free_ = node;
+  size_--;
+}
+
+auto GhostList::Erase(page_id_t page_id) -> bool {
+  const uint32_t slot = FindSlot(page_id);
+  if (slot == NO_NODE) {
+    return false;
+  }
+  Release(index_[slot]);
+  EraseSlot(slot);
+  return true;
+}
+
+void GhostList::PushFront(page_id_t page_id) {
+  if (capacity_ == 0) {
+    return;
+  }
+  if (size_ == capacity_) {
+    PopBack();
+  }
+  const uint32_t node = free_;
+  free_ = nodes_[node].next_;
+  nodes_[node] = {page_id, NO_NODE, front_};
+  (front_ == NO_NODE ? back_ : nodes_[front_].prev_) = node;
+  front_ = node;
+  size_++;
+  uint32_t slot = HomeSlot(page_id);
+  while (index_[slot] != NO_NODE) {
+    slot = (slot + 1) & mask_;
+  }
+  index_[slot] = node;
+}
+
+void GhostList::PopBack() {
+  const uint32_t slot = FindSlot(nodes_[back_].page_id_);
+  Release(back_);
+  EraseSlot(slot);
+}
+
+}  // namespace bustub
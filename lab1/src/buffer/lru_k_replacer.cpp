@@ -12,73 +12,145 @@
 
 #include "buffer/lru_k_replacer.h"
 
-namespace bustub {
+#include <algorithm>
+#include <functional>
+#include <thread>  // NOLINT
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) {}
+namespace bustub {
 
-auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
-  std::lock_guard<std::mutex> guard(latch_);
-  if (list_.empty() && history_.empty()) {
-    return false;
-  }
-  // bool ret = false;
-
-  for (auto it = history_.rbegin(); it != history_.rend(); it++) {
-    auto frame = *it;
-    if (is_evictable_[frame]) {
-      access_count_[frame] = 0;
-      history_.erase(history_page_map_[frame]);
-      history_page_map_.erase(frame);
-      *frame_id = frame;
-      curr_size_--;
-      is_evictable_[frame] = false;
-      return true;
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k, size_t access_batch_size)
+    : replacer_size_(num_frames),
+      k_(k),
+      nodes_(num_frames),
+      has_history_(num_frames),
+      history_(num_frames * k),
+      evictable_(num_frames),
+      access_batch_size_(access_batch_size) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs at least one access of history");
+  if (access_batch_size_ > 0) {
+    access_buffers_ = std::vector<AccessBuffer>(ACCESS_BUFFER_STRIPES);
+    for (auto &buffer : access_buffers_) {
+      buffer.frames_.resize(access_batch_size_);
     }
   }
+}
 
-  for (auto it = list_.rbegin(); it != list_.rend(); it++) {
-    auto frame = *it;
-    if (is_evictable_[frame]) {
-      access_count_[frame] = 0;
-      list_.erase(cache_page_map_[frame]);
-      cache_page_map_.erase(frame);
-      *frame_id = frame;
-      curr_size_--;
-      is_evictable_[frame] = false;
-      return true;
+auto LRUKReplacer::KeyOf(frame_id_t frame_id) const -> EvictKey {
+  const auto &node = nodes_[frame_id];
+  const bool has_k = node.access_count_ >= k_;
+  const size_t oldest = has_k ? node.access_count_ % k_ : 0;
+  return {has_k, history_[frame_id * k_ + oldest]};
+}
+
+void LRUKReplacer::HeapSwap(size_t a, size_t b) {
+  std::swap(evictable_[a], evictable_[b]);
+  nodes_[evictable_[a]].heap_index_ = a;
+  nodes_[evictable_[b]].heap_index_ = b;
+}
+
+void LRUKReplacer::HeapFix(size_t i) {
+  while (i > 0 && HeapLess(i, (i - 1) / 2)) {
+    HeapSwap(i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+  while (true) {
+    size_t smallest = i;
+    for (size_t child = 2 * i + 1; child <= 2 * i + 2 && child < curr_size_; child++) {
+      if (HeapLess(child, smallest)) {
+        smallest = child;
+      }
+    }
+    if (smallest == i) {
+      return;
     }
+    HeapSwap(i, smallest);
+    i = smallest;
   }
+}
 
-  return false;
+void LRUKReplacer::HeapPush(frame_id_t frame_id) {
+  evictable_[curr_size_] = frame_id;
+  nodes_[frame_id].heap_index_ = curr_size_;
+  curr_size_++;
+  HeapFix(curr_size_ - 1);
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
-  std::scoped_lock<std::mutex> lock(latch_);
-  if (static_cast<size_t>(frame_id) > replacer_size_) {
-    throw std::exception();
+void LRUKReplacer::HeapErase(size_t i) {
+  nodes_[evictable_[i]].heap_index_ = NOT_EVICTABLE;
+  curr_size_--;
+  if (i == curr_size_) {
+    return;
   }
+  evictable_[i] = evictable_[curr_size_];
+  nodes_[evictable_[i]].heap_index_ = i;
+  HeapFix(i);
+}
 
-  access_count_[frame_id]++;
-
-  if (access_count_[frame_id] == k_) {
-    auto it = history_page_map_[frame_id];
-    history_.erase(it);
-    history_page_map_.erase(frame_id);
+auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::lock_guard<std::mutex> guard(latch_);
+  DrainAccessBuffers();
+  if (curr_size_ == 0) {
+    return false;
+  }
+  *frame_id = evictable_[0];
+  HeapErase(0);
+  nodes_[*frame_id].access_count_ = 0;
+  has_history_[*frame_id].store(false, std::memory_order_relaxed);
+  return true;
+}
 
-    list_.push_front(frame_id);
-    cache_page_map_[frame_id] = list_.begin();
-  } else if (access_count_[frame_id] > k_) {
-    if (cache_page_map_.count(frame_id) != 0U) {
-      auto it = cache_page_map_[frame_id];
-      list_.erase(it);
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  if (access_type == AccessType::Scan) {
+    if (has_history_[frame_id].load(std::memory_order_relaxed)) {
+      return;
     }
-    list_.push_front(frame_id);
-    cache_page_map_[frame_id] = list_.begin();
-  } else {
-    if (history_page_map_.count(frame_id) == 0U) {
-      history_.push_front(frame_id);
-      history_page_map_[frame_id] = history_.begin();
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (nodes_[frame_id].access_count_ == 0) {
+      DrainAccessBuffers();
+    }
+    if (nodes_[frame_id].access_count_ == 0) {
+      RecordAccessInternal(frame_id);
+    }
+    return;
+  }
+  if (access_batch_size_ == 0) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    RecordAccessInternal(frame_id);
+    return;
+  }
+
+  // Hashed once per thread, so a thread keeps appending to the same stripe.
+  thread_local const size_t stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % ACCESS_BUFFER_STRIPES;
+  auto &buffer = access_buffers_[stripe];
+  bool recorded = false;
+  while (!recorded) {
+    {
+      std::scoped_lock<std::mutex> buffer_lock(buffer.latch_);
+      if (buffer.count_ < access_batch_size_) {
+        buffer.frames_[buffer.count_++] = frame_id;
+        recorded = true;
+      }
+      if (buffer.count_ < access_batch_size_) {
+        return;
+      }
     }
+    // The stripe is full: replay it under the replacer latch, then retry if our access did not fit.
+    std::scoped_lock<std::mutex> lock(latch_);
+    DrainAccessBuffer(&buffer);
+  }
+}
+
+void LRUKReplacer::RecordAccessInternal(frame_id_t frame_id) {
+  auto &node = nodes_[frame_id];
+  history_[frame_id * k_ + node.access_count_ % k_] = current_timestamp_++;
+  if (node.access_count_++ == 0) {
+    has_history_[frame_id].store(true, std::memory_order_relaxed);
+  }
+  if (node.heap_index_ != NOT_EVICTABLE) {
+    HeapFix(node.heap_index_);
   }
 }
 
@@ -87,17 +159,20 @@ void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
   if (static_cast<size_t>(frame_id) >= replacer_size_) {
     throw std::exception();
   }
-  if (access_count_[frame_id] == 0) {
+  if (nodes_[frame_id].access_count_ == 0) {
+    // The frame's first access may still be buffered.
+    DrainAccessBuffers();
+  }
+  const auto &node = nodes_[frame_id];
+  if (node.access_count_ == 0 || (node.heap_index_ != NOT_EVICTABLE) == set_evictable) {
     return;
   }
 
-  if (!is_evictable_[frame_id] && set_evictable) {
-    curr_size_++;
-  }
-  if (is_evictable_[frame_id] && !set_evictable) {
-    curr_size_--;
+  if (set_evictable) {
+    HeapPush(frame_id);
+  } else {
+    HeapErase(node.heap_index_);
   }
-  is_evictable_[frame_id] = set_evictable;
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
@@ -105,24 +180,53 @@ void LRUKReplacer::Remove(frame_id_t frame_id) {
   if (static_cast<size_t>(frame_id) >= replacer_size_) {
     throw std::exception();
   }
-  auto cnt = access_count_[frame_id];
-  if (cnt == 0) {
+  DrainAccessBuffers();
+  auto &node = nodes_[frame_id];
+  if (node.access_count_ == 0) {
     return;
   }
-  if (!is_evictable_[frame_id]) {
+  if (node.heap_index_ == NOT_EVICTABLE) {
     throw std::exception();
   }
-  if (cnt < k_) {
-    history_.erase(history_page_map_[frame_id]);
-    history_page_map_.erase(frame_id);
+  HeapErase(node.heap_index_);
+  node.access_count_ = 0;
+  has_history_[frame_id].store(false, std::memory_order_relaxed);
+}
 
-  } else {
-    list_.erase(cache_page_map_[frame_id]);
-    cache_page_map_.erase(frame_id);
+void LRUKReplacer::EvictionOrder(size_t max_frames, std::vector<frame_id_t> *frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  DrainAccessBuffers();
+  frames->clear();
+  // Best-first walk of the heap: a node can only be next once its parent has been listed.
+  std::vector<size_t> frontier;
+  auto later = [&](size_t a, size_t b) { return HeapLess(b, a); };
+  if (curr_size_ > 0) {
+    frontier.push_back(0);
   }
-  curr_size_--;
-  access_count_[frame_id] = 0;
-  is_evictable_[frame_id] = false;
+  while (!frontier.empty() && frames->size() < max_frames) {
+    std::pop_heap(frontier.begin(), frontier.end(), later);
+    const size_t i = frontier.back();
+    frontier.pop_back();
+    frames->push_back(evictable_[i]);
+    for (size_t child = 2 * i + 1; child <= 2 * i + 2 && child < curr_size_; child++) {
+      frontier.push_back(child);
+      std::push_heap(frontier.begin(), frontier.end(), later);
+    }
+  }
+}
+
+void LRUKReplacer::DrainAccessBuffers() {
+  for (auto &buffer : access_buffers_) {
+    DrainAccessBuffer(&buffer);
+  }
+}
+
+void LRUKReplacer::DrainAccessBuffer(AccessBuffer *buffer) {
+  std::scoped_lock<std::mutex> buffer_lock(buffer->latch_);
+  for (size_t i = 0; i < buffer->count_; i++) {
+    RecordAccessInternal(buffer->frames_[i]);
+  }
+  buffer->count_ = 0;
 }
 
 auto LRUKReplacer::Size() -> size_t {
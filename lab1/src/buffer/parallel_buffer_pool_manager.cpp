@@ -0,0 +1,167 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager,
+                                                     ReplacerType replacer_type, PageTableType page_table_type,
+                                                     const FrameMemoryOptions &frame_memory,
+                                                     size_t replacer_access_batch)
+    : pool_size_(pool_size) {
+  BUSTUB_ASSERT(num_instances > 0, "A parallel BPM needs at least one instance");
+  instances_.reserve(num_instances);
+  const int num_nodes = FrameMemory::GetNumaNodeCount();
+  for (size_t i = 0; i < num_instances; i++) {
+    FrameMemoryOptions options = frame_memory;
+    if (options.numa_policy_ == NumaPolicy::Bind) {
+      options.numa_node_ = static_cast<int>(i % static_cast<size_t>(num_nodes));
+    }
+    instances_.emplace_back(std::make_unique<BufferPoolManagerInstance>(
+        pool_size, static_cast<uint32_t>(num_instances), static_cast<uint32_t>(i), disk_manager, replacer_k,
+        log_manager, replacer_type, page_table_type, options, replacer_access_batch));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() = default;
+
+auto ParallelBufferPoolManager::GetPoolSize() -> size_t { return instances_.size() * pool_size_; }
+
+auto ParallelBufferPoolManager::FetchPage(page_id_t page_id, AccessType access_type) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, access_type);
+}
+
+void ParallelBufferPoolManager::SetScanRingSize(size_t num_frames) {
+  for (auto &instance : instances_) {
+    instance->SetScanRingSize(num_frames);
+  }
+}
+
+void ParallelBufferPoolManager::StartFlusher(std::chrono::milliseconds interval, double high_watermark,
+                                             double low_watermark, size_t batch_size) {
+  for (auto &instance : instances_) {
+    instance->StartFlusher(interval, high_watermark, low_watermark, batch_size);
+  }
+}
+
+void ParallelBufferPoolManager::StopFlusher() {
+  for (auto &instance : instances_) {
+    instance->StopFlusher();
+  }
+}
+
+void ParallelBufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> per_instance(instances_.size());
+  for (auto page_id : page_ids) {
+    if (page_id != INVALID_PAGE_ID) {
+      per_instance[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+    }
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (!per_instance[i].empty()) {
+      instances_[i]->PrefetchPages(per_instance[i]);
+    }
+  }
+}
+
+void ParallelBufferPoolManager::SetReadAhead(size_t window) {
+  for (auto &instance : instances_) {
+    instance->SetReadAhead(window);
+  }
+}
+
+auto ParallelBufferPoolManager::FetchPageBasic(page_id_t page_id, AccessType access_type) -> BasicPageGuard {
+  return GetBufferPoolManager(page_id)->FetchPageBasic(page_id, access_type);
+}
+
+auto ParallelBufferPoolManager::FetchPageRead(page_id_t page_id, AccessType access_type) -> ReadPageGuard {
+  return GetBufferPoolManager(page_id)->FetchPageRead(page_id, access_type);
+}
+
+auto ParallelBufferPoolManager::FetchPageWrite(page_id_t page_id, AccessType access_type) -> WritePageGuard {
+  return GetBufferPoolManager(page_id)->FetchPageWrite(page_id, access_type);
+}
+
+auto ParallelBufferPoolManager::NewPageGuarded(page_id_t *page_id) -> BasicPageGuard {
+  Page *page = NewPgImp(page_id);
+  if (page == nullptr) {
+    return {};
+  }
+  return {GetBufferPoolManager(*page_id), page};
+}
+
+auto ParallelBufferPoolManager::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  for (auto &instance : instances_) {
+    stats.Merge(instance->GetStats());
+  }
+  return stats;
+}
+
+void ParallelBufferPoolManager::SetLatencyTracking(bool enabled) {
+  for (auto &instance : instances_) {
+    instance->SetLatencyTracking(enabled);
+  }
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  return instances_[static_cast<size_t>(page_id) % instances_.size()].get();
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+  // Only the starting point is serialized, the instances themselves are latched individually.
+  size_t start;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    start = start_index_;
+    start_index_ = (start_index_ + 1) % instances_.size();
+  }
+
+  for (size_t i = 0; i < instances_.size(); i++) {
+    auto page = instances_[(start + i) % instances_.size()]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() {
+  for (auto &instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+}  // namespace bustub
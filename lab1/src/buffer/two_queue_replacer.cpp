@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.cpp
+//
+// Identification: src/buffer/two_queue_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_queue_replacer.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace bustub {
+
+TwoQueueReplacer::TwoQueueReplacer(size_t num_frames)
+    : replacer_size_(num_frames),
+      kin_(std::max<size_t>(num_frames / 4, 1)),
+      kout_(std::max<size_t>(num_frames / 2, 1)),
+      frames_(num_frames),
+      a1_in_(&frames_),
+      am_(&frames_),
+      a1_out_(kout_) {}
+
+void TwoQueueReplacer::Enter(frame_id_t frame_id, Queue queue) {
+  auto &state = frames_[frame_id];
+  state.queue_ = queue;
+  state.stamp_ = next_stamp_++;
+  (queue == Queue::A1In ? a1_in_size_ : am_size_)++;
+  if (state.is_evictable_) {
+    ListOf(queue).PushFront(frame_id);
+  }
+}
+
+void TwoQueueReplacer::Leave(frame_id_t frame_id) {
+  auto &state = frames_[frame_id];
+  if (state.is_evictable_) {
+    ListOf(state.queue_).Erase(frame_id);
+  }
+  (state.queue_ == Queue::A1In ? a1_in_size_ : am_size_)--;
+  state.queue_ = Queue::None;
+}
+
+void TwoQueueReplacer::RememberGhost(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID || a1_out_.Contains(page_id)) {
+    return;
+  }
+  a1_out_.PushFront(page_id);
+}
+
+auto TwoQueueReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (curr_size_ == 0) {
+    return false;
+  }
+  // Fall back to the other queue when the preferred one has nothing evictable.
+  bool from_a1_in = a1_in_size_ > kin_;
+  if ((from_a1_in ? a1_in_ : am_).Empty()) {
+    from_a1_in = !from_a1_in;
+  }
+  *frame_id = (from_a1_in ? a1_in_ : am_).Back();
+
+  auto &state = frames_[*frame_id];
+  if (from_a1_in) {
+    RememberGhost(state.page_id_);
+  }
+  Leave(*frame_id);
+  state.is_evictable_ = false;
+  state.page_id_ = INVALID_PAGE_ID;
+  curr_size_--;
+  return true;
+}
+
+void TwoQueueReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &state = frames_[frame_id];
+  if (access_type == AccessType::Scan) {
+    // Scanned pages never reach Am, not even through A1out.
+    if (state.queue_ == Queue::None) {
+      a1_out_.Erase(state.page_id_);
+      Enter(frame_id, Queue::A1In);
+    }
+    return;
+  }
+  switch (state.queue_) {
+    case Queue::Am:
+      break;
+    case Queue::A1In:
+      if (state.page_id_ != INVALID_PAGE_ID) {
+        return;  // correlated reference, A1out decides whether the page is hot
+      }
+      break;
+    case Queue::None:
+      if (!a1_out_.Erase(state.page_id_)) {
+        Enter(frame_id, Queue::A1In);
+        return;
+      }
+      Enter(frame_id, Queue::Am);
+      return;
+  }
+  Leave(frame_id);
+  Enter(frame_id, Queue::Am);
+}
+
+void TwoQueueReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &state = frames_[frame_id];
+  if (state.queue_ == Queue::None || state.is_evictable_ == set_evictable) {
+    return;
+  }
+  state.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    ListOf(state.queue_).Insert(frame_id);
+    curr_size_++;
+  } else {
+    ListOf(state.queue_).Erase(frame_id);
+    curr_size_--;
+  }
+}
+
+void TwoQueueReplacer::Remove(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &state = frames_[frame_id];
+  if (state.queue_ == Queue::None) {
+    return;
+  }
+  if (!state.is_evictable_) {
+    throw std::exception();
+  }
+  Leave(frame_id);
+  state.is_evictable_ = false;
+  state.page_id_ = INVALID_PAGE_ID;
+  curr_size_--;
+}
+
+auto TwoQueueReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+void TwoQueueReplacer::EvictionOrder(size_t max_frames, std::vector<frame_id_t> *frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  frames->clear();
+  // Replay Evict()'s queue choice: A1in is preferred while it is longer than kin_, and shrinks with every victim.
+  constexpr frame_id_t none = FrameList<FrameState>::NONE;
+  frame_id_t a1_next = a1_in_.Back();
+  frame_id_t am_next = am_.Back();
+  size_t a1_in_size = a1_in_size_;
+  while (frames->size() < max_frames && (a1_next != none || am_next != none)) {
+    if (a1_next != none && (a1_in_size > kin_ || am_next == none)) {
+      frames->push_back(a1_next);
+      a1_next = a1_in_.Prev(a1_next);
+      a1_in_size--;
+    } else {
+      frames->push_back(am_next);
+      am_next = am_.Prev(am_next);
+    }
+  }
+}
+
+void TwoQueueReplacer::SetFramePage(frame_id_t frame_id, page_id_t page_id) {
+  if (static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw std::exception();
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  frames_[frame_id].page_id_ = page_id;
+}
+
+}  // namespace bustub
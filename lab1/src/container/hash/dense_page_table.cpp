@@ -0,0 +1,151 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// dense_page_table.cpp
+//
+// Identification: src/container/hash/dense_page_table.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/dense_page_table.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+DensePageTable::Leaf::Leaf(DensePageTable *table) : table_(table) {
+  for (auto &frame : frames_) {
+    frame.store(NO_FRAME, std::memory_order_relaxed);
+  }
+}
+
+DensePageTable::DensePageTable(uint32_t stride, uint32_t offset, size_t pool_size)
+    : stride_(stride),
+      offset_(offset),
+      root_size_((static_cast<size_t>(std::numeric_limits<page_id_t>::max()) / stride >> (LEAF_BITS + MID_BITS)) + 1),
+      root_(new std::atomic<Mid *>[root_size_]),
+      max_free_leaves_(std::max(pool_size / LEAF_SIZE, MIN_FREE_LEAVES)),
+      overflow_(4) {
+  BUSTUB_ASSERT(stride > 0 && offset < stride, "offset must name one of the stride shards");
+  free_leaves_.reserve(max_free_leaves_);
+  for (size_t i = 0; i < root_size_; i++) {
+    root_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+DensePageTable::~DensePageTable() {
+  for (size_t i = 0; i < root_size_; i++) {
+    Mid *mid = root_[i].load(std::memory_order_relaxed);
+    if (mid == nullptr) {
+      continue;
+    }
+    for (auto &leaf : mid->leaves_) {
+      delete leaf.load(std::memory_order_relaxed);
+    }
+    delete mid;
+  }
+}
+
+auto DensePageTable::LeafOf(size_t index) const -> Leaf * {
+  Mid *mid = root_[index >> (LEAF_BITS + MID_BITS)].load(std::memory_order_acquire);
+  if (mid == nullptr) {
+    return nullptr;
+  }
+  return mid->leaves_[(index >> LEAF_BITS) & (MID_SIZE - 1)].load(std::memory_order_acquire);
+}
+
+auto DensePageTable::CreateLeafOf(size_t index) -> Leaf * {
+  auto &mid_slot = root_[index >> (LEAF_BITS + MID_BITS)];
+  Mid *mid = mid_slot.load(std::memory_order_relaxed);
+  if (mid == nullptr) {
+    mid = new Mid();
+    mid_slot.store(mid, std::memory_order_release);
+  }
+  auto &leaf_slot = mid->leaves_[(index >> LEAF_BITS) & (MID_SIZE - 1)];
+  Leaf *leaf = leaf_slot.load(std::memory_order_relaxed);
+  if (leaf == nullptr) {
+    if (free_leaves_.empty()) {
+      leaf = new Leaf(this);
+    } else {
+      // Every entry of a recycled leaf is already NO_FRAME.
+      leaf = free_leaves_.back().release();
+      free_leaves_.pop_back();
+    }
+    leaf_slot.store(leaf, std::memory_order_release);
+  }
+  return leaf;
+}
+
+void DensePageTable::RetireLeafOf(size_t index) {
+  Mid *mid = root_[index >> (LEAF_BITS + MID_BITS)].load(std::memory_order_relaxed);
+  auto &leaf_slot = mid->leaves_[(index >> LEAF_BITS) & (MID_SIZE - 1)];
+  // Lookups that loaded the old pointer are pinned, so the leaf is not reused under them.
+  epochs_.Retire(leaf_slot.exchange(nullptr, std::memory_order_acq_rel),
+                 [](void *leaf) { static_cast<Leaf *>(leaf)->table_->RecycleLeaf(static_cast<Leaf *>(leaf)); });
+}
+
+void DensePageTable::RecycleLeaf(Leaf *leaf) {
+  if (free_leaves_.size() < max_free_leaves_) {
+    free_leaves_.emplace_back(leaf);
+  } else {
+    delete leaf;
+  }
+}
+
+auto DensePageTable::Find(const page_id_t &page_id, frame_id_t &frame_id) -> bool {
+  size_t index;
+  if (!IndexOf(page_id, &index)) {
+    return overflow_.Find(page_id, frame_id);
+  }
+  auto guard = epochs_.Pin();
+  Leaf *leaf = LeafOf(index);
+  if (leaf == nullptr) {
+    return false;
+  }
+  const frame_id_t frame = leaf->frames_[index & (LEAF_SIZE - 1)].load(std::memory_order_acquire);
+  if (frame == NO_FRAME) {
+    return false;
+  }
+  frame_id = frame;
+  return true;
+}
+
+void DensePageTable::Insert(const page_id_t &page_id, const frame_id_t &frame_id) {
+  size_t index;
+  if (!IndexOf(page_id, &index)) {
+    overflow_.Insert(page_id, frame_id);
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  Leaf *leaf = CreateLeafOf(index);
+  if (leaf->frames_[index & (LEAF_SIZE - 1)].exchange(frame_id, std::memory_order_release) == NO_FRAME) {
+    leaf->live_++;
+  }
+}
+
+auto DensePageTable::Remove(const page_id_t &page_id) -> bool {
+  size_t index;
+  if (!IndexOf(page_id, &index)) {
+    return overflow_.Remove(page_id);
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  Leaf *leaf = LeafOf(index);
+  if (leaf == nullptr) {
+    return false;
+  }
+  if (leaf->frames_[index & (LEAF_SIZE - 1)].exchange(NO_FRAME, std::memory_order_relaxed) == NO_FRAME) {
+    return false;
+  }
+  if (--leaf->live_ == 0) {
+    RetireLeafOf(index);
+  }
+  return true;
+}
+
+}  // namespace bustub
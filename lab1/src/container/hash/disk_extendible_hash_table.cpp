@@ -0,0 +1,385 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_extendible_hash_table.cpp
+//
+// Identification: src/container/hash/disk_extendible_hash_table.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/disk_extendible_hash_table.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+DiskExtendibleHashTable<K, V, Hash, KeyEqual>::DiskExtendibleHashTable(BufferPoolManager *bpm, page_id_t header_page_id,
+                                                                       const Hash &hash_fn, double merge_fill,
+                                                                       uint32_t header_max_depth)
+    : bpm_(bpm),
+      header_page_id_(header_page_id),
+      hash_fn_(hash_fn),
+      merge_threshold_(static_cast<uint32_t>(merge_fill * BucketPage::BUCKET_ARRAY_SIZE)) {
+  BUSTUB_ASSERT(merge_fill >= 0 && merge_fill <= 1, "merge_fill must be a fraction of a bucket");
+  if (header_page_id_ != INVALID_PAGE_ID) {
+    Page *header_page = bpm_->FetchPage(header_page_id_);
+    if (header_page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "the buffer pool has no frame for the hash table header");
+    }
+    const bool is_header = AsHeader(header_page)->IsHeaderOf(header_page_id_);
+    bpm_->UnpinPage(header_page_id_, false);
+    if (!is_header) {
+      throw Exception(ExceptionType::INVALID, "page is not the header of a hash table");
+    }
+    return;
+  }
+
+  Page *header_page = bpm_->NewPage(&header_page_id_);
+  if (header_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "the buffer pool has no frame for the hash table header");
+  }
+  AsHeader(header_page)->Init(header_page_id_, header_max_depth);
+  bpm_->UnpinPage(header_page_id_, true);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+auto DiskExtendibleHashTable<K, V, Hash, KeyEqual>::DirectoryOf(uint32_t hash, page_id_t *directory_page_id) -> bool {
+  Page *header_page = bpm_->FetchPage(header_page_id_);
+  if (header_page == nullptr) {
+    return false;
+  }
+  auto *header = AsHeader(header_page);
+  *directory_page_id = header->GetDirectoryPageId(header->HashToDirectoryIndex(hash));
+  bpm_->UnpinPage(header_page_id_, false);
+  return true;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+auto DiskExtendibleHashTable<K, V, Hash, KeyEqual>::BucketOf(uint32_t hash, page_id_t *bucket_page_id,
+                                                             uint32_t *local_depth) -> bool {
+  page_id_t directory_page_id;
+  if (!DirectoryOf(hash, &directory_page_id)) {
+    return false;
+  }
+  *bucket_page_id = INVALID_PAGE_ID;
+  if (directory_page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  // The page ids read here stay valid after the unpin, only holders of the exclusive table latch change them.
+  Page *dir_page = bpm_->FetchPage(directory_page_id);
+  if (dir_page == nullptr) {
+    return false;
+  }
+  auto *dir = AsDirectory(dir_page);
+  const uint32_t bucket_idx = hash & dir->GetGlobalDepthMask();
+  *bucket_page_id = dir->GetBucketPageId(bucket_idx);
+  *local_depth = dir->GetLocalDepth(bucket_idx);
+  bpm_->UnpinPage(directory_page_id, false);
+  return true;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+auto DiskExtendibleHashTable<K, V, Hash, KeyEqual>::CreateDirectory(uint32_t hash, page_id_t *directory_page_id)
+    -> bool {
+  Page *header_page = bpm_->FetchPage(header_page_id_);
+  if (header_page == nullptr) {
+    return false;
+  }
+  Page *dir_page = bpm_->NewPage(directory_page_id);
+  if (dir_page == nullptr) {
+    bpm_->UnpinPage(header_page_id_, false);
+    return false;
+  }
+  page_id_t bucket_page_id;
+  Page *bucket_page = bpm_->NewPage(&bucket_page_id);
+  if (bucket_page == nullptr) {
+    bpm_->UnpinPage(*directory_page_id, false);
+    bpm_->DeletePage(*directory_page_id);
+    bpm_->UnpinPage(header_page_id_, false);
+    return false;
+  }
+  AsBucket(bucket_page)->Init();
+  auto *dir = AsDirectory(dir_page);
+  dir->Init(*directory_page_id);
+  dir->SetBucketPageId(0, bucket_page_id);
+  auto *header = AsHeader(header_page);
+  header->SetDirectoryPageId(header->HashToDirectoryIndex(hash), *directory_page_id);
+  bpm_->UnpinPage(bucket_page_id, true);
+  bpm_->UnpinPage(*directory_page_id, true);
+  bpm_->UnpinPage(header_page_id_, true);
+  return true;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+auto DiskExtendibleHashTable<K, V, Hash, KeyEqual>::Find(const K &key, V *value) -> bool {
+  table_latch_.RLock();
+  page_id_t bucket_page_id;
+  uint32_t local_depth;
+  bool found = false;
+  if (BucketOf(HashOf(key), &bucket_page_id, &local_depth) && bucket_page_id != INVALID_PAGE_ID) {
+    Page *page = bpm_->FetchPage(bucket_page_id);
+    if (page != nullptr) {
+      page->RLatch();
+      found = AsBucket(page)->Find(key, value, key_equal_);
+      page->RUnlatch();
+      bpm_->UnpinPage(bucket_page_id, false);
+    }
+  }
+  table_latch_.RUnlock();
+  return found;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+auto DiskExtendibleHashTable<K, V, Hash, KeyEqual>::Insert(const K &key, const V &value) -> bool {
+  table_latch_.RLock();
+  page_id_t bucket_page_id;
+  uint32_t local_depth;
+  if (!BucketOf(HashOf(key), &bucket_page_id, &local_depth)) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  if (bucket_page_id != INVALID_PAGE_ID) {
+    Page *page = bpm_->FetchPage(bucket_page_id);
+    if (page == nullptr) {
+      table_latch_.RUnlock();
+      return false;
+    }
+    page->WLatch();
+    const bool inserted = AsBucket(page)->Insert(key, value, key_equal_);
+    page->WUnlatch();
+    bpm_->UnpinPage(bucket_page_id, inserted);
+    if (inserted) {
+      table_latch_.RUnlock();
+      return true;
+    }
+  }
+  table_latch_.RUnlock();
+  // The bucket is full or its directory is missing. Another thread may fix either before we get the latch,
+  // SplitInsert() starts over.
+  return SplitInsert(key, value);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+auto DiskExtendibleHashTable<K, V, Hash, KeyEqual>::SplitInsert(const K &key, const V &value) -> bool {
+  table_latch_.WLock();
+  const uint32_t hash = HashOf(key);
+  page_id_t directory_page_id;
+  if (!DirectoryOf(hash, &directory_page_id) ||
+      (directory_page_id == INVALID_PAGE_ID && !CreateDirectory(hash, &directory_page_id))) {
+    table_latch_.WUnlock();
+    return false;
+  }
+  Page *dir_page = bpm_->FetchPage(directory_page_id);
+  if (dir_page == nullptr) {
+    table_latch_.WUnlock();
+    return false;
+  }
+  auto *dir = AsDirectory(dir_page);
+  bool dir_dirty = false;
+  bool inserted = false;
+  while (true) {
+    // Nobody else holds a page of the table while we hold the latch exclusively, page latches are not needed.
+    const uint32_t bucket_idx = hash & dir->GetGlobalDepthMask();
+    const page_id_t bucket_page_id = dir->GetBucketPageId(bucket_idx);
+    Page *bucket_page = bpm_->FetchPage(bucket_page_id);
+    if (bucket_page == nullptr) {
+      break;
+    }
+    auto *bucket = AsBucket(bucket_page);
+    if (bucket->Insert(key, value, key_equal_)) {
+      bpm_->UnpinPage(bucket_page_id, true);
+      inserted = true;
+      break;
+    }
+    const uint32_t depth = dir->GetLocalDepth(bucket_idx);
+    if (depth == HashTableDirectoryPage::MAX_DEPTH) {
+      bpm_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    page_id_t image_page_id;
+    Page *image_page = bpm_->NewPage(&image_page_id);
+    if (image_page == nullptr) {
+      bpm_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    if (depth == dir->GetGlobalDepth()) {
+      dir->IncrGlobalDepth();
+    }
+
+    auto *image = AsBucket(image_page);
+    image->Init();
+    // Entries whose next hash bit is set move to the split image.
+    const uint32_t bit = 1U << depth;
+    for (uint32_t i = 0; i < bucket->NumEntries();) {
+      if ((HashOf(bucket->EntryAt(i).key_) & bit) != 0) {
+        image->Append(bucket->EntryAt(i));
+        bucket->RemoveAt(i);
+      } else {
+        i++;
+      }
+    }
+    // The bucket filled every slot that agrees with the key on the low depth bits, its image takes the half of them
+    // with the new bit set.
+    for (uint32_t i = hash & (bit - 1); i < dir->Size(); i += bit) {
+      dir->SetLocalDepth(i, depth + 1);
+      if ((i & bit) != 0) {
+        dir->SetBucketPageId(i, image_page_id);
+      }
+    }
+    dir_dirty = true;
+    bpm_->UnpinPage(image_page_id, true);
+    bpm_->UnpinPage(bucket_page_id, true);
+  }
+  bpm_->UnpinPage(directory_page_id, dir_dirty);
+  table_latch_.WUnlock();
+  return inserted;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+auto DiskExtendibleHashTable<K, V, Hash, KeyEqual>::Remove(const K &key) -> bool {
+  table_latch_.RLock();
+  page_id_t bucket_page_id;
+  uint32_t local_depth;
+  if (!BucketOf(HashOf(key), &bucket_page_id, &local_depth) || bucket_page_id == INVALID_PAGE_ID) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  Page *page = bpm_->FetchPage(bucket_page_id);
+  if (page == nullptr) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  page->WLatch();
+  auto *bucket = AsBucket(page);
+  const bool removed = bucket->Remove(key, key_equal_);
+  const bool underfull = removed && bucket->NumEntries() <= merge_threshold_ && local_depth > 0;
+  page->WUnlatch();
+  bpm_->UnpinPage(bucket_page_id, removed);
+  table_latch_.RUnlock();
+  if (underfull) {
+    Merge(key);
+  }
+  return removed;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void DiskExtendibleHashTable<K, V, Hash, KeyEqual>::Merge(const K &key) {
+  table_latch_.WLock();
+  const uint32_t hash = HashOf(key);
+  page_id_t directory_page_id;
+  Page *dir_page = nullptr;
+  // A merge that cannot fetch its pages is left to a later Remove(), the table is fine unmerged.
+  if (DirectoryOf(hash, &directory_page_id) && directory_page_id != INVALID_PAGE_ID) {
+    dir_page = bpm_->FetchPage(directory_page_id);
+  }
+  if (dir_page == nullptr) {
+    table_latch_.WUnlock();
+    return;
+  }
+  auto *dir = AsDirectory(dir_page);
+  bool dir_dirty = false;
+  while (true) {
+    const uint32_t bucket_idx = hash & dir->GetGlobalDepthMask();
+    const uint32_t depth = dir->GetLocalDepth(bucket_idx);
+    if (depth == 0) {
+      break;
+    }
+    const uint32_t image_idx = dir->GetSplitImageIndex(bucket_idx);
+    if (dir->GetLocalDepth(image_idx) != depth) {
+      // The image has been split further, it can only come back once its own halves merge.
+      break;
+    }
+    const page_id_t bucket_page_id = dir->GetBucketPageId(bucket_idx);
+    const page_id_t image_page_id = dir->GetBucketPageId(image_idx);
+    Page *bucket_page = bpm_->FetchPage(bucket_page_id);
+    if (bucket_page == nullptr) {
+      break;
+    }
+    Page *image_page = bpm_->FetchPage(image_page_id);
+    if (image_page == nullptr) {
+      bpm_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    auto *bucket = AsBucket(bucket_page);
+    auto *image = AsBucket(image_page);
+    if (bucket->NumEntries() + image->NumEntries() > merge_threshold_) {
+      bpm_->UnpinPage(image_page_id, false);
+      bpm_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    for (uint32_t i = 0; i < image->NumEntries(); i++) {
+      bucket->Append(image->EntryAt(i));
+    }
+    bpm_->UnpinPage(image_page_id, false);
+    bpm_->DeletePage(image_page_id);
+    bpm_->UnpinPage(bucket_page_id, true);
+
+    // The merged bucket takes every slot that agrees with the key on the low depth - 1 bits.
+    const uint32_t stride = 1U << (depth - 1);
+    for (uint32_t i = hash & (stride - 1); i < dir->Size(); i += stride) {
+      dir->SetBucketPageId(i, bucket_page_id);
+      dir->SetLocalDepth(i, depth - 1);
+    }
+    while (dir->CanShrink()) {
+      dir->DecrGlobalDepth();
+    }
+    dir_dirty = true;
+  }
+  bpm_->UnpinPage(directory_page_id, dir_dirty);
+  table_latch_.WUnlock();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+auto DiskExtendibleHashTable<K, V, Hash, KeyEqual>::GetGlobalDepth() -> uint32_t {
+  table_latch_.RLock();
+  uint32_t depth = 0;
+  Page *header_page = bpm_->FetchPage(header_page_id_);
+  if (header_page != nullptr) {
+    auto *header = AsHeader(header_page);
+    for (uint32_t i = 0; i < header->MaxSize(); i++) {
+      const page_id_t directory_page_id = header->GetDirectoryPageId(i);
+      Page *dir_page = directory_page_id == INVALID_PAGE_ID ? nullptr : bpm_->FetchPage(directory_page_id);
+      if (dir_page != nullptr) {
+        depth = std::max(depth, AsDirectory(dir_page)->GetGlobalDepth());
+        bpm_->UnpinPage(directory_page_id, false);
+      }
+    }
+    bpm_->UnpinPage(header_page_id_, false);
+  }
+  table_latch_.RUnlock();
+  return depth;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void DiskExtendibleHashTable<K, V, Hash, KeyEqual>::VerifyIntegrity() {
+  table_latch_.RLock();
+  Page *header_page = bpm_->FetchPage(header_page_id_);
+  BUSTUB_ASSERT(header_page != nullptr, "the buffer pool has no frame to verify the header");
+  auto *header = AsHeader(header_page);
+  BUSTUB_ASSERT(header->GetMaxDepth() <= HashTableHeaderPage::MAX_DEPTH, "the header depth exceeds its page");
+  for (uint32_t i = 0; i < header->MaxSize(); i++) {
+    const page_id_t directory_page_id = header->GetDirectoryPageId(i);
+    if (directory_page_id == INVALID_PAGE_ID) {
+      continue;
+    }
+    Page *dir_page = bpm_->FetchPage(directory_page_id);
+    BUSTUB_ASSERT(dir_page != nullptr, "the buffer pool has no frame to verify a directory");
+    BUSTUB_ASSERT(AsDirectory(dir_page)->GetPageId() == directory_page_id, "a header slot points at a non-directory");
+    AsDirectory(dir_page)->VerifyIntegrity();
+    bpm_->UnpinPage(directory_page_id, false);
+  }
+  bpm_->UnpinPage(header_page_id_, false);
+  table_latch_.RUnlock();
+}
+
+template class DiskExtendibleHashTable<int, int>;
+template class DiskExtendibleHashTable<int64_t, int64_t>;
+
+}  // namespace bustub
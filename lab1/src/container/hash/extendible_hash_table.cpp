@@ -10,208 +10,694 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <memory>
+#include <new>
 #include <utility>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "container/hash/extendible_hash_table.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
-template <typename K, typename V>
-ExtendibleHashTable<K, V>::ExtendibleHashTable(size_t bucket_size)
-    : global_depth_(0), bucket_size_(bucket_size), num_buckets_(1) {
-  dir_.push_back(std::make_shared<Bucket>(0));
+template <typename K, typename V, typename Hash>
+ExtendibleHashTable<K, V, Hash>::ExtendibleHashTable(size_t bucket_size, const Hash &hash_fn, double merge_fill)
+    : bucket_size_(bucket_size),
+      merge_threshold_(static_cast<size_t>(merge_fill * static_cast<double>(bucket_size))),
+      num_buckets_(1),
+      dir_(new Directory(0)),
+      hash_fn_(hash_fn) {
+  BUSTUB_ASSERT(merge_fill >= 0 && merge_fill <= 1, "merge_fill must be a fraction of a bucket");
+  for (auto &count : at_depth_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  at_depth_[0].store(1, std::memory_order_relaxed);
+  dir_.load()->slots_[0].store(Bucket::Create(bucket_size_));
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::IndexOf(const K &key) -> size_t {
-  int mask = (1 << global_depth_) - 1;
-  return std::hash<K>()(key) & mask;
+template <typename K, typename V, typename Hash>
+ExtendibleHashTable<K, V, Hash>::~ExtendibleHashTable() {
+  Directory *dir = dir_.load();
+  for (size_t i = 0; i < dir->slots_.size(); i++) {
+    // A bucket of local depth d fills every 2^d-th slot, free it at the last of them.
+    Bucket *bucket = dir->slots_[i].load(std::memory_order_relaxed);
+    if (i + (size_t{1} << bucket->GetDepth()) >= dir->slots_.size()) {
+      Bucket::Destroy(bucket);
+    }
+  }
+  delete dir;
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetGlobalDepth() const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::IndexOf(const K &key) -> size_t {
+  int mask = (1 << GetGlobalDepthInternal()) - 1;
+  return HashOf(key) & mask;
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetGlobalDepth() const -> int {
+  auto guard = epochs_.Pin();
   return GetGlobalDepthInternal();
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetGlobalDepthInternal() const -> int {
-  return global_depth_;
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetGlobalDepthInternal() const -> int {
+  return dir_.load()->global_depth_;
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetLocalDepth(int dir_index) const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
-  return GetLocalDepthInternal(dir_index);
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetLocalDepth(int dir_index) const -> int {
+  auto guard = epochs_.Pin();
+  while (true) {
+    // The slot index agrees with the hashes that map to it on the low bits, which is all Covers() looks at.
+    Bucket *bucket = dir_.load()->slots_[dir_index].load();
+    bucket->RLatch();
+    if (bucket->Covers(dir_index)) {
+      int depth = bucket->GetDepth();
+      bucket->RUnlatch();
+      return depth;
+    }
+    bucket->RUnlatch();
+  }
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetLocalDepthInternal(int dir_index) const -> int {
-  return dir_[dir_index]->GetDepth();
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetLocalDepthInternal(int dir_index) const -> int {
+  return dir_.load()->slots_[dir_index].load()->GetDepth();
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetNumBuckets() const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetNumBuckets() const -> int {
   return GetNumBucketsInternal();
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetNumBucketsInternal() const -> int {
-  return num_buckets_;
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetNumBucketsInternal() const -> int {
+  return num_buckets_.load();
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Find(const K &key, V &value) -> bool {
-  // UNREACHABLE("not implemented");
-  std::scoped_lock<std::mutex> lock(latch_);
-  size_t index = IndexOf(key);
-  /* if (index > dir_.size() - 1) {
-    return false;
-  } */
-  auto bucket = dir_[index];
-  /* auto list = bucket->GetItems();
-  bool ret = false;
-  for (std::pair<K, V> &p : list) {
-    if (key == p.first) {
-      value = p.second;
-      ret = true;
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::LatchBucket(size_t hash, bool write) -> Bucket * {
+  // The caller's guard is held while waiting for the latch, a bucket merged away meanwhile is only freed after it.
+  while (true) {
+    Bucket *bucket = dir_.load()->SlotOf(hash).load();
+    if (write) {
+      bucket->WLatch();
+    } else {
+      bucket->RLatch();
     }
-  } */
-  // bool ret = bucket->Find(key,value);
+    if (bucket->Covers(hash)) {
+      return bucket;
+    }
+    // The bucket was split or merged after we read its slot, the key lives elsewhere now.
+    Bump(&stats_.Local().latch_retries_);
+    if (write) {
+      bucket->WUnlatch();
+    } else {
+      bucket->RUnlatch();
+    }
+  }
+}
 
-  return bucket->Find(key, value);
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Find(const K &key, V &value) -> bool {
+  auto guard = epochs_.Pin();
+  return FindHashed(HashOf(key), key, value);
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Remove(const K &key) -> bool {
-  // UNREACHABLE("not implemented");
-  std::scoped_lock<std::mutex> lock(latch_);
-  bool ret = false;
-  size_t index = IndexOf(key);
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::FindHashed(size_t hash, const K &key, V &value) -> bool {
+  auto &stats = stats_.Local();
+  Bump(&stats.finds_);
+  if constexpr (Bucket::OPTIMISTIC_READS) {
+    for (int attempt = 0; attempt < OPTIMISTIC_RETRIES; attempt++) {
+      // Reloading the directory on every attempt picks up a doubling that made the old slot stale.
+      const Bucket *bucket = dir_.load()->SlotOf(hash).load();
+      auto result = bucket->OptimisticFind(hash, key, value);
+      if (result != Bucket::ReadResult::Retry) {
+        if (result == Bucket::ReadResult::Found) {
+          Bump(&stats.find_hits_);
+          return true;
+        }
+        return false;
+      }
+    }
+  }
+  // Writers keep winning the race (or the bucket has to be latched anyway), wait for them instead of spinning.
+  Bump(&stats.latched_finds_);
+  Bucket *bucket = LatchBucket(hash, false);
+  bool found = bucket->Find(hash, key, value);
+  bucket->RUnlatch();
+  if (found) {
+    Bump(&stats.find_hits_);
+  }
+  return found;
+}
 
-  /* if (index > dir_.size() - 1) {
-    return false;
-  } */
-  auto bucket = dir_[index];
-  auto list = bucket->GetItems();
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Remove(const K &key) -> bool {
+  Bump(&stats_.Local().removes_);
+  const size_t hash = HashOf(key);
+  bool merged;
+  {
+    auto guard = epochs_.Pin();
+    Bucket *bucket = LatchBucket(hash, true);
+    if (!bucket->Remove(hash, key)) {
+      bucket->WUnlatch();
+      return false;
+    }
+    const int depth = bucket->GetDepth();
+    bucket = MergeBucket(bucket);
+    merged = bucket->GetDepth() < depth;
+    bucket->WUnlatch();
+  }
+  if (merged) {
+    ShrinkDirectory();
+  }
+  return true;
+}
 
-  if (bucket == nullptr || list.empty()) {
-    return false;
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::Insert(const K &key, const V &value) {
+  Bump(&stats_.Local().inserts_);
+  const size_t hash = HashOf(key);
+  while (true) {
+    auto guard = epochs_.Pin();
+    Bucket *bucket = LatchBucket(hash, true);
+    // Bucket::Insert() updates an existing key even when the bucket is full.
+    if (bucket->Insert(hash, key, value)) {
+      bucket->WUnlatch();
+      return;
+    }
+
+    if (!SplitBucket(bucket)) {
+      // Doubling only copies directory slots, it does not need the bucket.
+      const int depth = bucket->GetDepth();
+      bucket->WUnlatch();
+      GrowDirectory(depth);
+      continue;
+    }
+    bucket->WUnlatch();
   }
+}
 
-  ret = bucket->Remove(key);
-  // ret = true;
-  return ret;
+namespace {
+
+/** Reverse the bits of a hash, so that sorting by the result groups hashes by their low bits at every depth. */
+constexpr auto ReverseBits(uint64_t x) -> uint64_t {
+  x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+  x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+  x = ((x >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((x & 0x0f0f0f0f0f0f0f0fULL) << 4);
+  return __builtin_bswap64(x);
 }
 
-template <typename K, typename V>
-void ExtendibleHashTable<K, V>::Insert(const K &key, const V &value) {
-  // UNREACHABLE("not implemented");
-  std::scoped_lock<std::mutex> lock(latch_);
-  // auto index = IndexOf(key);
+}  // namespace
 
-  /*if (index < 0) {
-    return;
-  }*/
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::InsertBatch(const std::vector<std::pair<K, V>> &entries) {
+  Bump(&stats_.Local().inserts_, entries.size());
+  // Sorting on (reversed hash, position) keeps repeated keys in batch order, so the last value wins.
+  std::vector<std::pair<uint64_t, size_t>> order;
+  order.reserve(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    order.emplace_back(ReverseBits(HashOf(entries[i].first)), i);
+  }
+  std::sort(order.begin(), order.end());
 
-  // auto list = bucket->GetItems();
-  // std::cout << dir_.size() << std::endl;
-  while (dir_[IndexOf(key)]->IsFull()) {  // 若要插入的桶已满，则桶深度和全局深度加1，并线将dir数量翻倍
-    auto index = IndexOf(key);
-    auto bucket = dir_[index];
-    if (bucket->GetDepth() == GetGlobalDepthInternal()) {
-      size_t length = dir_.size();
-      for (size_t i = 0; i < length; i++) {
-        dir_.push_back(dir_[i]);
+  size_t next = 0;
+  while (next < order.size()) {
+    auto guard = epochs_.Pin();
+    Bucket *bucket = LatchBucket(ReverseBits(order[next].first), true);
+    bool full = false;
+    for (; next < order.size(); next++) {
+      const size_t hash = ReverseBits(order[next].first);
+      const auto &[key, value] = entries[order[next].second];
+      if (!bucket->Covers(hash)) {
+        break;
       }
-      global_depth_++;
+      if (!bucket->Insert(hash, key, value)) {
+        full = true;
+        break;
+      }
+    }
+    if (full && !SplitBucket(bucket)) {
+      const int depth = bucket->GetDepth();
+      bucket->WUnlatch();
+      GrowDirectory(depth);
+      continue;
     }
+    bucket->WUnlatch();
+  }
+}
 
-    auto bucket1 = std::make_shared<Bucket>(bucket_size_, bucket->GetDepth() + 1);
-    auto bucket2 = std::make_shared<Bucket>(bucket_size_, bucket->GetDepth() + 1);
-    int mask = 1 << bucket->GetDepth();
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::FindBatch(const std::vector<K> &keys, std::vector<V> *values,
+                                                std::vector<bool> *found) -> size_t {
+  const size_t n = keys.size();
+  std::vector<size_t> hashes(n);
+  for (size_t i = 0; i < n; i++) {
+    hashes[i] = HashOf(keys[i]);
+  }
+  values->resize(n);
+  found->assign(n, false);
 
-    for (std::pair<K, V> &item : bucket->GetItems()) {
-      if (std::hash<K>{}(item.first) & mask) {
-        bucket1->Insert(item.first, item.second);
-      } else {
-        bucket2->Insert(item.first, item.second);
-      }
+  size_t hits = 0;
+  auto guard = epochs_.Pin();
+  // Only used for prefetching, a directory replaced meanwhile stays valid under the guard and merely misses.
+  const Directory *dir = dir_.load();
+  for (size_t i = 0; i < n; i++) {
+    if (i + 2 * PREFETCH_DISTANCE < n) {
+      __builtin_prefetch(&dir->SlotOf(hashes[i + 2 * PREFETCH_DISTANCE]));
     }
-    num_buckets_++;
-    for (size_t i = 0; i < dir_.size(); i++) {
-      if (dir_[i] == bucket) {
-        if ((i & mask) != 0U) {
-          dir_[i] = bucket1;
-        } else {
-          dir_[i] = bucket2;
-        }
+    if (i + PREFETCH_DISTANCE < n) {
+      dir->SlotOf(hashes[i + PREFETCH_DISTANCE]).load(std::memory_order_relaxed)->Prefetch(bucket_size_);
+    }
+    if (FindHashed(hashes[i], keys[i], (*values)[i])) {
+      (*found)[i] = true;
+      hits++;
+    }
+  }
+  return hits;
+}
+
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::Reserve(size_t count) {
+  const double capacity = RESERVE_FILL * static_cast<double>(bucket_size_);
+  int depth = 0;
+  while (depth < MAX_DEPTH && static_cast<double>(size_t{1} << depth) * capacity < static_cast<double>(count)) {
+    depth++;
+  }
+
+  // Grow the directory first so that the splits below never stop to double it.
+  while (true) {
+    int global_depth;
+    {
+      auto guard = epochs_.Pin();
+      global_depth = GetGlobalDepthInternal();
+    }
+    if (global_depth >= depth) {
+      break;
+    }
+    GrowDirectory(global_depth);
+  }
+  // Split the bucket of every slot of the target depth down to it. Each bucket only needs the latch once per split.
+  for (size_t i = 0; i < (size_t{1} << depth); i++) {
+    while (true) {
+      auto guard = epochs_.Pin();
+      Bucket *bucket = LatchBucket(i, true);
+      if (bucket->GetDepth() >= depth) {
+        bucket->WUnlatch();
+        break;
+      }
+      if (!SplitBucket(bucket)) {
+        // A concurrent Remove() shrank the directory.
+        const int bucket_depth = bucket->GetDepth();
+        bucket->WUnlatch();
+        GrowDirectory(bucket_depth);
+        continue;
       }
+      bucket->WUnlatch();
+    }
+  }
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetStats() const -> ExtendibleHashTableStats {
+  ExtendibleHashTableStats stats;
+  stats_.ForEach([&](const StatsShard &shard) {
+    stats.finds_ += shard.finds_.load(std::memory_order_relaxed);
+    stats.find_hits_ += shard.find_hits_.load(std::memory_order_relaxed);
+    stats.latched_finds_ += shard.latched_finds_.load(std::memory_order_relaxed);
+    stats.inserts_ += shard.inserts_.load(std::memory_order_relaxed);
+    stats.removes_ += shard.removes_.load(std::memory_order_relaxed);
+    stats.splits_ += shard.splits_.load(std::memory_order_relaxed);
+    stats.merges_ += shard.merges_.load(std::memory_order_relaxed);
+    stats.directory_grows_ += shard.directory_grows_.load(std::memory_order_relaxed);
+    stats.directory_shrinks_ += shard.directory_shrinks_.load(std::memory_order_relaxed);
+    stats.latch_retries_ += shard.latch_retries_.load(std::memory_order_relaxed);
+  });
+  stats.global_depth_ = GetGlobalDepth();
+  stats.num_buckets_ = GetNumBuckets();
+  return stats;
+}
+
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::GrowDirectory(int depth) {
+  latch_.WLock();
+  Directory *old_dir = dir_.load();
+  if (old_dir->global_depth_ == depth) {
+    const size_t length = old_dir->slots_.size();
+    auto *dir = new Directory(depth + 1);
+    for (size_t i = 0; i < length; i++) {
+      Bucket *bucket = old_dir->slots_[i].load(std::memory_order_relaxed);
+      dir->slots_[i].store(bucket, std::memory_order_relaxed);
+      dir->slots_[i + length].store(bucket, std::memory_order_relaxed);
     }
+    dir_.store(dir);
+    // Readers that loaded the old directory may still be walking it.
+    epochs_.Retire(old_dir);
+    Bump(&stats_.Local().directory_grows_);
+  }
+  latch_.WUnlock();
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::SplitBucket(Bucket *bucket) -> bool {
+  const int depth = bucket->GetDepth();
+  // Holding latch_ shared keeps doubling from copying the directory halfway through, and shrinking from halving it
+  // below the depth this split needs.
+  latch_.RLock();
+  Directory *dir = dir_.load();
+  if (depth == dir->global_depth_) {
+    latch_.RUnlock();
+    return false;
+  }
+  Bucket *upper = Bucket::Create(bucket_size_, depth + 1, bucket->GetPrefix() | (size_t{1} << depth));
+  bucket->SplitInto(upper);
+  at_depth_[depth]--;
+  at_depth_[depth + 1] += 2;
+  // The sibling covers every slot that agrees with its prefix on the low depth + 1 bits.
+  const size_t stride = size_t{1} << (depth + 1);
+  for (size_t i = upper->GetPrefix(); i < dir->slots_.size(); i += stride) {
+    dir->slots_[i].store(upper, std::memory_order_release);
   }
-  auto index = IndexOf(key);
-  auto bucket = dir_[index];
-  for (std::pair<K, V> &p : bucket->GetItems()) {
-    if (p.first == key) {
-      p.second = value;
+  latch_.RUnlock();
+  num_buckets_++;
+  Bump(&stats_.Local().splits_);
+  return true;
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::MergeBucket(Bucket *bucket) -> Bucket * {
+  while (bucket->GetDepth() > 0) {
+    const int depth = bucket->GetDepth();
+    const size_t buddy_prefix = bucket->GetPrefix() ^ (size_t{1} << (depth - 1));
+    // The directory cannot shrink below the depth of a bucket we hold, so the buddy's prefix is a valid slot. The
+    // caller's guard keeps the directory we read it from alive.
+    Bucket *buddy = dir_.load()->slots_[buddy_prefix].load();
+    // Blocking here could deadlock against a thread merging the buddy into us. Whoever loses leaves the merge to a
+    // later Remove().
+    if (!buddy->TryWLatch()) {
+      return bucket;
+    }
+    // Once latched the buddy cannot be merged away, but it may have been split further or the slot may be stale.
+    if (buddy->GetDepth() != depth || !buddy->Covers(buddy_prefix) ||
+        bucket->GetCount() + buddy->GetCount() > merge_threshold_) {
+      buddy->WUnlatch();
+      return bucket;
+    }
+
+    Bucket *lower = bucket->GetPrefix() < buddy_prefix ? bucket : buddy;
+    Bucket *upper = lower == bucket ? buddy : bucket;
+    latch_.RLock();
+    lower->MergeFrom(upper);
+    at_depth_[depth] -= 2;
+    at_depth_[depth - 1]++;
+    Directory *dir = dir_.load();
+    for (size_t i = upper->GetPrefix(); i < dir->slots_.size(); i += size_t{1} << depth) {
+      dir->slots_[i].store(lower, std::memory_order_release);
+    }
+    latch_.RUnlock();
+    num_buckets_--;
+    Bump(&stats_.Local().merges_);
+
+    upper->WUnlatch();
+    // Readers that loaded the upper bucket before its slots were repointed may still be probing it.
+    epochs_.Retire(upper, [](void *p) { Bucket::Destroy(static_cast<Bucket *>(p)); });
+    bucket = lower;
+  }
+  return bucket;
+}
+
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::ShrinkDirectory() {
+  {
+    auto guard = epochs_.Pin();
+    const int depth = GetGlobalDepthInternal();
+    if (depth == 0 || at_depth_[depth].load() != 0) {
       return;
     }
   }
-  bucket->Insert(key, value);
+  latch_.WLock();
+  Directory *dir = dir_.load();
+  while (dir->global_depth_ > 0 && at_depth_[dir->global_depth_].load(std::memory_order_relaxed) == 0) {
+    // Every local depth is below the global depth, so the upper half of the slots mirrors the lower half.
+    auto *smaller = new Directory(dir->global_depth_ - 1);
+    for (size_t i = 0; i < smaller->slots_.size(); i++) {
+      smaller->slots_[i].store(dir->slots_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    dir_.store(smaller);
+    epochs_.Retire(dir);
+    dir = smaller;
+    Bump(&stats_.Local().directory_shrinks_);
+  }
+  latch_.WUnlock();
 }
 
 //===--------------------------------------------------------------------===//
 // Bucket
 //===--------------------------------------------------------------------===//
-template <typename K, typename V>
-ExtendibleHashTable<K, V>::Bucket::Bucket(size_t array_size, int depth) : size_(array_size), depth_(depth) {}
+namespace {
+
+constexpr auto AlignUp(size_t offset, size_t alignment) -> size_t {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::LayoutOf(size_t size) -> Layout {
+  Layout layout{};
+  layout.hashes_ = AlignUp(sizeof(Bucket), alignof(size_t));
+  layout.keys_ = AlignUp(layout.hashes_ + size * sizeof(size_t), alignof(K));
+  layout.values_ = AlignUp(layout.keys_ + size * sizeof(K), alignof(V));
+  layout.tags_ = layout.values_ + size * sizeof(V);
+  layout.total_ = layout.tags_ + AlignUp(size, TAG_GROUP);
+  return layout;
+}
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Bucket::Find(const K &key, V &value) -> bool {
-  return std::any_of(list_.begin(), list_.end(), [&key, &value](const std::pair<K, V> &p) {
-    if (p.first == key) {
-      value = p.second;
-      return true;
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::Create(size_t size, int depth, size_t prefix) -> Bucket * {
+  constexpr auto alignment = std::max({alignof(Bucket), alignof(K), alignof(V)});
+  const Layout layout = LayoutOf(size);
+  auto *memory = static_cast<char *>(::operator new(layout.total_, std::align_val_t{alignment}));
+  return new (memory) Bucket(size, depth, prefix, memory, layout);
+}
+
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::Bucket::Destroy(Bucket *bucket) {
+  constexpr auto alignment = std::max({alignof(Bucket), alignof(K), alignof(V)});
+  std::destroy_n(bucket->keys_, bucket->size_);
+  std::destroy_n(bucket->values_, bucket->size_);
+  bucket->~Bucket();
+  ::operator delete(static_cast<void *>(bucket), std::align_val_t{alignment});
+}
+
+template <typename K, typename V, typename Hash>
+ExtendibleHashTable<K, V, Hash>::Bucket::Bucket(size_t size, int depth, size_t prefix, char *memory,
+                                                const Layout &layout)
+    : size_(size),
+      depth_(depth),
+      prefix_(prefix),
+      hashes_(reinterpret_cast<size_t *>(memory + layout.hashes_)),
+      keys_(reinterpret_cast<K *>(memory + layout.keys_)),
+      values_(reinterpret_cast<V *>(memory + layout.values_)),
+      tags_(reinterpret_cast<uint8_t *>(memory + layout.tags_)) {
+  std::uninitialized_value_construct_n(hashes_, size);
+  std::uninitialized_value_construct_n(keys_, size);
+  std::uninitialized_value_construct_n(values_, size);
+  // The padding is zeroed too, ProbeKey() loads whole tag groups.
+  std::uninitialized_value_construct_n(tags_, AlignUp(size, TAG_GROUP));
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::GetItems() const -> std::vector<std::pair<K, V>> {
+  std::vector<std::pair<K, V>> items;
+  const size_t count = count_.load(std::memory_order_relaxed);
+  items.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    items.emplace_back(keys_[i], values_[i]);
+  }
+  return items;
+}
+
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::Bucket::BeginWrite() {
+  if constexpr (OPTIMISTIC_READS) {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+}
+
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::Bucket::EndWrite() {
+  if constexpr (OPTIMISTIC_READS) {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::ProbeKey(size_t hash, const K &key, size_t count) const -> size_t {
+  const uint8_t tag = TagOf(hash);
+#ifdef __SSE2__
+  // Only writers change tags, and they hold the latch exclusively, so these plain vector loads race with nothing.
+  const __m128i needle = _mm_set1_epi8(static_cast<char>(tag));
+  for (size_t group = 0; group < count; group += TAG_GROUP) {
+    const __m128i tags = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags_ + group));
+    auto matches = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(tags, needle)));
+    if (count - group < TAG_GROUP) {
+      matches &= (1U << (count - group)) - 1;
+    }
+    for (; matches != 0; matches &= matches - 1) {
+      const size_t i = group + __builtin_ctz(matches);
+      if (keys_[i] == key) {
+        return i;
+      }
+    }
+  }
+#else
+  for (size_t i = 0; i < count; i++) {
+    if (tags_[i] == tag && keys_[i] == key) {
+      return i;
     }
+  }
+#endif
+  return count;
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::Find(size_t hash, const K &key, V &value) -> bool {
+  const size_t count = count_.load(std::memory_order_relaxed);
+  const size_t i = ProbeKey(hash, key, count);
+  if (i == count) {
     return false;
-  });
+  }
+  value = values_[i];
+  return true;
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Bucket::Remove(const K &key) -> bool {
-  return std::any_of(list_.begin(), list_.end(), [&key, this](const std::pair<K, V> &p) {
-    if (p.first == key) {
-      list_.remove(p);
-      return true;
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::OptimisticFind(size_t hash, const K &key, V &value) const -> ReadResult {
+  if constexpr (!OPTIMISTIC_READS) {
+    // Entries that do not fit a lock-free atomic can only be read under the latch.
+    return ReadResult::Retry;
+  }
+  const uint64_t version = version_.load(std::memory_order_acquire);
+  if ((version & 1) != 0) {
+    return ReadResult::Retry;
+  }
+  bool covers = Covers(hash);
+  bool found = false;
+  V match{};
+  const uint8_t tag = TagOf(hash);
+  // The count can be torn against the slots, but never exceeds size_, so the loop stays in bounds.
+  const size_t count = count_.load(std::memory_order_relaxed);
+  for (size_t i = 0; covers && i < count; i++) {
+    if (LoadCell(tags_[i]) == tag && LoadCell(keys_[i]) == key) {
+      match = LoadCell(values_[i]);
+      found = true;
+      break;
     }
-    return false;
-  });
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (!covers || version_.load(std::memory_order_relaxed) != version) {
+    return ReadResult::Retry;
+  }
+  if (found) {
+    value = match;
+    return ReadResult::Found;
+  }
+  return ReadResult::NotFound;
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Bucket::Insert(const K &key, const V &value) -> bool {
-  if (list_.size() == size_) {
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::Remove(size_t hash, const K &key) -> bool {
+  const size_t count = count_.load(std::memory_order_relaxed);
+  const size_t i = ProbeKey(hash, key, count);
+  if (i == count) {
     return false;
   }
-  // bool ok = false;
+  BeginWrite();
+  // Keep the slots dense by moving the last entry into the hole.
+  if (i != count - 1) {
+    StoreEntry(i, hashes_[count - 1], keys_[count - 1], std::move(values_[count - 1]));
+  }
+  if constexpr (!std::is_trivially_destructible_v<V>) {
+    values_[count - 1] = V{};
+  }
+  count_.store(count - 1, std::memory_order_relaxed);
+  EndWrite();
+  return true;
+}
 
-  /* if (!ok) {
-    std::pair<K, V> pair;
-    pair.first = key;
-    pair.second = value;
-    list_.push_back(pair);
-    ok = true;
-  } */
-  list_.template emplace_back(key, value);
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::Insert(size_t hash, const K &key, const V &value) -> bool {
+  const size_t count = count_.load(std::memory_order_relaxed);
+  const size_t i = ProbeKey(hash, key, count);
+  if (i == count && count == size_) {
+    return false;
+  }
+  BeginWrite();
+  if (i == count) {
+    StoreEntry(count, hash, key, value);
+    count_.store(count + 1, std::memory_order_relaxed);
+  } else {
+    StoreCell(&values_[i], value);
+  }
+  EndWrite();
   return true;
 }
 
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::Bucket::SplitInto(Bucket *sibling) {
+  const size_t bit = size_t{1} << GetDepth();
+  const size_t count = count_.load(std::memory_order_relaxed);
+  size_t kept = 0;
+  size_t moved = sibling->count_.load(std::memory_order_relaxed);
+  BeginWrite();
+  for (size_t i = 0; i < count; i++) {
+    if ((hashes_[i] & bit) != 0U) {
+      sibling->StoreEntry(moved++, hashes_[i], keys_[i], std::move(values_[i]));
+    } else if (kept++ != i) {
+      StoreEntry(kept - 1, hashes_[i], keys_[i], std::move(values_[i]));
+    }
+  }
+  if constexpr (!std::is_trivially_destructible_v<V>) {
+    for (size_t i = kept; i < count; i++) {
+      values_[i] = V{};
+    }
+  }
+  count_.store(kept, std::memory_order_relaxed);
+  sibling->count_.store(moved, std::memory_order_relaxed);
+  IncrementDepth();
+  EndWrite();
+}
+
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::Bucket::MergeFrom(Bucket *buddy) {
+  const size_t count = count_.load(std::memory_order_relaxed);
+  const size_t moved = buddy->count_.load(std::memory_order_relaxed);
+  BeginWrite();
+  buddy->BeginWrite();
+  for (size_t i = 0; i < moved; i++) {
+    StoreEntry(count + i, buddy->hashes_[i], buddy->keys_[i], std::move(buddy->values_[i]));
+  }
+  count_.store(count + moved, std::memory_order_relaxed);
+  depth_.store(GetDepth() - 1, std::memory_order_relaxed);
+  buddy->count_.store(0, std::memory_order_relaxed);
+  buddy->dead_.store(true, std::memory_order_relaxed);
+  buddy->EndWrite();
+  EndWrite();
+}
+
 template class ExtendibleHashTable<page_id_t, Page *>;
 template class ExtendibleHashTable<Page *, std::list<Page *>::iterator>;
 template class ExtendibleHashTable<int, int>;
@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/frame_list.h"
+#include "buffer/ghost_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ARCReplacer implements Adaptive Replacement Cache (Megiddo & Modha, FAST '03).
+ *
+ * Resident frames live in T1 (seen once recently) or T2 (seen at least twice), both LRU lists. Page ids evicted from
+ * them are remembered in the ghost lists B1 and B2. A miss on a page remembered in B1 means T1 was too small, so the
+ * target size p of T1 grows; a miss on a page in B2 shrinks it. Victims come from T1 while it is larger than p and from
+ * T2 otherwise, which lets the policy move between recency and frequency as the workload changes.
+ *
+ * The ghost lists need the page ids given by SetFramePage(). Because the buffer pool picks a victim before it knows
+ * which page comes next, p adapts on the access that follows the eviction rather than on the eviction itself.
+ *
+ * T1 and T2 only link their evictable frames, in flat per-frame arrays, so Evict() takes the back of a list in O(1)
+ * instead of walking past pinned frames. A pinned frame keeps its place: its stamp records when it was last used, and
+ * unpinning links it back where the stamp puts it. B1 and B2 are GhostLists allocated at construction, so no access
+ * allocates.
+ */
+class ARCReplacer : public Replacer {
+ public:
+  /**
+   * @brief Create a new ARCReplacer.
+   * @param num_frames the maximum number of frames the ARCReplacer will be required to store
+   */
+  explicit ARCReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ARCReplacer);
+
+  ~ARCReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void EvictionOrder(size_t max_frames, std::vector<frame_id_t> *frames) override;
+
+  void SetFramePage(frame_id_t frame_id, page_id_t page_id) override;
+
+ private:
+  /** Which resident list a frame is in. */
+  enum class List { None = 0, T1, T2 };
+
+  /** Replacer state of one frame. */
+  struct FrameState {
+    List list_{List::None};
+    bool is_evictable_{false};
+    /** Page the frame holds, INVALID_PAGE_ID if unknown. */
+    page_id_t page_id_{INVALID_PAGE_ID};
+    /** Place in the list: when the frame was last used. */
+    uint64_t stamp_{0};
+    /** Links in t1_ or t2_, while the frame is evictable. */
+    frame_id_t prev_{FrameList<FrameState>::NONE};
+    frame_id_t next_{FrameList<FrameState>::NONE};
+  };
+
+  /** @return the evictable frames of a resident list */
+  auto ListOf(List list) -> FrameList<FrameState> & { return list == List::T1 ? t1_ : t2_; }
+
+  /** @brief Put an untracked frame at the most recently used end of a resident list. */
+  void Enter(frame_id_t frame_id, List list);
+
+  /** @brief Take a tracked frame out of its resident list. */
+  void Leave(frame_id_t frame_id);
+
+  /** @brief Whether Evict() takes its victim from T1 when T1 holds t1_size frames. */
+  auto PreferT1(size_t t1_size) const -> bool;
+
+  /** @brief Drop the oldest ghosts so that |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c. */
+  void TrimGhosts();
+
+  size_t replacer_size_;
+  /** Adaptive target size of T1, between 0 and replacer_size_. */
+  size_t p_{0};
+  /** Source of the stamps, increasing. */
+  uint64_t next_stamp_{0};
+  std::vector<FrameState> frames_;
+  /** Evictable frames of the resident lists, most recently used at the front. */
+  FrameList<FrameState> t1_;
+  FrameList<FrameState> t2_;
+  /** Frames in T1 and in T2, evictable or not. */
+  size_t t1_size_{0};
+  size_t t2_size_{0};
+  /** Ghost lists, most recently evicted at the front. */
+  GhostList b1_;
+  GhostList b2_;
+  size_t curr_size_{0};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -12,20 +12,95 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_k_replacer.h"
+#include "buffer/frame_memory.h"
+#include "buffer/replacer.h"
 #include "common/config.h"
+#include "common/metrics.h"
+#include "container/hash/dense_page_table.h"
 #include "container/hash/extendible_hash_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
+/**
+ * Page table implementations the buffer pool can be configured with. Dense indexes a radix tree by the page id and
+ * never hashes or resizes, ExtendibleHash is the general-purpose ExtendibleHashTable presized to the pool.
+ */
+enum class PageTableType { Dense = 0, ExtendibleHash };
+
+/**
+ * Counters of a buffer pool since its creation, see BufferPoolManagerInstance::GetStats(). The latency histograms
+ * only cover the time latency tracking was on.
+ */
+struct BufferPoolStats {
+  /** Calls of FetchPgImp(), including those of the page guard fetches. */
+  uint64_t fetches_{0};
+  /** Fetches that found their page resident. */
+  uint64_t fetch_hits_{0};
+  /** Fetches that returned nullptr because every frame was pinned. */
+  uint64_t fetch_failures_{0};
+  uint64_t new_pages_{0};
+  /** Calls of NewPgImp() that returned nullptr because every frame was pinned. */
+  uint64_t new_page_failures_{0};
+  /** Frames taken from other pages, by the replacer or the scan ring. */
+  uint64_t evictions_{0};
+  /** Evictions whose victim had to be written back first. */
+  uint64_t dirty_evictions_{0};
+  /** Pages written back by the background flusher. */
+  uint64_t flusher_writes_{0};
+  /** Pages written back by FlushPgImp() and FlushAllPgsImp(). */
+  uint64_t flushes_{0};
+  /** Pages read by the prefetcher. */
+  uint64_t prefetch_reads_{0};
+  /** Pins dropped, by UnpinPgImp() or page guards. */
+  uint64_t unpins_{0};
+  /** Pins dropped by page guards without taking the latch. */
+  uint64_t unlatched_unpins_{0};
+  /** Acquisitions of the buffer pool latch by fetches, new pages, unpins, flushes and deletes. */
+  uint64_t latch_acquisitions_{0};
+  /** Acquisitions that found the latch held and had to wait. */
+  uint64_t latch_contentions_{0};
+
+  size_t free_frames_{0};
+  size_t evictable_frames_{0};
+  size_t dirty_frames_{0};
+
+  /** Latency of FetchPgImp(), including its disk I/O. */
+  HistogramSnapshot fetch_latency_;
+  /** Latency of NewPgImp(), including the write-back of a dirty victim. */
+  HistogramSnapshot new_page_latency_;
+  /** Latency of picking a victim in the replacer. */
+  HistogramSnapshot evict_latency_;
+  /** Latency of page table lookups and inserts. */
+  HistogramSnapshot page_table_latency_;
+  /** Time spent waiting for the buffer pool latch by contended acquisitions. */
+  HistogramSnapshot latch_wait_;
+
+  /** @return the fraction of fetches that found their page resident */
+  auto HitRatio() const -> double {
+    return fetches_ == 0 ? 0.0 : static_cast<double>(fetch_hits_) / static_cast<double>(fetches_);
+  }
+
+  /** @brief Add the counters of another buffer pool, e.g. another instance of a ParallelBufferPoolManager. */
+  void Merge(const BufferPoolStats &other);
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -37,9 +112,40 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_type the replacement policy; replacer_k is only used by ReplacerType::LRUK
+   * @param page_table_type the page table implementation
+   * @param frame_memory page size and NUMA placement of the frames
+   * @param replacer_access_batch number of page accesses the LRU-K replacer buffers per stripe before applying them
+   * under its latch, 0 applies every access immediately. Other replacers ignore it.
    */
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRUK,
+                            PageTableType page_table_type = PageTableType::Dense,
+                            const FrameMemoryOptions &frame_memory = {}, size_t replacer_access_batch = 0);
+
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   *
+   * Page ids allocated by this instance are congruent to instance_index modulo num_instances, so the owning
+   * ParallelBufferPoolManager can route any page id back to the shard that created it.
+   *
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of BPIs in parallel BPM
+   * @param instance_index index of this BPI in the parallel BPM
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_type the replacement policy; replacer_k is only used by ReplacerType::LRUK
+   * @param page_table_type the page table implementation
+   * @param frame_memory page size and NUMA placement of the frames
+   * @param replacer_access_batch number of page accesses the LRU-K replacer buffers per stripe before applying them
+   * under its latch, 0 applies every access immediately. Other replacers ignore it.
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRUK,
+                            PageTableType page_table_type = PageTableType::Dense,
+                            const FrameMemoryOptions &frame_memory = {}, size_t replacer_access_batch = 0);
 
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
@@ -52,6 +158,112 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /** @return the memory the frames live in, to check which page size and NUMA placement they obtained */
+  auto GetFrameMemory() const -> const FrameMemory & { return *frame_memory_; }
+
+  using BufferPoolManager::FetchPage;
+
+  /**
+   * @brief Fetch a page, telling the buffer pool what the access is for.
+   *
+   * Scan fetches do not promote pages in the replacer, and pages they bring in are recycled within a ring of at most
+   * scan_ring_size_ frames, so a large scan replaces its own pages instead of the hot working set. A scanned page that
+   * is later fetched by a lookup leaves the ring and is managed like any other page.
+   *
+   * @param page_id id of page to be fetched
+   * @param access_type what the access is for
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPage(page_id_t page_id, AccessType access_type) -> Page * { return FetchPgImp(page_id, access_type); }
+
+  /**
+   * @brief Resize the scan ring. Frames already in the ring are released to the replacer.
+   * @param num_frames the number of frames scan fetches recycle, 0 lets scans use the whole pool
+   */
+  void SetScanRingSize(size_t num_frames);
+
+  /**
+   * @brief Start a background thread that writes dirty, unpinned pages back to disk ahead of their eviction, so that
+   * evicting a clean frame becomes the common case and foreground requests rarely pay for a write.
+   *
+   * The flusher wakes up every interval (or as soon as the dirty fraction crosses high_watermark). When more than
+   * high_watermark of the frames are dirty, it takes dirty frames in the replacer's eviction order and writes them
+   * back in batches of batch_size, until at most low_watermark of the frames are dirty. Each batch is written in
+   * page id order, so adjacent pages go to disk as one sequential run.
+   *
+   * Calling this while the flusher runs restarts it with the new settings. The destructor stops the flusher.
+   *
+   * @param interval how often the flusher checks the dirty fraction
+   * @param high_watermark fraction of dirty frames that starts a flush
+   * @param low_watermark fraction of dirty frames at which a flush stops
+   * @param batch_size maximum number of pages written back per batch
+   */
+  void StartFlusher(std::chrono::milliseconds interval = std::chrono::milliseconds(100), double high_watermark = 0.25,
+                    double low_watermark = 0.1, size_t batch_size = 64);
+
+  /** @brief Stop the background flusher started by StartFlusher(), if any, and wait for it to exit. */
+  void StopFlusher();
+
+  /**
+   * @brief Ask for pages to be loaded into the buffer pool in the background, without blocking the caller.
+   *
+   * A background thread (started on first use) reads each page that is not resident yet into a free or evictable
+   * frame. Prefetched pages are left unpinned. The prefetch and the first fetch that follows it count as a single
+   * access for the replacer, so a scanned page does not look hotter than it is. Pages that do not belong to this
+   * instance are ignored, and requests are dropped rather than queued beyond pool_size_ pending pages.
+   *
+   * @param page_ids ids of the pages that are about to be fetched
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * @brief Turn sequential read-ahead on or off.
+   *
+   * With read-ahead on, FetchPgImp() watches for runs of consecutive page ids (this instance's own page ids, which are
+   * num_instances_ apart). Once a run is READ_AHEAD_TRIGGER fetches long, the next window pages of the run are
+   * prefetched, and the window is topped up again whenever the scan gets halfway through it.
+   *
+   * @param window number of pages to read ahead of a sequential scan, 0 turns read-ahead off
+   */
+  void SetReadAhead(size_t window);
+
+  /**
+   * @brief Fetch a page and hand its pin to a guard, see FetchPage().
+   * @return a guard on the page, empty if page_id cannot be fetched
+   */
+  auto FetchPageBasic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> BasicPageGuard;
+
+  /**
+   * @brief Fetch a page and read latch it, see FetchPage(). The guard releases the latch and the pin.
+   * @return a guard on the page, empty if page_id cannot be fetched
+   */
+  auto FetchPageRead(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> ReadPageGuard;
+
+  /**
+   * @brief Fetch a page and write latch it, see FetchPage(). The guard releases the latch and the pin.
+   * @return a guard on the page, empty if page_id cannot be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> WritePageGuard;
+
+  /**
+   * @brief Create a new page and hand its pin to a guard, see NewPgImp().
+   * @param[out] page_id id of created page
+   * @return a guard on the new page, empty if no new page could be created
+   */
+  auto NewPageGuarded(page_id_t *page_id) -> BasicPageGuard;
+
+  /**
+   * @brief Take a snapshot of the buffer pool's counters. Counters are sharded by thread and updated without the
+   * latch, so a snapshot taken under load may count an operation in one counter and not yet in another.
+   */
+  auto GetStats() -> BufferPoolStats;
+
+  /**
+   * @brief Turn latency tracking on or off. Counters are always kept, but the latency histograms read the clock
+   * around every measured operation, so they are off by default.
+   */
+  void SetLatencyTracking(bool enabled) { track_latency_.store(enabled, std::memory_order_relaxed); }
+
  protected:
   /**
    * TODO(P1): Add implementation
@@ -90,6 +302,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * @brief Fetch the requested page like FetchPgImp(page_id), for an access of the given type.
+   * @param page_id id of page to be fetched
+   * @param access_type what the access is for, scans take their frame from the scan ring
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id, AccessType access_type) -> Page *;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -129,7 +349,8 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * TODO(P1): Add implementation
    *
    * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, do nothing and return true. If the
-   * page is pinned and cannot be deleted, return false immediately.
+   * page is pinned and cannot be deleted, return false immediately. The pin the background flusher holds while writing
+   * the page back does not count, the delete waits for that write instead.
    *
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
    * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
@@ -142,24 +363,122 @@ class BufferPoolManagerInstance : public BufferPoolManager {
 
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const uint32_t instance_index_ = 0;
   /** The next page id to be allocated  */
   page_id_t next_page_id_ = 0;
-  /** Bucket size for the extendible hash table */
+  /** Bucket size for the extendible hash table, when that is the page table */
   const size_t bucket_size_ = 4;
 
-  /** Array of buffer pool pages. */
+  /** Memory of the buffer pool pages, allocated according to the FrameMemoryOptions. */
+  std::unique_ptr<FrameMemory> frame_memory_;
+  /** Array of buffer pool pages, in frame_memory_. */
   Page *pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. Please ignore this for P1. */
   LogManager *log_manager_ __attribute__((__unused__));
+  /**
+   * Marks frames released dirty by a page guard without the latch. The dirty flag itself is only changed under the
+   * latch, so the mark is folded into it by the next locked unpin of the frame, at the latest the one that unpins it
+   * for good; until then the frame stays pinned and cannot be evicted or written back for the last time.
+   */
+  std::vector<std::atomic<bool>> guard_dirtied_;
   /** Page table for keeping track of buffer pool pages. */
-  ExtendibleHashTable<page_id_t, frame_id_t> *page_table_;
+  HashTable<page_id_t, frame_id_t> *page_table_;
   /** Replacer to find unpinned pages for replacement. */
-  LRUKReplacer *replacer_;
-  /** List of free frames that don't have any pages on them. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  Replacer *replacer_;
+  /**
+   * Frames that don't have any pages on them. This is a ring buffer with exactly pool_size_ slots, which is enough
+   * to hold every frame, so taking or returning a free frame never allocates.
+   */
+  std::vector<frame_id_t> free_list_;
+  /** Slot of free_list_ holding the oldest free frame. */
+  size_t free_head_ = 0;
+  /** Number of frames currently in free_list_. */
+  size_t free_count_ = 0;
+  /**
+   * Marks frames whose disk I/O (reading the new page, writing back the dirty victim) runs without the latch held.
+   * Such a frame is already pinned and in the page table, so it can be neither evicted nor read a second time.
+   */
+  std::vector<bool> io_in_progress_;
+  /**
+   * Marks frames pinned by the background flusher while it writes them back. Such a pin is not the page's owner
+   * holding on to it, so DeletePgImp() waits for the write to finish instead of failing.
+   */
+  std::vector<bool> flusher_writing_;
+  /** Signalled whenever a frame's I/O completes, including the flusher's write-backs. */
+  std::condition_variable io_cv_;
+  /** Number of frames whose dirty flag is set. */
+  size_t num_dirty_ = 0;
+
+  /** The background flusher thread. */
+  std::thread flusher_thread_;
+  /** Whether flusher_thread_ runs and has not been asked to stop. */
+  bool flusher_running_ = false;
+  /** Set to ask the flusher to exit. */
+  bool flusher_stop_ = false;
+  /** Signalled to wake the flusher up early, to flush or to exit. */
+  std::condition_variable flusher_cv_;
+  /** How often the flusher checks the number of dirty frames. */
+  std::chrono::milliseconds flusher_interval_{0};
+  /** The flusher starts writing back once more than this many frames are dirty. */
+  size_t flusher_high_dirty_ = 0;
+  /** The flusher stops writing back once at most this many frames are dirty. */
+  size_t flusher_low_dirty_ = 0;
+  /** Maximum number of pages in one flusher batch. */
+  size_t flusher_batch_size_ = 0;
+
+  /** Number of consecutive fetches after which a scan counts as sequential. */
+  static constexpr size_t READ_AHEAD_TRIGGER = 4;
+  /** Pages waiting to be prefetched. */
+  std::deque<page_id_t> prefetch_queue_;
+  /** The background prefetch thread. */
+  std::thread prefetch_thread_;
+  /** Whether prefetch_thread_ has been started. */
+  bool prefetch_running_ = false;
+  /** Set to ask the prefetch thread to exit. */
+  bool prefetch_stop_ = false;
+  /** Signalled when pages are queued or the prefetch thread should exit. */
+  std::condition_variable prefetch_cv_;
+  /** Number of pages to read ahead of a sequential scan, 0 if read-ahead is off. */
+  size_t read_ahead_window_ = 0;
+  /** The page fetched last, to detect sequential scans. */
+  page_id_t last_fetched_page_id_ = INVALID_PAGE_ID;
+  /** Length of the current run of consecutive fetches. */
+  size_t sequential_run_ = 0;
+  /** First page id of the current run that has not been queued for read-ahead yet. */
+  page_id_t read_ahead_next_ = INVALID_PAGE_ID;
+  /**
+   * Marks frames loaded by the prefetcher and not fetched since. The prefetch already recorded the access, so the
+   * first fetch of such a frame does not record another one.
+   */
+  std::vector<bool> prefetched_;
+
+  /** Scan ring size used unless SetScanRingSize() says otherwise (capped at an eighth of the pool). */
+  static constexpr size_t DEFAULT_SCAN_RING_SIZE = 32;
+  /** scan_ring_slot_ value of a frame that is not in the scan ring. */
+  static constexpr size_t NOT_IN_SCAN_RING = std::numeric_limits<size_t>::max();
+  /** Maximum number of frames in the scan ring, 0 if scans are not confined to a ring. */
+  size_t scan_ring_size_;
+  /** Frames recycled by scan fetches, filled up to scan_ring_size_ and then reused in order. */
+  std::vector<frame_id_t> scan_ring_;
+  /** Slot of scan_ring_ the next scan miss reuses. */
+  size_t scan_ring_next_ = 0;
+  /**
+   * For each frame, the slot of scan_ring_ that owns it, or NOT_IN_SCAN_RING. A slot's frame is only reused while the
+   * frame still points back at the slot, so frames that left the ring are never taken from under other pages.
+   */
+  std::vector<size_t> scan_ring_slot_;
+  /**
+   * This latch protects the page table, the replacer, the free list, the scan ring, io_in_progress_ and the metadata
+   * (page id, pin count, dirty flag) of every frame. It is never held across disk reads or evictions' write-backs.
+   *
+   * Pin counts are the one exception: they are accessed atomically, and a page guard may drop a pin that is not the
+   * last one of its frame without the latch. A pin count only rises or reaches 0 under the latch.
+   */
   std::mutex latch_;
 
   /**
@@ -176,11 +495,198 @@ class BufferPoolManagerInstance : public BufferPoolManager {
     // This is a no-nop right now without a more complex data structure to track deallocated pages
   }
 
-  // TODO(student): You may add additional private members and helper functions
-  /*inline Page* GetPage(frame_id_t frameId) {
-    assert(frameId == -1);
-    assert(size_t(frameId) < pool_size_);
-    return pages_ + frameId;
-  }*/
+  /**
+   * @brief Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
+   * validate input data and ensure that a parallel BPM is routing requests to the correct BPI
+   * @param page_id
+   */
+  void ValidatePageId(page_id_t page_id) const;
+
+  /**
+   * @brief Take the oldest frame from the free list. Caller should acquire the latch before calling this function.
+   * @param[out] frame_id id of the free frame
+   * @return false if the free list is empty
+   */
+  auto PopFreeFrame(frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Return a frame to the free list. Caller should acquire the latch before calling this function.
+   * @param frame_id id of the frame that no longer holds a page
+   */
+  void PushFreeFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Find a frame for a new page, from the free list first and from the replacer otherwise.
+   * Caller should acquire the latch before calling this function.
+   *
+   * Both sources answer in O(1) whether a frame is available, so there is no need to scan the pool for an unpinned
+   * frame first.
+   *
+   * A clean victim is removed from the page table right away. A dirty victim stays mapped to the frame and its id is
+   * returned, the caller must write the frame's data back to disk and then call FinishFrameIo().
+   *
+   * @param[out] frame_id id of the acquired frame
+   * @param[out] dirty_page_id id of the dirty page evicted from the frame, INVALID_PAGE_ID if nothing to write back
+   * @return false if every frame is in use and not evictable
+   */
+  auto AcquireFrame(frame_id_t *frame_id, page_id_t *dirty_page_id) -> bool;
+
+  /**
+   * @brief Find a frame for a page brought in by a scan. Once the scan ring is full, its oldest frame is reused if
+   * it is unpinned and still in the ring, and any other frame acquired by AcquireFrame() takes its slot otherwise.
+   * Caller should acquire the latch before calling this function.
+   * @param[out] frame_id id of the acquired frame
+   * @param[out] dirty_page_id same as for AcquireFrame()
+   * @return false if every frame is in use and not evictable
+   */
+  auto AcquireScanFrame(frame_id_t *frame_id, page_id_t *dirty_page_id) -> bool;
+
+  /**
+   * @brief Detach the page from a frame that was just taken from the replacer, see AcquireFrame().
+   * Caller should acquire the latch before calling this function.
+   * @param frame_id id of the victim frame
+   * @param[out] dirty_page_id id of the page to write back, INVALID_PAGE_ID if the page is clean
+   */
+  void DetachVictim(frame_id_t frame_id, page_id_t *dirty_page_id);
+
+  /**
+   * @brief Install page_id in an acquired frame: pin it once, map it in the page table and record the access.
+   * Caller should acquire the latch before calling this function.
+   * @param frame_id id of the frame returned by AcquireFrame()
+   * @param page_id id of the page that will live in the frame
+   * @param access_type what the access is for
+   */
+  void PinNewFrame(frame_id_t frame_id, page_id_t page_id, AccessType access_type = AccessType::Unknown);
+
+  /**
+   * @brief Look page_id up in the page table, waiting for any I/O in progress on its frame to finish.
+   * Caller should hold the latch through lock, which is released while waiting.
+   * @param page_id id of the page to look up
+   * @param[out] frame_id id of the frame holding the page
+   * @param lock the caller's lock on latch_
+   * @return true if the page is resident and its frame has no I/O in progress
+   */
+  auto FindFrame(page_id_t page_id, frame_id_t *frame_id, std::unique_lock<std::mutex> *lock) -> bool;
+
+  /**
+   * @brief Mark the I/O on a frame as done and wake up threads waiting for it.
+   * Caller should acquire the latch before calling this function.
+   * @param frame_id id of the frame whose I/O completed
+   * @param dirty_page_id the written back victim to drop from the page table, or INVALID_PAGE_ID
+   */
+  void FinishFrameIo(frame_id_t frame_id, page_id_t dirty_page_id);
+
+  /**
+   * @brief Set or clear the dirty flag of a frame, keeping num_dirty_ up to date.
+   * Caller should acquire the latch before calling this function.
+   */
+  void SetFrameDirty(frame_id_t frame_id, bool is_dirty);
+
+  /** @brief Body of the background flusher thread. */
+  void FlusherLoop();
+
+  /**
+   * @brief Queue pages for the prefetch thread, starting it if needed.
+   * Caller should acquire the latch before calling this function.
+   */
+  void EnqueuePrefetch(const page_id_t *page_ids, size_t count);
+
+  /**
+   * @brief Track sequential fetches and queue read-ahead for them.
+   * Caller should acquire the latch before calling this function.
+   * @param page_id id of the page being fetched
+   */
+  void NoteFetch(page_id_t page_id);
+
+  /** @brief Body of the background prefetch thread. */
+  void PrefetchLoop();
+
+  /**
+   * @brief Read one page into a free or evictable frame and leave it unpinned.
+   * Caller should hold the latch through lock, which is released while reading.
+   */
+  void PrefetchPage(page_id_t page_id, std::unique_lock<std::mutex> *lock);
+
+  /** @brief Stop the prefetch thread, if running, and wait for it to exit. */
+  void StopPrefetcher();
+
+  /**
+   * @brief Write back one batch of dirty frames, picked in the replacer's eviction order. The eviction order is walked
+   * as deep as it takes to fill the batch, so dirty frames are found however far they are from eviction.
+   * Caller should hold the latch through lock, which is released while writing.
+   * @return false if there was no dirty evictable frame to write back
+   */
+  auto FlushDirtyBatch(std::unique_lock<std::mutex> *lock) -> bool;
+
+  friend class BasicPageGuard;
+  friend class PageGuardBatch;
+
+  /** @return the pin count of a frame */
+  auto PinCount(frame_id_t frame_id) -> int { return pages_[frame_id].GetPinCount(); }
+
+  /**
+   * @brief Add a pin to a frame. Caller should acquire the latch before calling this function.
+   * @return the pin count before this pin
+   */
+  auto PinFrame(frame_id_t frame_id) -> int {
+    return pages_[frame_id].pin_count_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  /**
+   * @brief Drop a pin of a frame, marking it dirty first if is_dirty, and make it evictable once no pin is left.
+   * Caller should acquire the latch before calling this function.
+   */
+  void UnpinFrame(frame_id_t frame_id, bool is_dirty);
+
+  /**
+   * @brief Drop a pin of a frame without the latch, if it is not the last pin.
+   * @return false if the pin may be the last one, the caller must then use UnpinFrame()
+   */
+  auto TryUnpinFrameUnlatched(frame_id_t frame_id, bool is_dirty) -> bool;
+
+  /** @brief Release the pin a page guard holds on page. */
+  void ReleaseFrame(Page *page, bool is_dirty);
+
+  /**
+   * @brief Release the pins a batch of page guards holds, taking the latch at most once.
+   * @param pages pages of this instance, each with whether it is released dirty
+   */
+  void ReleaseFrames(const std::vector<std::pair<Page *, bool>> &pages);
+
+  /** @return the frame page lives in, page must be one of pages_ */
+  auto FrameOf(const Page *page) const -> frame_id_t { return static_cast<frame_id_t>(page - pages_); }
+
+  /** @brief Acquire latch_, counting the acquisition and timing the wait if the latch is held. */
+  auto LockLatch() -> std::unique_lock<std::mutex>;
+
+  /** @return histogram if latency tracking is on, otherwise nullptr, for a LatencyTimer */
+  auto Tracked(LatencyHistogram *histogram) -> LatencyHistogram * {
+    return track_latency_.load(std::memory_order_relaxed) ? histogram : nullptr;
+  }
+
+  /** The counters of one metric shard, summed up by GetStats(). */
+  struct StatsShard {
+    std::atomic<uint64_t> fetches_{0};
+    std::atomic<uint64_t> fetch_hits_{0};
+    std::atomic<uint64_t> fetch_failures_{0};
+    std::atomic<uint64_t> new_pages_{0};
+    std::atomic<uint64_t> new_page_failures_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> dirty_evictions_{0};
+    std::atomic<uint64_t> flusher_writes_{0};
+    std::atomic<uint64_t> flushes_{0};
+    std::atomic<uint64_t> prefetch_reads_{0};
+    std::atomic<uint64_t> unpins_{0};
+    std::atomic<uint64_t> unlatched_unpins_{0};
+    std::atomic<uint64_t> latch_acquisitions_{0};
+    std::atomic<uint64_t> latch_contentions_{0};
+  };
+  Sharded<StatsShard> stats_;
+  std::atomic<bool> track_latency_{false};
+  LatencyHistogram fetch_latency_;
+  LatencyHistogram new_page_latency_;
+  LatencyHistogram evict_latency_;
+  LatencyHistogram page_table_latency_;
+  LatencyHistogram latch_wait_;
 };
 }  // namespace bustub
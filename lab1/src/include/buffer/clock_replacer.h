@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_replacer.h
+//
+// Identification: src/include/buffer/clock_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ClockReplacer implements the clock (second chance) replacement policy, which approximates LRU.
+ *
+ * Every tracked frame has a reference bit, set on each access. The clock hand sweeps the frames in frame id order:
+ * an evictable frame with its bit set gets a second chance (the bit is cleared), the first evictable frame found with
+ * its bit clear is the victim.
+ *
+ * A hit on a tracked frame only sets its reference bit, which is an atomic store without taking the replacer latch.
+ */
+class ClockReplacer : public Replacer {
+ public:
+  /**
+   * @brief Create a new ClockReplacer.
+   * @param num_frames the maximum number of frames the ClockReplacer will be required to store
+   */
+  explicit ClockReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ClockReplacer);
+
+  ~ClockReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void EvictionOrder(size_t max_frames, std::vector<frame_id_t> *frames) override;
+
+ private:
+  size_t replacer_size_;
+  /**
+   * Whether each frame is tracked, indexed by frame id. Only changed under latch_, but RecordAccess() reads it without
+   * the latch to take the fast path for hits.
+   */
+  std::unique_ptr<std::atomic<bool>[]> tracked_;
+  /** Reference bit of every frame, indexed by frame id. */
+  std::unique_ptr<std::atomic<bool>[]> referenced_;
+  /** Whether each frame is evictable, indexed by frame id. */
+  std::vector<bool> evictable_;
+  /** Where the next sweep starts. */
+  size_t hand_{0};
+  size_t curr_size_{0};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_list.h
+//
+// Identification: src/include/buffer/frame_list.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FrameList is a doubly linked list of frame ids ordered by stamp, the newest at the front. Its links live in the
+ * per-frame states of a replacer, so linking and unlinking never allocate, and a frame is in at most one of the lists
+ * over the same states at a time. State must have frame_id_t prev_ and next_ links and a uint64_t stamp_, stamps are
+ * unique within a list.
+ *
+ * Replacers keep only their evictable frames in these lists, so the next victim of a list is its back.
+ */
+template <typename State>
+class FrameList {
+ public:
+  /** Link of the frame at either end. */
+  static constexpr frame_id_t NONE = -1;
+
+  /** @param states the per-frame states holding the links, indexed by frame id */
+  explicit FrameList(std::vector<State> *states) : states_(states) {}
+
+  auto Empty() const -> bool { return front_ == NONE; }
+
+  /** @return the oldest frame, NONE if the list is empty */
+  auto Back() const -> frame_id_t { return back_; }
+
+  /** @return the frame in front of frame_id, NONE if it is the front */
+  auto Prev(frame_id_t frame_id) const -> frame_id_t { return (*states_)[frame_id].prev_; }
+
+  /** @brief Link a frame at the front. Its stamp must be newer than every stamp in the list. */
+  void PushFront(frame_id_t frame_id) { LinkBetween(NONE, front_, frame_id); }
+
+  /**
+   * @brief Link a frame where its stamp puts it. The walk starts from both ends at once, so a frame that belongs near
+   * either end, such as one unpinned right after it was accessed, is linked in a few steps.
+   */
+  void Insert(frame_id_t frame_id) {
+    const uint64_t stamp = (*states_)[frame_id].stamp_;
+    frame_id_t newer = back_;
+    frame_id_t older = front_;
+    while (true) {
+      if (older == NONE || (*states_)[older].stamp_ < stamp) {
+        LinkBetween(older == NONE ? back_ : (*states_)[older].prev_, older, frame_id);
+        return;
+      }
+      older = (*states_)[older].next_;
+      if (newer == NONE || (*states_)[newer].stamp_ > stamp) {
+        LinkBetween(newer, newer == NONE ? front_ : (*states_)[newer].next_, frame_id);
+        return;
+      }
+      newer = (*states_)[newer].prev_;
+    }
+  }
+
+  /** @brief Unlink a frame that is in the list. */
+  void Erase(frame_id_t frame_id) {
+    State &state = (*states_)[frame_id];
+    (state.prev_ == NONE ? front_ : (*states_)[state.prev_].next_) = state.next_;
+    (state.next_ == NONE ? back_ : (*states_)[state.next_].prev_) = state.prev_;
+    state.prev_ = NONE;
+    state.next_ = NONE;
+  }
+
+ private:
+  /** @brief Link frame_id between two adjacent frames, NONE standing for the ends. */
+  void LinkBetween(frame_id_t prev, frame_id_t next, frame_id_t frame_id) {
+    State &state = (*states_)[frame_id];
+    state.prev_ = prev;
+    state.next_ = next;
+    (prev == NONE ? front_ : (*states_)[prev].next_) = frame_id;
+    (next == NONE ? back_ : (*states_)[next].prev_) = frame_id;
+  }
+
+  std::vector<State> *states_;
+  frame_id_t front_{NONE};
+  frame_id_t back_{NONE};
+};
+
+}  // namespace bustub
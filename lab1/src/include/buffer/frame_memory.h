@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_memory.h
+//
+// Identification: src/include/buffer/frame_memory.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/** Size of the virtual memory pages backing the frames of a buffer pool. */
+enum class FramePageSize { Default = 0, Huge2MB, Huge1GB };
+
+/**
+ * NUMA placement of the frames of a buffer pool. Interleave spreads them over every node with memory, Bind places
+ * them on a single node. Default leaves placement to the kernel, which puts each page on the node that touches it
+ * first, i.e. the node the buffer pool is created on.
+ */
+enum class NumaPolicy { Default = 0, Interleave, Bind };
+
+/** How a buffer pool allocates the memory of its frames. */
+struct FrameMemoryOptions {
+  FramePageSize page_size_{FramePageSize::Default};
+  NumaPolicy numa_policy_{NumaPolicy::Default};
+  /**
+   * Node the frames are bound to with NumaPolicy::Bind. A ParallelBufferPoolManager binds instance i to node i
+   * modulo the number of nodes instead.
+   */
+  int numa_node_{0};
+};
+
+/**
+ * FrameMemory is the array of frames of a buffer pool, mapped directly from the kernel so that it can be backed by
+ * huge pages and placed on NUMA nodes before it is first touched.
+ *
+ * The mapping holds the data of all frames as one array of whole pages, so the data of every frame is aligned for
+ * direct I/O, followed by the Page array, so pages_[i] addresses frame i as before and points to its data.
+ *
+ * Both options are requests: without reserved huge pages of the requested size the frames fall back to regular pages
+ * (with transparent huge pages requested), and placement is skipped on kernels without NUMA support. Huge pages are
+ * only placed when the chosen nodes have enough of them free, since a huge page fault that its policy cannot satisfy
+ * is a SIGBUS rather than a fallback to another node. The getters report what was obtained.
+ */
+class FrameMemory {
+ public:
+  /**
+   * @brief Map and construct num_frames pages. Throws Exception if no memory could be mapped at all.
+   * @param num_frames number of frames of the buffer pool
+   * @param options page size and NUMA placement of the frames
+   */
+  FrameMemory(size_t num_frames, const FrameMemoryOptions &options);
+
+  ~FrameMemory();
+
+  DISALLOW_COPY_AND_MOVE(FrameMemory);
+
+  /** @return the frames */
+  auto GetPages() -> Page * { return pages_; }
+
+  /** @return the frame data, BUSTUB_PAGE_SIZE bytes per frame in frame order */
+  auto GetData() -> char * { return data_; }
+
+  /** @return the size of the pages actually backing the frames */
+  auto GetPageSize() const -> FramePageSize { return page_size_; }
+
+  /** @return whether the requested NUMA policy was applied */
+  auto IsNumaPlaced() const -> bool { return numa_placed_; }
+
+  /** @return number of NUMA nodes with memory, 1 on machines or kernels without NUMA */
+  static auto GetNumaNodeCount() -> int;
+
+ private:
+  /** @brief Apply the NUMA policy of options to the not yet touched mapping. @return whether it was applied */
+  auto PlaceOnNodes(const FrameMemoryOptions &options) -> bool;
+
+  /** @return whether each of nodes has free huge pages for its share of the mapping */
+  auto HasFreeHugePages(uint64_t nodes) const -> bool;
+
+  /** Start of the mapping and of the frame data. */
+  char *data_{nullptr};
+  /** The frames, after the frame data. */
+  Page *pages_{nullptr};
+  size_t num_frames_;
+  /** Bytes mapped, the frame data and the pages rounded up to the page size. */
+  size_t mapped_size_{0};
+  FramePageSize page_size_{FramePageSize::Default};
+  bool numa_placed_{false};
+};
+
+}  // namespace bustub
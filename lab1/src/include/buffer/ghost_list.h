@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// ghost_list.h
+//
+// Identification: src/include/buffer/ghost_list.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * GhostList remembers the ids of recently evicted pages in recency order, the newest at the front, for the ghost
+ * queues of 2Q and ARC.
+ *
+ * All of its memory is allocated at construction: the entries are a fixed array of list nodes with a free list, and
+ * the page id index is an open-addressed table with linear probing at most half full. Remembering, forgetting and
+ * looking up a page therefore never allocate, which keeps them cheap under the buffer pool latch.
+ */
+class GhostList {
+ public:
+  /** @param capacity the most pages remembered at once */
+  explicit GhostList(size_t capacity);
+
+  DISALLOW_COPY_AND_MOVE(GhostList);
+
+  /** @return the number of pages remembered */
+  auto Size() const -> size_t { return size_; }
+
+  /** @brief Forget page_id, returning whether it was remembered. */
+  auto Erase(page_id_t page_id) -> bool;
+
+  /** @return whether page_id is remembered */
+  auto Contains(page_id_t page_id) const -> bool { return FindSlot(page_id) != NO_NODE; }
+
+  /** @brief Remember a page that is not remembered yet as the newest, forgetting the oldest first if full. */
+  void PushFront(page_id_t page_id);
+
+  /** @brief Forget the oldest page. The list must not be empty. */
+  void PopBack();
+
+ private:
+  /** Node index of an empty slot and of the ends of the list. */
+  static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+  struct Node {
+    page_id_t page_id_;
+    /** Neighbour towards the front. */
+    uint32_t prev_;
+    /** Neighbour towards the back, or the next free node while the node is free. */
+    uint32_t next_;
+  };
+
+  /** @return the slot of index_ that holds page_id, NO_NODE if it is not remembered */
+  auto FindSlot(page_id_t page_id) const -> uint32_t;
+
+  /** @return the home slot of page_id in index_ */
+  auto HomeSlot(page_id_t page_id) const -> uint32_t;
+
+  /** @brief Empty a slot of index_, moving later entries of its probe run back so lookups still find them. */
+  void EraseSlot(uint32_t slot);
+
+  /** @brief Unlink a node from the list and put it on the free list. */
+  void Release(uint32_t node);
+
+  size_t capacity_;
+  size_t size_{0};
+  std::vector<Node> nodes_;
+  uint32_t front_{NO_NODE};
+  uint32_t back_{NO_NODE};
+  uint32_t free_{NO_NODE};
+  /** Node index of each remembered page, NO_NODE for an empty slot. A power of two at least twice the capacity. */
+  std::vector<uint32_t> index_;
+  uint32_t mask_;
+};
+
+}  // namespace bustub
@@ -12,12 +12,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <limits>
-#include <list>
 #include <mutex>  // NOLINT
-#include <unordered_map>
 #include <utility>
 #include <vector>
+
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "common/macros.h"
 
@@ -33,8 +34,14 @@ namespace bustub {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * Optionally, accesses can be recorded in batches (BP-Wrapper style): RecordAccess() appends the frame id to one of
+ * ACCESS_BUFFER_STRIPES buffers, picked by the calling thread, and only takes the replacer latch once a buffer holds
+ * access_batch_size accesses, to replay all of them at once. Operations that depend on access history (Evict,
+ * Remove, EvictionOrder, and SetEvictable on a frame whose first access is still buffered) drain the buffers first,
+ * so batching only delays when an access is applied, never loses one.
  */
-class LRUKReplacer {
+class LRUKReplacer : public Replacer {
  public:
   /**
    *
@@ -42,8 +49,11 @@ class LRUKReplacer {
    *
    * @brief a new LRUKReplacer.
    * @param num_frames the maximum number of frames the LRUReplacer will be required to store
+   * @param k the lookback constant k
+   * @param access_batch_size number of accesses buffered per stripe before they are applied, 0 applies every
+   * access immediately under the replacer latch
    */
-  explicit LRUKReplacer(size_t num_frames, size_t k);
+  explicit LRUKReplacer(size_t num_frames, size_t k, size_t access_batch_size = 0);
 
   DISALLOW_COPY_AND_MOVE(LRUKReplacer);
 
@@ -52,7 +62,7 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
   /**
    * TODO(P1): Add implementation
@@ -70,7 +80,7 @@ class LRUKReplacer {
    * @param[out] frame_id id of frame that is evicted.
    * @return true if a frame is evicted successfully, false if no frames can be evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
   /**
    * TODO(P1): Add implementation
@@ -81,9 +91,12 @@ class LRUKReplacer {
    * If frame id is invalid (ie. larger than replacer_size_), throw an exception. You can
    * also use BUSTUB_ASSERT to abort the process if frame id is invalid.
    *
+   * A scan access is only recorded if it is the frame's first, so rescanning a page never earns it k accesses.
+   *
    * @param frame_id id of frame that received a new access.
+   * @param access_type what the access is for
    */
-  void RecordAccess(frame_id_t frame_id);
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
 
   /**
    * TODO(P1): Add implementation
@@ -102,7 +115,7 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
    * TODO(P1): Add implementation
@@ -121,7 +134,18 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
+
+  /**
+   * @brief List evictable frames in the order Evict() would pick them, without evicting anything or touching
+   * their access history.
+   *
+   * This lets the buffer pool write dirty pages back before they are chosen as victims.
+   *
+   * @param max_frames stop after this many frames
+   * @param[out] frames the evictable frames, the next victim first
+   */
+  void EvictionOrder(size_t max_frames, std::vector<frame_id_t> *frames) override;
 
   /**
    * TODO(P1): Add implementation
@@ -130,21 +154,101 @@ class LRUKReplacer {
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  [[maybe_unused]] size_t current_timestamp_{0};
-  size_t curr_size_{0};
+  /** Position in evictable_ of a frame that is not evictable. */
+  static constexpr size_t NOT_EVICTABLE = std::numeric_limits<size_t>::max();
+
+  /** Replacer state of one frame. Nodes are preallocated for every frame, so recording accesses never allocates. */
+  struct LRUKNode {
+    /** Number of accesses recorded since the frame entered the replacer, 0 if it is not in the replacer. */
+    size_t access_count_{0};
+    /** Index of the frame in evictable_, NOT_EVICTABLE if it is not evictable. */
+    size_t heap_index_{NOT_EVICTABLE};
+  };
+
+  /**
+   * Position of a frame in the eviction order: (has k accesses, timestamp).
+   *
+   * Frames with fewer than k accesses (+inf backward k-distance) sort first, ordered by their earliest access. The
+   * others follow ordered by their k-th most recent access, the oldest one having the largest backward k-distance.
+   * In both cases the timestamp is the oldest one in the frame's history ring. Timestamps are unique, so keys are too.
+   */
+  using EvictKey = std::pair<bool, size_t>;
+
+  /** @brief Return the eviction order key of a frame with at least one access. */
+  auto KeyOf(frame_id_t frame_id) const -> EvictKey;
+
+  /** @brief Whether the frame at heap index a should be evicted before the one at index b. */
+  auto HeapLess(size_t a, size_t b) const -> bool { return KeyOf(evictable_[a]) < KeyOf(evictable_[b]); }
+
+  /** @brief Swap two entries of evictable_, keeping heap_index_ up to date. */
+  void HeapSwap(size_t a, size_t b);
+
+  /** @brief Restore the heap property around index i after the key at i changed. */
+  void HeapFix(size_t i);
+
+  /** Accesses buffered by the threads that map to one stripe. Aligned so stripes don't share cache lines. */
+  struct alignas(64) AccessBuffer {
+    std::mutex latch_;
+    /** Buffered frame ids, in access order. Sized access_batch_size_ up front. */
+    std::vector<frame_id_t> frames_;
+    size_t count_{0};
+  };
+
+  /** Number of access buffers, threads hash onto them by thread id. */
+  static constexpr size_t ACCESS_BUFFER_STRIPES = 16;
+
+  /**
+   * @brief Apply one access to the history of a frame.
+   * Caller should acquire latch_ before calling this function.
+   */
+  void RecordAccessInternal(frame_id_t frame_id);
+
+  /**
+   * @brief Apply and clear the accesses buffered in every stripe.
+   * Caller should acquire latch_ before calling this function.
+   */
+  void DrainAccessBuffers();
+
+  /**
+   * @brief Apply and clear the accesses buffered in one stripe.
+   * Caller should acquire latch_ before calling this function.
+   */
+  void DrainAccessBuffer(AccessBuffer *buffer);
+
+  /** @brief Add an evictable frame to evictable_. */
+  void HeapPush(frame_id_t frame_id);
+
+  /** @brief Remove the entry at index i from evictable_. */
+  void HeapErase(size_t i);
+
+  size_t current_timestamp_{0};
   size_t replacer_size_;
   size_t k_;
-  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> history_page_map_;
-  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> cache_page_map_;
-  std::unordered_map<frame_id_t, bool> is_evictable_;
-  std::unordered_map<frame_id_t, size_t> access_count_;
-  std::list<frame_id_t> list_;
-  std::list<frame_id_t> history_;
+  /** State of every frame, indexed by frame id. */
+  std::vector<LRUKNode> nodes_;
+  /**
+   * Whether each frame's access_count_ is non-zero, readable without latch_. A scan access to a frame that already has
+   * history is ignored, this lets RecordAccess() tell so without the latch.
+   */
+  std::vector<std::atomic<bool>> has_history_;
+  /**
+   * Timestamps of the last k accesses of every frame: frame f owns entries [f * k, (f + 1) * k), a ring indexed by
+   * its access count modulo k.
+   */
+  std::vector<size_t> history_;
+  /**
+   * Binary min-heap of the evictable frames, ordered by KeyOf() so the next victim is at the front. The first
+   * curr_size_ entries are in use, the storage is sized for every frame up front.
+   */
+  std::vector<frame_id_t> evictable_;
+  size_t curr_size_{0};
+  /** Number of accesses buffered per stripe before they are applied, 0 if accesses are not buffered. */
+  size_t access_batch_size_;
+  /** Stripes of buffered accesses, empty if accesses are not buffered. Lock order is latch_ before a stripe latch. */
+  std::vector<AccessBuffer> access_buffers_;
   std::mutex latch_;
 };
 
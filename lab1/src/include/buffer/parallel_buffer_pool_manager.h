@@ -0,0 +1,188 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager shards the buffer pool across several BufferPoolManagerInstances so that
+ * operations on different pages do not contend on a single latch.
+ *
+ * A page always lives in the instance with index (page_id mod num_instances). New pages are allocated
+ * round-robin across the instances.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @brief Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to store
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer of each instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of each instance
+   * @param page_table_type the page table implementation of each instance
+   * @param frame_memory page size and NUMA placement of the frames of each instance. With NumaPolicy::Bind,
+   * instance i is bound to node i modulo the number of nodes, so the shards spread over the machine.
+   * @param replacer_access_batch access batching of each instance's LRU-K replacer, see BufferPoolManagerInstance
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRUK,
+                            PageTableType page_table_type = PageTableType::Dense,
+                            const FrameMemoryOptions &frame_memory = {}, size_t replacer_access_batch = 0);
+
+  /**
+   * @brief Destroy an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @brief Return the size (number of frames) of all the buffer pool instances combined. */
+  auto GetPoolSize() -> size_t override;
+
+  using BufferPoolManager::FetchPage;
+
+  /**
+   * @brief Fetch a page from the instance responsible for it, see BufferPoolManagerInstance::FetchPage().
+   * @param page_id id of page to be fetched
+   * @param access_type what the access is for
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPage(page_id_t page_id, AccessType access_type) -> Page *;
+
+  /**
+   * @brief Resize the scan ring of every instance, see BufferPoolManagerInstance::SetScanRingSize().
+   * @param num_frames the number of frames scan fetches recycle in each instance
+   */
+  void SetScanRingSize(size_t num_frames);
+
+  /**
+   * @brief Start the background flusher of every instance, see BufferPoolManagerInstance::StartFlusher().
+   * The watermarks apply to each instance separately.
+   */
+  void StartFlusher(std::chrono::milliseconds interval = std::chrono::milliseconds(100), double high_watermark = 0.25,
+                    double low_watermark = 0.1, size_t batch_size = 64);
+
+  /** @brief Stop the background flusher of every instance. */
+  void StopFlusher();
+
+  /**
+   * @brief Prefetch pages in the background, see BufferPoolManagerInstance::PrefetchPages().
+   * @param page_ids ids of the pages that are about to be fetched, each is handed to the instance owning it
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * @brief Turn sequential read-ahead on or off for every instance, see BufferPoolManagerInstance::SetReadAhead().
+   * @param window number of pages each instance reads ahead of a sequential scan, 0 turns read-ahead off
+   */
+  void SetReadAhead(size_t window);
+
+  /** @brief Fetch a page into a guard, see BufferPoolManagerInstance::FetchPageBasic(). */
+  auto FetchPageBasic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> BasicPageGuard;
+
+  /** @brief Fetch a read latched page into a guard, see BufferPoolManagerInstance::FetchPageRead(). */
+  auto FetchPageRead(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> ReadPageGuard;
+
+  /** @brief Fetch a write latched page into a guard, see BufferPoolManagerInstance::FetchPageWrite(). */
+  auto FetchPageWrite(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> WritePageGuard;
+
+  /**
+   * @brief Create a new page like NewPgImp() and hand its pin to a guard.
+   * @param[out] page_id id of created page
+   * @return a guard on the new page, empty if no instance could create a new page
+   */
+  auto NewPageGuarded(page_id_t *page_id) -> BasicPageGuard;
+
+  /**
+   * @brief Sum up the stats of all instances, see BufferPoolManagerInstance::GetStats(). A new page that an
+   * instance could not create counts as a failure of that instance even if the next instance created it.
+   */
+  auto GetStats() -> BufferPoolStats;
+
+  /** @brief Turn latency tracking of all instances on or off, see BufferPoolManagerInstance::SetLatencyTracking(). */
+  void SetLatencyTracking(bool enabled);
+
+ protected:
+  /**
+   * @brief Return the BufferPoolManagerInstance responsible for handling the given page id.
+   * @param page_id id of page
+   * @return pointer to the BufferPoolManagerInstance responsible for handling the given page id
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /**
+   * @brief Create a new page. Instances are tried round-robin: each call starts at the instance after the one the
+   * previous call started at, and moves on to the next instance until one of them can create the page.
+   *
+   * @param[out] page_id id of created page
+   * @return nullptr if no instance could create a new page, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /**
+   * @brief Fetch the requested page from the instance responsible for it.
+   * @param page_id id of page to be fetched
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * @brief Unpin the target page from the instance responsible for it.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * @brief Flush the target page to disk through the instance responsible for it.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Flush all the pages of every instance to disk.
+   */
+  void FlushAllPgsImp() override;
+
+  /**
+   * @brief Delete a page from the instance responsible for it.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /** Number of frames of each instance. */
+  const size_t pool_size_;
+  /** The instances, instance i owns every page id with (page_id mod num_instances) == i. */
+  std::vector<std::unique_ptr<BufferPoolManagerInstance>> instances_;
+  /** Index of the instance the next NewPgImp() call starts at. */
+  size_t start_index_ = 0;
+  /** This latch protects start_index_. */
+  std::mutex latch_;
+};
+}  // namespace bustub
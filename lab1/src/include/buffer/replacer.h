@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer.h
+//
+// Identification: src/include/buffer/replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** Replacement policies the buffer pool can be configured with. */
+enum class ReplacerType { LRUK = 0, Clock, TwoQueue, ARC };
+
+/**
+ * What a page access is for. Scan accesses touch every page of a table once and are not evidence that a page is hot,
+ * so replacers record them without promoting the frame, and the buffer pool recycles scan pages within a small ring
+ * of frames. The other kinds are treated as ordinary accesses.
+ */
+enum class AccessType { Unknown = 0, Lookup, Scan, Index };
+
+/**
+ * Replacer is an abstract class that tracks frame usage and picks the frame to evict when the buffer pool is full.
+ *
+ * Frames enter the replacer on their first RecordAccess() and start out non-evictable. The buffer pool marks a frame
+ * evictable once it is unpinned, and only evictable frames are candidates for Evict() and Remove(). Implementations
+ * are thread safe.
+ */
+class Replacer {
+ public:
+  Replacer() = default;
+  virtual ~Replacer() = default;
+
+  /**
+   * @brief Pick a victim among the evictable frames, remove it from the replacer along with its history.
+   * @param[out] frame_id id of frame that is evicted.
+   * @return true if a frame is evicted successfully, false if no frames can be evicted.
+   */
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
+
+  /**
+   * @brief Record that the given frame was accessed. The frame enters the replacer if it is not tracked yet.
+   *
+   * A scan access to a frame the replacer already tracks leaves the frame where it is. A frame that enters through a
+   * scan access is ranked as a frame seen once, which is the cheapest kind to evict under every policy.
+   *
+   * @param frame_id id of frame that received a new access, an invalid id throws or aborts.
+   * @param access_type what the access is for
+   */
+  virtual void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) = 0;
+
+  /**
+   * @brief Toggle whether a frame is evictable. Frames the replacer does not track are ignored.
+   * @param frame_id id of frame whose 'evictable' status will be modified
+   * @param set_evictable whether the given frame is evictable or not
+   */
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
+
+  /**
+   * @brief Remove an evictable frame from the replacer, along with its history, regardless of where it stands in the
+   * eviction order. Removing a non-evictable frame throws or aborts, an untracked frame is ignored.
+   * @param frame_id id of frame to be removed
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
+  /** @brief Return the number of evictable frames. */
+  virtual auto Size() -> size_t = 0;
+
+  /**
+   * @brief List evictable frames in the order Evict() would pick them if no further accesses happened, without
+   * evicting anything or touching their history.
+   * @param max_frames stop after this many frames
+   * @param[out] frames the evictable frames, the next victim first
+   */
+  virtual void EvictionOrder(size_t max_frames, std::vector<frame_id_t> *frames) = 0;
+
+  /**
+   * @brief Tell the replacer which page the frame is about to hold, before the frame's first RecordAccess().
+   *
+   * Policies that remember recently evicted pages (the ghost lists of 2Q and ARC) need the page id to recognize a
+   * page coming back into the pool, frame ids alone are reused for unrelated pages. Other policies ignore it.
+   *
+   * @param frame_id id of the frame
+   * @param page_id id of the page that will live in the frame
+   */
+  virtual void SetFramePage(__attribute__((unused)) frame_id_t frame_id,
+                            __attribute__((unused)) page_id_t page_id) {}
+};
+
+}  // namespace bustub
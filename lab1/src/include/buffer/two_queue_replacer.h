@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.h
+//
+// Identification: src/include/buffer/two_queue_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/frame_list.h"
+#include "buffer/ghost_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TwoQueueReplacer implements the 2Q replacement policy (Johnson & Shasha, VLDB '94).
+ *
+ * Frames seen for the first time enter A1in, a FIFO queue. Re-references while in A1in are treated as correlated and
+ * do not move the frame. When A1in holds more than a quarter of the frames, victims come from A1in and their page ids
+ * are remembered in A1out, a FIFO ghost queue of up to half the frame count. A page that comes back while it is
+ * remembered in A1out has proven to be hot and enters Am, an LRU queue, which is where victims come from otherwise.
+ * Scans therefore churn through A1in without flushing the hot pages out of Am.
+ *
+ * The ghost queue needs the page ids given by SetFramePage(). For frames without one, a re-reference in A1in promotes
+ * the frame to Am instead (the "simplified 2Q" of the paper).
+ *
+ * The queues only link their evictable frames, in flat per-frame arrays, so a pinned frame is never walked past and
+ * Evict() takes the back of a queue in O(1). A frame keeps its place in its queue while pinned: its stamp records when
+ * it entered A1in or was last used in Am, and unpinning links it back where the stamp puts it. A1out is a GhostList,
+ * allocated at construction like the rest, so no access allocates.
+ */
+class TwoQueueReplacer : public Replacer {
+ public:
+  /**
+   * @brief Create a new TwoQueueReplacer.
+   * @param num_frames the maximum number of frames the TwoQueueReplacer will be required to store
+   */
+  explicit TwoQueueReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(TwoQueueReplacer);
+
+  ~TwoQueueReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void EvictionOrder(size_t max_frames, std::vector<frame_id_t> *frames) override;
+
+  void SetFramePage(frame_id_t frame_id, page_id_t page_id) override;
+
+ private:
+  /** Which queue a frame is in. */
+  enum class Queue { None = 0, A1In, Am };
+
+  /** Replacer state of one frame. */
+  struct FrameState {
+    Queue queue_{Queue::None};
+    bool is_evictable_{false};
+    /** Page the frame holds, INVALID_PAGE_ID if unknown. */
+    page_id_t page_id_{INVALID_PAGE_ID};
+    /** Place in the queue: when the frame entered A1in, or when it was last used in Am. */
+    uint64_t stamp_{0};
+    /** Links in a1_in_ or am_, while the frame is evictable. */
+    frame_id_t prev_{FrameList<FrameState>::NONE};
+    frame_id_t next_{FrameList<FrameState>::NONE};
+  };
+
+  /** @return the list of evictable frames of a queue */
+  auto ListOf(Queue queue) -> FrameList<FrameState> & { return queue == Queue::A1In ? a1_in_ : am_; }
+
+  /** @brief Put an untracked frame at the newest end of a queue. */
+  void Enter(frame_id_t frame_id, Queue queue);
+
+  /** @brief Take a tracked frame out of its queue. */
+  void Leave(frame_id_t frame_id);
+
+  /** @brief Remember an evicted A1in page in A1out, forgetting the oldest ghost if A1out is full. */
+  void RememberGhost(page_id_t page_id);
+
+  size_t replacer_size_;
+  /** A1in is allowed to grow past this many frames before it is preferred for eviction. */
+  size_t kin_;
+  /** Maximum number of page ids remembered in A1out. */
+  size_t kout_;
+  /** Source of the stamps, increasing. */
+  uint64_t next_stamp_{0};
+  std::vector<FrameState> frames_;
+  /** Evictable frames of A1in, a FIFO of frames seen once, newest at the front. */
+  FrameList<FrameState> a1_in_;
+  /** Evictable frames of Am, an LRU of hot frames, most recently used at the front. */
+  FrameList<FrameState> am_;
+  /** Frames in A1in and in Am, evictable or not. */
+  size_t a1_in_size_{0};
+  size_t am_size_{0};
+  /** Page ids recently evicted from A1in, newest at the front. */
+  GhostList a1_out_;
+  size_t curr_size_{0};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// epoch_manager.h
+//
+// Identification: src/include/common/epoch_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>  // NOLINT
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * EpochManager implements epoch-based reclamation for data structures whose readers take no latches.
+ *
+ * A reader pins the current epoch for as long as it may dereference shared pointers. A writer that unlinks an object
+ * hands it to Retire() instead of deleting it, and the object is only deleted once every reader that was pinned when
+ * it was retired has unpinned. Pinning is a compare-and-swap on one of a fixed set of cache-line sized slots, so
+ * readers do not contend on a shared reader count. Readers beyond the number of slots are registered in a latched
+ * overflow list instead of waiting, so pinning never blocks, however many guards live and however long.
+ */
+class EpochManager {
+ public:
+  /** RAII pin of the current epoch, see Pin(). */
+  class Guard {
+   public:
+    ~Guard();
+    DISALLOW_COPY_AND_MOVE(Guard);
+
+   private:
+    friend class EpochManager;
+    Guard(EpochManager *manager, size_t slot) : manager_(manager), slot_(slot) {}
+    Guard(EpochManager *manager, std::list<uint64_t>::iterator overflow)
+        : manager_(manager), slot_(OVERFLOW_SLOT), overflow_(overflow) {}
+
+    EpochManager *manager_;
+    /** The slot the guard occupies, OVERFLOW_SLOT if it is in the overflow list. */
+    size_t slot_;
+    /** The guard's entry in the overflow list, if slot_ is OVERFLOW_SLOT. */
+    std::list<uint64_t>::iterator overflow_;
+  };
+
+  EpochManager() = default;
+  DISALLOW_COPY_AND_MOVE(EpochManager);
+
+  /** @brief Delete every retired object. No thread may be pinned. */
+  ~EpochManager();
+
+  /**
+   * @brief Pin the current epoch. Objects retired while the guard lives are not deleted until it is destroyed, so a
+   * long-lived guard holds back reclamation. Pinning while NUM_SLOTS guards live takes overflow_latch_.
+   */
+  auto Pin() -> Guard;
+
+  /**
+   * @brief Delete an object once no reader that could still see it is pinned.
+   * The object must already be unreachable for readers that pin from now on.
+   * @param object the unlinked object, allocated with new
+   */
+  template <typename T>
+  void Retire(T *object) {
+    Retire(object, [](void *p) { delete static_cast<T *>(p); });
+  }
+
+  /**
+   * @brief Like Retire(object), for objects that are not released with delete.
+   * @param object the unlinked object
+   * @param deleter called with object once it is safe to release it
+   */
+  void Retire(void *object, void (*deleter)(void *));
+
+ private:
+  /** Number of reader slots. Readers beyond this many go to the overflow list. */
+  static constexpr size_t NUM_SLOTS = 64;
+  /** Guard::slot_ of a guard in the overflow list. */
+  static constexpr size_t OVERFLOW_SLOT = NUM_SLOTS;
+  /** Value of a slot no reader occupies. */
+  static constexpr uint64_t INACTIVE = 0;
+
+  /** A reader slot, alone on its cache line. */
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> epoch_{INACTIVE};
+  };
+
+  /** An object waiting for the readers of its epoch to unpin. */
+  struct Retired {
+    uint64_t epoch_;
+    void *object_;
+    void (*deleter_)(void *);
+  };
+
+  /**
+   * @brief Delete the retired objects that no pinned reader can see. Caller must hold retired_latch_. Only the
+   * objects freed and the readers are visited, so retiring stays cheap while an old reader holds everything back.
+   */
+  void Reclaim();
+
+  /** The current epoch, starts above INACTIVE. */
+  std::atomic<uint64_t> global_epoch_{1};
+  Slot slots_[NUM_SLOTS];
+  /** Guards overflow_. */
+  std::mutex overflow_latch_;
+  /** Pinned epochs of the readers that found every slot taken. */
+  std::list<uint64_t> overflow_;
+  /** Guards retired_. */
+  std::mutex retired_latch_;
+  /** Retired objects in the order of their epochs, which Retire() hands out in increasing order under the latch. */
+  std::deque<Retired> retired_;
+};
+
+}  // namespace bustub
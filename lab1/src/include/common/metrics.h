@@ -0,0 +1,177 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics.h
+//
+// Identification: src/include/common/metrics.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/** Number of shards of a Sharded metric. Threads beyond this many share shards. */
+static constexpr size_t METRIC_SHARDS = 16;
+
+/** @return the metric shard of the calling thread. Threads are dealt shards round-robin on first use. */
+inline auto MetricShard() -> size_t {
+  static std::atomic<size_t> next_shard{0};
+  thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+  return shard;
+}
+
+/** @brief Add n to a metric counter. Counters are only summed up for snapshots, so no ordering is needed. */
+inline void Bump(std::atomic<uint64_t> *counter, uint64_t n = 1) { counter->fetch_add(n, std::memory_order_relaxed); }
+
+/**
+ * Sharded holds one Shard of metrics per METRIC_SHARDS, each on its own cache lines. A thread updates only the shard
+ * it is dealt, so threads updating the same metric do not bounce a cache line between them, and a snapshot sums the
+ * shards.
+ */
+template <typename Shard>
+class Sharded {
+ public:
+  /** @return the shard of the calling thread */
+  auto Local() -> Shard & { return shards_[MetricShard()].shard_; }
+
+  /** @brief Call f on every shard, to sum them up. */
+  template <typename F>
+  void ForEach(F &&f) const {
+    for (const auto &padded : shards_) {
+      f(padded.shard_);
+    }
+  }
+
+ private:
+  struct alignas(64) Padded {
+    Shard shard_;
+  };
+
+  Padded shards_[METRIC_SHARDS];
+};
+
+/** Number of buckets of a LatencyHistogram. */
+static constexpr size_t LATENCY_BUCKETS = 40;
+
+/** The contents of a LatencyHistogram at one point in time. */
+struct HistogramSnapshot {
+  /** Bucket 0 counts latencies of 0ns, bucket i > 0 counts latencies in [2^(i-1), 2^i) ns. */
+  std::array<uint64_t, LATENCY_BUCKETS> buckets_{};
+  uint64_t count_{0};
+  uint64_t sum_ns_{0};
+
+  auto MeanNanos() const -> double {
+    return count_ == 0 ? 0.0 : static_cast<double>(sum_ns_) / static_cast<double>(count_);
+  }
+
+  /**
+   * @param fraction the percentile as a fraction, e.g. 0.99
+   * @return an upper bound on the latency of that percentile, the end of the bucket it falls into
+   */
+  auto PercentileNanos(double fraction) const -> uint64_t {
+    const auto rank = static_cast<uint64_t>(fraction * static_cast<double>(count_));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      seen += buckets_[i];
+      if (seen > rank || seen == count_) {
+        return i == 0 ? 0 : uint64_t{1} << i;
+      }
+    }
+    return uint64_t{1} << (LATENCY_BUCKETS - 1);
+  }
+
+  /** @brief Add the latencies of another snapshot, e.g. of another buffer pool instance. */
+  void Merge(const HistogramSnapshot &other) {
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ns_ += other.sum_ns_;
+  }
+};
+
+/**
+ * LatencyHistogram counts latencies in power-of-two buckets of nanoseconds, sharded like Sharded counters. Recording
+ * a latency is two relaxed increments on the calling thread's shard.
+ */
+class LatencyHistogram {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  void Record(uint64_t nanos) {
+    auto &shard = shards_.Local();
+    Bump(&shard.buckets_[BucketOf(nanos)]);
+    Bump(&shard.sum_ns_, nanos);
+  }
+
+  void Record(Clock::time_point start) {
+    Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+  }
+
+  auto Snapshot() const -> HistogramSnapshot {
+    HistogramSnapshot snapshot;
+    shards_.ForEach([&](const Shard &shard) {
+      for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        const uint64_t count = shard.buckets_[i].load(std::memory_order_relaxed);
+        snapshot.buckets_[i] += count;
+        snapshot.count_ += count;
+      }
+      snapshot.sum_ns_ += shard.sum_ns_.load(std::memory_order_relaxed);
+    });
+    return snapshot;
+  }
+
+ private:
+  struct Shard {
+    std::atomic<uint64_t> buckets_[LATENCY_BUCKETS]{};
+    std::atomic<uint64_t> sum_ns_{0};
+  };
+
+  static auto BucketOf(uint64_t nanos) -> size_t {
+    if (nanos == 0) {
+      return 0;
+    }
+    return std::min<size_t>(64 - __builtin_clzll(nanos), LATENCY_BUCKETS - 1);
+  }
+
+  Sharded<Shard> shards_;
+};
+
+/**
+ * RAII measurement of one operation: records the time from construction to destruction into a histogram. Nothing is
+ * measured, not even the clock read, when the histogram is nullptr, so latency tracking can be switched off cheaply.
+ */
+class LatencyTimer {
+ public:
+  explicit LatencyTimer(LatencyHistogram *histogram) : histogram_(histogram) {
+    if (histogram_ != nullptr) {
+      start_ = LatencyHistogram::Clock::now();
+    }
+  }
+
+  ~LatencyTimer() {
+    if (histogram_ != nullptr) {
+      histogram_->Record(start_);
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(LatencyTimer);
+
+ private:
+  LatencyHistogram *histogram_;
+  LatencyHistogram::Clock::time_point start_;
+};
+
+}  // namespace bustub
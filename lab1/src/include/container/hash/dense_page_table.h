@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// dense_page_table.h
+//
+// Identification: src/include/container/hash/dense_page_table.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/epoch_manager.h"
+#include "container/hash/extendible_hash_table.h"
+#include "container/hash/hash_table.h"
+
+namespace bustub {
+
+/**
+ * DensePageTable maps page ids to frame ids through a three-level radix tree indexed by the page id itself.
+ *
+ * Page ids are dense integers, and a buffer pool instance that is shard offset of stride shards only allocates ids
+ * congruent to offset, so (page_id - offset) / stride indexes a mostly full array with no hashing and no collisions.
+ * The top level is sized at construction to cover every non-negative page id. Mid-level nodes are allocated the first
+ * time an id in their range is inserted and stay until the table is destroyed; there are at most 1024 of them, each
+ * covering 2M page ids. Leaves are allocated the same way, and each counts its live entries so that it is unlinked
+ * when its last entry is removed. An unlinked leaf is kept on a free list once no lookup can still see it, and the
+ * next leaf comes from that list, so a buffer pool whose residency is sparse (a database much larger than the pool)
+ * recycles leaves instead of allocating and clearing one on every miss. The free list holds at most about
+ * pool_size / LEAF_SIZE leaves, or MIN_FREE_LEAVES, and it is reserved at construction. The table therefore holds at
+ * most one leaf per mapped page plus the free list, and far fewer when the mapped ids are clustered the way allocated
+ * page ids are.
+ *
+ * Every operation is safe for concurrent use. A lookup is three dependent loads under an epoch pin and never takes a
+ * latch, Insert() and Remove() serialize on latch_, which the buffer pool calls them under its own latch anyway.
+ * Freed nodes go through epochs_, so a concurrent lookup never reads a freed node. Ids that do not belong to the
+ * shard (negative, or not congruent to offset) are rare and go to a small fallback ExtendibleHashTable.
+ */
+class DensePageTable : public HashTable<page_id_t, frame_id_t> {
+ public:
+  /**
+   * @brief Create an empty page table.
+   * @param stride number of buffer pool instances page ids are spread over
+   * @param offset index of the instance that owns this table, the ids it indexes are congruent to it modulo stride
+   * @param pool_size number of frames of the buffer pool, which sizes the free list of leaves
+   */
+  explicit DensePageTable(uint32_t stride = 1, uint32_t offset = 0, size_t pool_size = 0);
+
+  DISALLOW_COPY_AND_MOVE(DensePageTable);
+
+  ~DensePageTable() override;
+
+  auto Find(const page_id_t &page_id, frame_id_t &frame_id) -> bool override;
+
+  void Insert(const page_id_t &page_id, const frame_id_t &frame_id) override;
+
+  auto Remove(const page_id_t &page_id) -> bool override;
+
+ private:
+  /** Entries per leaf, a leaf of frame ids is 8 KB. */
+  static constexpr int LEAF_BITS = 11;
+  /** Leaves per mid-level node. */
+  static constexpr int MID_BITS = 10;
+  static constexpr size_t LEAF_SIZE = size_t{1} << LEAF_BITS;
+  static constexpr size_t MID_SIZE = size_t{1} << MID_BITS;
+  /** Leaf entry of an absent page. */
+  static constexpr frame_id_t NO_FRAME = -1;
+  /** Smallest capacity of the free list of leaves, so that small pools recycle leaves as well. */
+  static constexpr size_t MIN_FREE_LEAVES = 16;
+
+  struct Leaf {
+    explicit Leaf(DensePageTable *table);
+    std::atomic<frame_id_t> frames_[LEAF_SIZE];
+    /** Entries that are not NO_FRAME. Guarded by latch_. */
+    size_t live_{0};
+    /** The table whose free list takes the leaf back after it is unlinked. */
+    DensePageTable *table_;
+  };
+
+  struct Mid {
+    std::atomic<Leaf *> leaves_[MID_SIZE]{};
+  };
+
+  /**
+   * @brief Compute the dense index of an id this table indexes directly.
+   * @return false if the id belongs in the fallback table
+   */
+  inline auto IndexOf(page_id_t page_id, size_t *index) const -> bool {
+    if (page_id < 0 || static_cast<uint32_t>(page_id) % stride_ != offset_) {
+      return false;
+    }
+    *index = static_cast<uint32_t>(page_id) / stride_;
+    return true;
+  }
+
+  /**
+   * @brief Return the leaf of an index, nullptr if it does not exist.
+   * The caller must be pinned to epochs_ or hold latch_.
+   */
+  auto LeafOf(size_t index) const -> Leaf *;
+
+  /** @brief Return the leaf of an index, allocating it and its mid-level node if needed. Caller must hold latch_. */
+  auto CreateLeafOf(size_t index) -> Leaf *;
+
+  /** @brief Unlink the empty leaf of an index and retire it to the free list. Caller must hold latch_. */
+  void RetireLeafOf(size_t index);
+
+  /**
+   * @brief Take back an empty leaf no lookup can see any more, onto the free list or back to the allocator if the
+   * list is full. Called by epochs_, which only reclaims under latch_ or in its destructor.
+   */
+  void RecycleLeaf(Leaf *leaf);
+
+  const uint32_t stride_;
+  const uint32_t offset_;
+  /** Number of top-level slots, enough for the largest page id. */
+  const size_t root_size_;
+  std::unique_ptr<std::atomic<Mid *>[]> root_;
+  /** Serializes Insert() and Remove() on the dense range, and guards the live counts and free_leaves_. */
+  std::mutex latch_;
+  /** Maximum number of leaves in free_leaves_. */
+  const size_t max_free_leaves_;
+  /** Empty leaves ready for reuse. Declared before epochs_, whose destructor may still hand leaves to it. */
+  std::vector<std::unique_ptr<Leaf>> free_leaves_;
+  /** Keeps the leaves emptied by Remove() away from the free list until the lookups that may see them are done. */
+  EpochManager epochs_;
+  /** Page ids outside the dense range of the shard. */
+  ExtendibleHashTable<page_id_t, frame_id_t> overflow_;
+};
+
+}  // namespace bustub
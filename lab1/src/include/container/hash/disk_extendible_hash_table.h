@@ -0,0 +1,165 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_extendible_hash_table.h
+//
+// Identification: src/include/container/hash/disk_extendible_hash_table.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/rwlatch.h"
+#include "container/hash/extendible_hash_table.h"
+#include "storage/page/hash_table_bucket_page.h"
+#include "storage/page/hash_table_directory_page.h"
+#include "storage/page/hash_table_header_page.h"
+
+namespace bustub {
+
+/**
+ * DiskExtendibleHashTable is an extendible hash table whose pages are fetched through a buffer pool, so it can index
+ * more data than fits in memory and is reopened from its header page id without a rebuild.
+ *
+ * The table has three levels of pages. The HashTableHeaderPage selects a directory by the top bits of the hash. Each
+ * HashTableDirectoryPage holds a global depth and, per slot, a bucket page id and its local depth, and indexes its
+ * buckets by the low bits of the hash. Each bucket is one HashTableBucketPage. Directories are created on the first
+ * insert into their part of the hash space, so a small table is one header, one directory and a few buckets. With
+ * the header's 512 slots of 512-slot directories, the table grows to 2^18 bucket pages (about 130M <int, int>
+ * entries) before Insert() fails.
+ *
+ * Within a directory, splits and merges follow ExtendibleHashTable: a full bucket splits on its next hash bit
+ * (doubling the directory first if needed), and Remove() merges a bucket into its split image once both fit in
+ * merge_fill of a page, then halves the directory while no bucket needs the global depth.
+ *
+ * Lookups, and inserts and removals that do not change the structure, take the table latch shared plus the latch of
+ * the one bucket page involved. Splits, merges and creating a directory take the table latch exclusively, which is
+ * also what keeps the header and directory pages stable for everyone holding it shared. Operations within one bucket
+ * pin one page at a time, splits and merges at most three.
+ *
+ * A buffer pool without a free frame is not an error of the table: the operation that cannot fetch a page unpins what
+ * it holds and fails, leaving the table as it was or in another valid state (e.g. doubled, without the split).
+ *
+ * Nothing is cached outside the buffer pool, so the index is persistent as soon as its pages are flushed. The hash
+ * function must give the same result across runs for a reopened table to find its keys (MixHash does for integers).
+ *
+ * @tparam K key type, trivially copyable
+ * @tparam V value type, trivially copyable
+ * @tparam Hash hash function object
+ * @tparam KeyEqual key equality
+ */
+template <typename K, typename V, typename Hash = MixHash<K>, typename KeyEqual = std::equal_to<K>>
+class DiskExtendibleHashTable {
+  using BucketPage = HashTableBucketPage<K, V, KeyEqual>;
+
+ public:
+  static constexpr double DEFAULT_MERGE_FILL = 0.5;
+
+  /**
+   * @brief Create a new table, or open the one whose header is at header_page_id. Throws Exception if the page is not
+   * the header of a table, or if the buffer pool has no frame for it.
+   * @param bpm the buffer pool the pages of the table live in
+   * @param header_page_id header page of an existing table, INVALID_PAGE_ID creates an empty table
+   * @param hash_fn the hash function
+   * @param merge_fill merge a bucket and its split image when their entries fit in this fraction of a page
+   * @param header_max_depth number of top hash bits that select a directory, for a new table. Every directory takes
+   * a page plus at least one bucket page once a key hashes to it, so tables that stay small are cheaper with fewer
+   * bits, at the price of a lower limit on their size.
+   */
+  explicit DiskExtendibleHashTable(BufferPoolManager *bpm, page_id_t header_page_id = INVALID_PAGE_ID,
+                                   const Hash &hash_fn = Hash(), double merge_fill = DEFAULT_MERGE_FILL,
+                                   uint32_t header_max_depth = HashTableHeaderPage::MAX_DEPTH);
+
+  DISALLOW_COPY_AND_MOVE(DiskExtendibleHashTable);
+
+  ~DiskExtendibleHashTable() = default;
+
+  /** @brief Return the header page id, which is all that is needed to reopen the table. */
+  auto GetHeaderPageId() const -> page_id_t { return header_page_id_; }
+
+  /**
+   * @brief Find the value associated with the given key.
+   * @param key the key to be searched
+   * @param[out] value the value associated with the key
+   * @return True if the key is found, false if it is not or the buffer pool has no frame for the pages involved.
+   */
+  auto Find(const K &key, V *value) -> bool;
+
+  /**
+   * @brief Insert a key-value pair, updating the value if the key exists.
+   * @return False if the key's bucket is full at the maximum depth of its directory, or the buffer pool has no frame
+   * for the pages involved.
+   */
+  auto Insert(const K &key, const V &value) -> bool;
+
+  /**
+   * @brief Remove a key, merging its bucket and shrinking its directory where possible.
+   * @return True if the key existed, false if it did not or the buffer pool has no frame for the pages involved.
+   */
+  auto Remove(const K &key) -> bool;
+
+  /** @brief Get the largest global depth of any directory. Directories the buffer pool cannot fetch are skipped. */
+  auto GetGlobalDepth() -> uint32_t;
+
+  /** @brief Check the invariants of the header and every directory, assert on failure. */
+  void VerifyIntegrity();
+
+ private:
+  auto HashOf(const K &key) const -> uint32_t { return static_cast<uint32_t>(hash_fn_(key)); }
+
+  static inline auto AsHeader(Page *page) -> HashTableHeaderPage * {
+    return reinterpret_cast<HashTableHeaderPage *>(page->GetData());
+  }
+
+  static inline auto AsDirectory(Page *page) -> HashTableDirectoryPage * {
+    return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  }
+
+  static inline auto AsBucket(Page *page) -> BucketPage * { return reinterpret_cast<BucketPage *>(page->GetData()); }
+
+  /**
+   * @brief Look up the directory of a hash in the header. Caller should hold the table latch.
+   * @param[out] directory_page_id the directory, INVALID_PAGE_ID if none has been created for the hash yet
+   * @return false if the buffer pool has no frame for the header
+   */
+  auto DirectoryOf(uint32_t hash, page_id_t *directory_page_id) -> bool;
+
+  /**
+   * @brief Look up the bucket of a hash. Caller should hold the table latch.
+   * @param[out] bucket_page_id the bucket, INVALID_PAGE_ID if the hash has no directory yet
+   * @param[out] local_depth the bucket's local depth
+   * @return false if the buffer pool has no frame for the header or the directory
+   */
+  auto BucketOf(uint32_t hash, page_id_t *bucket_page_id, uint32_t *local_depth) -> bool;
+
+  /**
+   * @brief Create the directory of a hash, with one empty bucket. Caller should hold the table latch exclusively.
+   * @param[out] directory_page_id the new directory
+   * @return false if the buffer pool has no frames for the new pages
+   */
+  auto CreateDirectory(uint32_t hash, page_id_t *directory_page_id) -> bool;
+
+  /** @brief Insert with the table latch held exclusively, splitting the key's bucket until the key fits. */
+  auto SplitInsert(const K &key, const V &value) -> bool;
+
+  /** @brief Merge the key's bucket with its split image while they fit, and shrink the directory. */
+  void Merge(const K &key);
+
+  BufferPoolManager *bpm_;
+  page_id_t header_page_id_;
+  Hash hash_fn_;
+  KeyEqual key_equal_;
+  /** A bucket and its split image are merged once they hold at most this many entries together. */
+  uint32_t merge_threshold_;
+  /** Shared for operations within one bucket, exclusive for splits, merges and new directories. */
+  ReaderWriterLatch table_latch_;
+};
+
+}  // namespace bustub
@@ -17,32 +17,123 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
-#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "common/epoch_manager.h"
+#include "common/metrics.h"
+#include "common/rwlatch.h"
 #include "container/hash/hash_table.h"
 
 namespace bustub {
 
+/** Whether T can be loaded and stored atomically without falling back to a lock. */
+template <typename T, bool = std::is_trivially_copyable_v<T>>
+struct IsLockFreeAtomic : std::false_type {};
+template <typename T>
+struct IsLockFreeAtomic<T, true> : std::bool_constant<std::atomic<T>::is_always_lock_free> {};
+
+/**
+ * The default hash function of ExtendibleHashTable: std::hash followed by the 64-bit finalizer of MurmurHash3.
+ *
+ * std::hash is the identity for integers on libstdc++, so sequential page ids would differ only in their low bits,
+ * which are exactly the bits the directory indexes by. The finalizer spreads every input bit over the whole hash.
+ */
+template <typename K>
+struct MixHash {
+  auto operator()(const K &key) const -> size_t {
+    uint64_t hash = std::hash<K>()(key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash);
+  }
+};
+
+/** Counters of an ExtendibleHashTable since its creation, see ExtendibleHashTable::GetStats(). */
+struct ExtendibleHashTableStats {
+  /** Lookups, by Find() and FindBatch(). */
+  uint64_t finds_{0};
+  /** Lookups that found their key. */
+  uint64_t find_hits_{0};
+  /** Lookups that latched the bucket because optimistic reads kept retrying or are not available. */
+  uint64_t latched_finds_{0};
+  uint64_t inserts_{0};
+  uint64_t removes_{0};
+  uint64_t splits_{0};
+  uint64_t merges_{0};
+  uint64_t directory_grows_{0};
+  uint64_t directory_shrinks_{0};
+  /** Bucket latches released again because the bucket had been split or merged, see LatchBucket(). */
+  uint64_t latch_retries_{0};
+  int global_depth_{0};
+  int num_buckets_{0};
+};
+
 /**
  * ExtendibleHashTable implements a hash table using the extendible hashing algorithm.
+ *
+ * The table is safe for concurrent use without a table-wide mutex. The directory is guarded by a reader-writer latch
+ * that is only taken exclusively to double the directory, and each bucket has its own reader-writer latch, so lookups
+ * and updates on different buckets run in parallel. A full bucket is split in place: it keeps the entries whose new
+ * hash bit is 0 and moves the others into one new sibling, so only the bucket being split is locked.
+ *
+ * A thread never waits for a bucket latch while holding the directory latch (the lock order is bucket, then
+ * directory), and merging only try-locks the second bucket. Because a bucket can be split between reading its
+ * directory slot and latching it, every bucket records the hash prefix it covers, and operations retry if the key no
+ * longer falls under it once the bucket is latched.
+ *
+ * Find() takes no latch at all when K and V fit a lock-free atomic (e.g. the buffer pool's page table). The directory
+ * is reached through an atomic pointer under an epoch guard, directories replaced by doubling are reclaimed by an
+ * EpochManager, and buckets are read optimistically under a seqlock version that writers bump, with a retry whenever
+ * a concurrent write or split is detected.
+ *
+ * Remove() merges a bucket back into its buddy (the bucket that differs from it only in the top bit of its prefix)
+ * once the two together are at most merge_fill full, and halves the directory when no bucket needs its global depth
+ * any more. Merging well below a full bucket is the hysteresis that keeps a key set hovering around a split point
+ * from splitting and merging on every other operation. Absorbed buckets are marked dead, so latched and optimistic
+ * readers holding them retry through the directory, and the EpochManager frees them once no reader is pinned.
+ *
+ * Every entry caches its full hash, so splits never rehash, and a one-byte tag taken from the top of the hash is
+ * compared before the key itself.
+ *
  * @tparam K key type
  * @tparam V value type
+ * @tparam Hash hash function object, should spread its output over all bits of size_t (the directory uses the low
+ * bits, the tags the top byte). Each instantiation has to be listed at the end of extendible_hash_table.cpp.
  */
-template <typename K, typename V>
+template <typename K, typename V, typename Hash = MixHash<K>>
 class ExtendibleHashTable : public HashTable<K, V> {
  public:
+  /** Merged buckets start out at most half full, half a bucket of inserts away from splitting again. */
+  static constexpr double DEFAULT_MERGE_FILL = 0.5;
+
   /**
    *
    * TODO(P1): Add implementation
    *
    * @brief Create a new ExtendibleHashTable.
    * @param bucket_size: fixed size for each bucket
+   * @param hash_fn: the hash function
+   * @param merge_fill: merge two buddy buckets when their entries fit in this fraction of one bucket, 0 only merges
+   * empty ones
    */
-  explicit ExtendibleHashTable(size_t bucket_size);
+  explicit ExtendibleHashTable(size_t bucket_size, const Hash &hash_fn = Hash(),
+                               double merge_fill = DEFAULT_MERGE_FILL);
+
+  DISALLOW_COPY_AND_MOVE(ExtendibleHashTable);
+
+  ~ExtendibleHashTable() override;
 
   /**
    * @brief Get the global depth of the directory.
@@ -99,50 +190,148 @@ class ExtendibleHashTable : public HashTable<K, V> {
    * TODO(P1): Add implementation
    *
    * @brief Given the key, remove the corresponding key-value pair in the hash table.
-   * Shrink & Combination is not required for this project
+   * If the bucket and its buddy then fit under the merge threshold they are combined, repeatedly while that holds, and
+   * the directory is halved while every local depth is below the global depth.
    * @param key The key to be deleted.
    * @return True if the key exists, false otherwise.
    */
   auto Remove(const K &key) -> bool override;
 
+  /**
+   * @brief Insert many key-value pairs, with the same semantics as calling Insert() on each in order.
+   *
+   * The entries are sorted by their bit-reversed hash, which puts all keys a bucket covers next to each other
+   * whatever its local depth, and each bucket is latched once for its whole run. Call Reserve() first when loading a
+   * table from empty, so the batch does not split its way up one bucket at a time.
+   *
+   * @param entries the pairs to insert, a key repeated in the batch ends up with its last value
+   */
+  void InsertBatch(const std::vector<std::pair<K, V>> &entries);
+
+  /**
+   * @brief Look up many keys. The directory slots and buckets of keys a few positions ahead are prefetched while the
+   * current key is probed, so their cache misses overlap.
+   * @param keys the keys to be searched
+   * @param[out] values resized to keys.size(), values[i] is set if found[i]
+   * @param[out] found resized to keys.size(), whether keys[i] is in the table
+   * @return the number of keys found
+   */
+  auto FindBatch(const std::vector<K> &keys, std::vector<V> *values, std::vector<bool> *found) -> size_t;
+
+  /**
+   * @brief Grow the directory and split buckets ahead of time so that count entries fit without further splits on
+   * average. Does nothing if the table is already that large. Merging only looks at buckets entries are removed from,
+   * so reserved buckets that never receive an entry are kept, like capacity reserved in a vector.
+   * @param count expected number of entries
+   */
+  void Reserve(size_t count);
+
+  /**
+   * @brief Sum up the counters of the table. They are sharded by thread and updated without synchronization, so a
+   * snapshot taken during concurrent operations may count an operation in one counter and not yet in another.
+   */
+  auto GetStats() const -> ExtendibleHashTableStats;
+
   /**
    * Bucket class for each hash table bucket that the directory points to.
+   *
+   * A bucket is a single allocation: this header followed by arrays of size hashes, keys, values and one-byte tags,
+   * filled from the front. A probe scans the tags first, sixteen per SSE2 instruction, and only compares the keys whose
+   * tag matches. Buckets are made with Create() and released with Destroy().
+   *
+   * When K and V both fit a lock-free atomic, writers store keys and values atomically and bump a seqlock version
+   * around every change, so OptimisticFind() can read the bucket without any latch.
    */
   class Bucket {
    public:
-    explicit Bucket(size_t size, int depth = 0);
+    /** Whether buckets of this table can be read without latching them. */
+    static constexpr bool OPTIMISTIC_READS = IsLockFreeAtomic<K>::value && IsLockFreeAtomic<V>::value;
+
+    /** Outcome of an OptimisticFind(). */
+    enum class ReadResult { Found, NotFound, Retry };
+
+    /**
+     * @brief Allocate a bucket together with its entry arrays.
+     * @param size fixed size of the bucket
+     * @param depth local depth of the bucket
+     * @param prefix low depth bits shared by the hashes of all keys that belong in the bucket
+     */
+    static auto Create(size_t size, int depth = 0, size_t prefix = 0) -> Bucket *;
+
+    /** @brief Free a bucket made by Create(). */
+    static void Destroy(Bucket *bucket);
+
+    DISALLOW_COPY_AND_MOVE(Bucket);
 
     /** @brief Check if a bucket is full. */
-    inline auto IsFull() const -> bool { return list_.size() == size_; }
+    inline auto IsFull() const -> bool { return count_.load(std::memory_order_relaxed) == size_; }
 
     /** @brief Get the local depth of the bucket. */
-    inline auto GetDepth() const -> int { return depth_; }
+    inline auto GetDepth() const -> int { return depth_.load(std::memory_order_relaxed); }
 
     /** @brief Increment the local depth of a bucket. */
-    inline void IncrementDepth() { depth_++; }
+    inline void IncrementDepth() { depth_.store(GetDepth() + 1, std::memory_order_relaxed); }
+
+    /** @brief Get the number of entries in the bucket. */
+    inline auto GetCount() const -> size_t { return count_.load(std::memory_order_relaxed); }
+
+    /** @brief Prefetch the header, tags and first keys of a bucket of the given size, without reading any of it. */
+    inline void Prefetch(size_t size) const {
+      const Layout layout = LayoutOf(size);
+      __builtin_prefetch(this);
+      __builtin_prefetch(reinterpret_cast<const char *>(this) + layout.tags_);
+      __builtin_prefetch(reinterpret_cast<const char *>(this) + layout.keys_);
+    }
+
+    /** @brief Get the hash prefix the bucket covers. */
+    inline auto GetPrefix() const -> size_t { return prefix_; }
 
-    inline auto GetItems() -> std::list<std::pair<K, V>> & { return list_; }
+    /** @brief Whether a key with the given hash belongs in this bucket. A merged-away bucket covers nothing. */
+    inline auto Covers(size_t hash) const -> bool {
+      return !dead_.load(std::memory_order_relaxed) && (hash & ((size_t{1} << GetDepth()) - 1)) == prefix_;
+    }
+
+    /** @brief Copy out the entries of the bucket. */
+    auto GetItems() const -> std::vector<std::pair<K, V>>;
+
+    /** Acquire / release the bucket latch, shared for lookups and exclusive for updates. */
+    inline void RLatch() { latch_.lock_shared(); }
+    inline void RUnlatch() { latch_.unlock_shared(); }
+    inline void WLatch() { latch_.lock(); }
+    inline void WUnlatch() { latch_.unlock(); }
+    inline auto TryWLatch() -> bool { return latch_.try_lock(); }
 
     /**
      *
      * TODO(P1): Add implementation
      *
      * @brief Find the value associated with the given key in the bucket.
+     * @param hash The hash of key.
      * @param key The key to be searched.
      * @param[out] value The value associated with the key.
      * @return True if the key is found, false otherwise.
      */
-    auto Find(const K &key, V &value) -> bool;
+    auto Find(size_t hash, const K &key, V &value) -> bool;
+
+    /**
+     * @brief Find a key without latching the bucket. Always asks for a retry unless OPTIMISTIC_READS.
+     * @param hash the hash of key
+     * @param key The key to be searched.
+     * @param[out] value The value associated with the key, only set if Found.
+     * @return Retry if a writer changed the bucket during the read or the bucket no longer covers hash
+     */
+    auto OptimisticFind(size_t hash, const K &key, V &value) const -> ReadResult;
 
     /**
      *
      * TODO(P1): Add implementation
      *
      * @brief Given the key, remove the corresponding key-value pair in the bucket.
+     * @param hash The hash of key.
      * @param key The key to be deleted.
      * @return True if the key exists, false otherwise.
      */
-    auto Remove(const K &key) -> bool;
+    auto Remove(size_t hash, const K &key) -> bool;
 
     /**
      *
@@ -151,39 +340,208 @@ class ExtendibleHashTable : public HashTable<K, V> {
      * @brief Insert the given key-value pair into the bucket.
      *      1. If a key already exists, the value should be updated.
      *      2. If the bucket is full, do nothing and return false.
+     * @param hash The hash of key.
      * @param key The key to be inserted.
      * @param value The value to be inserted.
      * @return True if the key-value pair is inserted, false otherwise.
      */
-    auto Insert(const K &key, const V &value) -> bool;
+    auto Insert(size_t hash, const K &key, const V &value) -> bool;
+
+    /**
+     * @brief Increment the local depth and move the entries whose new hash bit is set into an empty sibling.
+     * Entries are moved between the preallocated arrays by their cached hashes, nothing is allocated or rehashed.
+     * The caller must hold this bucket's write latch.
+     * @param[out] sibling empty bucket of the same size, which takes the upper half of the split
+     */
+    void SplitInto(Bucket *sibling);
+
+    /**
+     * @brief Take over every entry of the buddy, decrement the local depth and mark the buddy dead. The caller must
+     * hold both write latches, this bucket must be the lower half (its top prefix bit clear), and the entries of both
+     * must fit.
+     * @param buddy bucket of the same depth whose prefix differs only in the top bit
+     */
+    void MergeFrom(Bucket *buddy);
 
    private:
+    /** Byte offsets of the arrays from the start of a bucket's allocation, and its total size. */
+    struct Layout {
+      size_t hashes_;
+      size_t keys_;
+      size_t values_;
+      size_t tags_;
+      size_t total_;
+    };
+
+    /** Tags are compared this many at a time, the tag array is padded to a multiple of it. */
+    static constexpr size_t TAG_GROUP = 16;
+
+    Bucket(size_t size, int depth, size_t prefix, char *memory, const Layout &layout);
+    ~Bucket() = default;
+
+    static auto LayoutOf(size_t size) -> Layout;
+
+    /** @brief The tag of a hash, its top byte. */
+    static inline auto TagOf(size_t hash) -> uint8_t { return static_cast<uint8_t>(hash >> (8 * sizeof(size_t) - 8)); }
+
+    /**
+     * @brief Return the index of key among the first count entries, or count if it is absent.
+     * Only for callers holding the latch, optimistic readers must go through LoadCell().
+     */
+    auto ProbeKey(size_t hash, const K &key, size_t count) const -> size_t;
+
+    /**
+     * Read / write one key or value. With OPTIMISTIC_READS these are relaxed atomic accesses, which is what makes
+     * racing with optimistic readers well defined, otherwise plain ones.
+     */
+    template <typename T>
+    static inline auto LoadCell(const T &cell) -> T {
+      if constexpr (OPTIMISTIC_READS) {
+        T value;
+        __atomic_load(&cell, &value, __ATOMIC_RELAXED);
+        return value;
+      } else {
+        return cell;
+      }
+    }
+
+    template <typename T>
+    static inline void StoreCell(T *cell, T value) {
+      if constexpr (OPTIMISTIC_READS) {
+        __atomic_store(cell, &value, __ATOMIC_RELAXED);
+      } else {
+        *cell = std::move(value);
+      }
+    }
+
+    /** @brief Put an entry into slot i. */
+    inline void StoreEntry(size_t i, size_t hash, const K &key, V value) {
+      hashes_[i] = hash;
+      StoreCell(&tags_[i], TagOf(hash));
+      StoreCell(&keys_[i], key);
+      StoreCell(&values_[i], std::move(value));
+    }
+
+    /** @brief Open / close a write section, during which optimistic readers retry. Needs the write latch. */
+    void BeginWrite();
+    void EndWrite();
+
     // TODO(student): You may add additional private members and helper functions
     size_t size_;
-    int depth_;
-    std::list<std::pair<K, V>> list_;
+    std::atomic<int> depth_;
+    size_t prefix_;
+    /** Number of slots in use, keys_[0, count_) and values_[0, count_) hold the entries. */
+    std::atomic<size_t> count_{0};
+    /** Seqlock version, odd while a writer is changing the bucket. */
+    std::atomic<uint64_t> version_{0};
+    /** Set once the bucket is merged into its buddy, it is unreachable from the directory from then on. */
+    std::atomic<bool> dead_{false};
+    /** The entry arrays, all inside this bucket's allocation. Hashes are only read under the latch. */
+    size_t *hashes_;
+    K *keys_;
+    V *values_;
+    uint8_t *tags_;
+    /** A std::shared_mutex rather than a ReaderWriterLatch, merging needs try_lock(). */
+    std::shared_mutex latch_;
   };
 
  private:
   // TODO(student): You may add additional private members and helper functions and remove the ones
   // you don't need.
 
-  int global_depth_;    // The global depth of the directory
-  size_t bucket_size_;  // The size of a bucket
-  int num_buckets_;     // The number of buckets in the hash table
-  mutable std::mutex latch_;
-  std::vector<std::shared_ptr<Bucket>> dir_;  // The directory of the hash table
+  /**
+   * A directory of 2^global_depth_ slots. Doubling replaces the whole directory and retires the old one, while
+   * splits update the slots of the current directory in place.
+   */
+  struct Directory {
+    explicit Directory(int global_depth) : global_depth_(global_depth), slots_(size_t{1} << global_depth) {}
+
+    inline auto SlotOf(size_t hash) const -> const std::atomic<Bucket *> & {
+      return slots_[hash & ((size_t{1} << global_depth_) - 1)];
+    }
+
+    const int global_depth_;
+    std::vector<std::atomic<Bucket *>> slots_;
+  };
+
+  /** Number of optimistic attempts Find() makes before it falls back to latching the bucket. */
+  static constexpr int OPTIMISTIC_RETRIES = 8;
+
+  /** FindBatch() prefetches the bucket this many keys ahead, and the directory slot twice as far. */
+  static constexpr size_t PREFETCH_DISTANCE = 8;
+
+  /** Reserve() sizes for buckets this full, about where extendible hashing settles (ln 2). */
+  static constexpr double RESERVE_FILL = 0.69;
 
-  // The following functions are completely optional, you can delete them if you have your own ideas.
+  /** Local depths range over [0, MAX_DEPTH]. */
+  static constexpr int MAX_DEPTH = 8 * sizeof(size_t);
+
+  size_t bucket_size_;                                        // The size of a bucket
+  size_t merge_threshold_;                                    // Buddies with at most this many entries are merged
+  std::atomic<int> num_buckets_;                              // The number of buckets in the hash table
+  mutable ReaderWriterLatch latch_;                           // Serializes resizing against splits and merges
+  std::atomic<Directory *> dir_;                              // The directory, read under an epoch guard
+  std::array<std::atomic<size_t>, MAX_DEPTH + 1> at_depth_;  // Number of buckets at each local depth, under latch_
+  mutable EpochManager epochs_;                               // Reclaims replaced directories and merged buckets
+  Hash hash_fn_;                                              // The hash function
+
+  /** The counters of one metric shard, summed up by GetStats(). */
+  struct StatsShard {
+    std::atomic<uint64_t> finds_{0};
+    std::atomic<uint64_t> find_hits_{0};
+    std::atomic<uint64_t> latched_finds_{0};
+    std::atomic<uint64_t> inserts_{0};
+    std::atomic<uint64_t> removes_{0};
+    std::atomic<uint64_t> splits_{0};
+    std::atomic<uint64_t> merges_{0};
+    std::atomic<uint64_t> directory_grows_{0};
+    std::atomic<uint64_t> directory_shrinks_{0};
+    std::atomic<uint64_t> latch_retries_{0};
+  };
+  mutable Sharded<StatsShard> stats_;
+
+  /** @brief Hash a key. */
+  auto HashOf(const K &key) const -> size_t { return hash_fn_(key); }
 
   /**
-   * @brief Redistribute the kv pairs in a full bucket.
-   * @param bucket The bucket to be redistributed.
+   * @brief Return the bucket covering the given hash, latched shared (exclusive if write is set).
+   * Must not be called with latch_ held. The caller must hold an epoch guard, pinned before the call and kept for as
+   * long as it holds the bucket: a thread never pins while holding a bucket latch, since the threads waiting for that
+   * latch may occupy every epoch slot.
    */
-  auto RedistributeBucket(std::shared_ptr<Bucket> bucket) -> void;
+  auto LatchBucket(size_t hash, bool write) -> Bucket *;
+
+  /**
+   * @brief Split a full bucket and point the directory entries of the upper half at the new sibling. The caller must
+   * hold the bucket's write latch, and not latch_.
+   * @param bucket The bucket to be split.
+   * @return false, leaving the bucket alone, if its local depth equals the global depth and the directory must grow
+   */
+  auto SplitBucket(Bucket *bucket) -> bool;
+
+  /**
+   * @brief Double the directory if its global depth is still depth. Must not be called with latch_ or any bucket
+   * latch held.
+   */
+  void GrowDirectory(int depth);
+
+  /**
+   * @brief Merge the bucket with its buddy while they fit under merge_threshold_, skipping buddies another thread has
+   * latched. The caller must hold the bucket's write latch and the epoch guard it latched the bucket under, and not
+   * latch_.
+   * @param bucket the bucket an entry was just removed from
+   * @return the surviving bucket, still write latched
+   */
+  auto MergeBucket(Bucket *bucket) -> Bucket *;
+
+  /**
+   * @brief Halve the directory while no bucket has a local depth equal to the global depth. Must not be called with
+   * latch_ or any bucket latch held.
+   */
+  void ShrinkDirectory();
 
   /*****************************************************************
-   * Must acquire latch_ first before calling the below functions. *
+   * Must hold an epoch guard before calling the below functions.  *
    *****************************************************************/
 
   /**
@@ -193,6 +551,9 @@ class ExtendibleHashTable : public HashTable<K, V> {
    */
   auto IndexOf(const K &key) -> size_t;
 
+  /** @brief Find() for a key whose hash is already known. The caller must hold an epoch guard. */
+  auto FindHashed(size_t hash, const K &key, V &value) -> bool;
+
   auto GetGlobalDepthInternal() const -> int;
   auto GetLocalDepthInternal(int dir_index) const -> int;
   auto GetNumBucketsInternal() const -> int;
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// direct_disk_manager.h
+//
+// Identification: src/include/storage/disk/direct_disk_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * DirectDiskManager reads and writes database pages with O_DIRECT, bypassing the kernel page cache. The buffer pool
+ * already caches pages, so going through the page cache as well keeps every hot page in memory twice and copies it
+ * once more on each I/O.
+ *
+ * Direct I/O needs buffers aligned to the device's block size. The frame data of a buffer pool is page aligned (see
+ * FrameMemory) and goes to the kernel as it is; other buffers that are not aligned go through an aligned per-thread
+ * buffer. File systems that do not support O_DIRECT, such as tmpfs, are used with buffered I/O instead, see
+ * IsDirect().
+ *
+ * Only the page I/O of DiskManager is overridden, logging is not supported.
+ */
+class DirectDiskManager : public DiskManager {
+ public:
+  /** Alignment of the buffers, file offsets and sizes of direct I/O. */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+  /**
+   * @brief Open or create the database file. Throws Exception if it cannot be opened.
+   * @param db_file the file name of the database file to write to
+   */
+  explicit DirectDiskManager(const std::string &db_file);
+
+  ~DirectDiskManager() override;
+
+  /**
+   * @brief Write a page to the database file.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /**
+   * @brief Read a page from the database file. A page past the end of the file reads as zeros.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /** @return whether the file is accessed with O_DIRECT */
+  auto IsDirect() const -> bool { return direct_; }
+
+ private:
+  static_assert(BUSTUB_PAGE_SIZE % DIRECT_IO_ALIGNMENT == 0, "pages must be whole direct I/O blocks");
+
+  /** @return an aligned buffer private to the calling thread, one page long */
+  static auto BounceBuffer() -> char *;
+
+  /** @return whether data can be handed to direct I/O as it is */
+  auto IsAligned(const char *data) const -> bool {
+    return !direct_ || reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0;
+  }
+
+  int fd_;
+  bool direct_{true};
+};
+
+}  // namespace bustub
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_bucket_page.h
+//
+// Identification: src/include/storage/page/hash_table_bucket_page.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * Bucket page of a DiskExtendibleHashTable, laid out directly over the data of a buffer pool page.
+ *
+ * Page format:
+ * -----------------------------------------------------
+ * | NumEntries (8) | Entry[0] | Entry[1] | ... | Free |
+ * -----------------------------------------------------
+ *
+ * Entries are kept dense at the front of the array, a removal moves the last entry into the hole, so probing only
+ * touches the entries in use. The caller holds the page latch: shared for Find(), exclusive for the others.
+ *
+ * @tparam K key type, must be trivially copyable
+ * @tparam V value type, must be trivially copyable
+ * @tparam KeyEqual key equality
+ */
+template <typename K, typename V, typename KeyEqual = std::equal_to<K>>
+class HashTableBucketPage {
+  static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+                "bucket entries are stored in page memory as raw bytes");
+
+ public:
+  struct Entry {
+    K key_;
+    V value_;
+  };
+
+  /** Number of entries that fit in a page. */
+  static constexpr uint32_t BUCKET_ARRAY_SIZE = (BUSTUB_PAGE_SIZE - sizeof(uint64_t)) / sizeof(Entry);
+
+  /** @brief Set up an empty bucket on a fresh page. */
+  void Init() { num_entries_ = 0; }
+
+  /**
+   * @brief Find the value associated with the given key.
+   * @return True if the key is found, false otherwise.
+   */
+  auto Find(const K &key, V *value, const KeyEqual &key_equal = KeyEqual()) const -> bool;
+
+  /**
+   * @brief Insert a key-value pair, updating the value if the key exists.
+   * @return False if the key is absent and the bucket is full.
+   */
+  auto Insert(const K &key, const V &value, const KeyEqual &key_equal = KeyEqual()) -> bool;
+
+  /**
+   * @brief Remove a key.
+   * @return True if the key existed.
+   */
+  auto Remove(const K &key, const KeyEqual &key_equal = KeyEqual()) -> bool;
+
+  /** @brief Append an entry whose key is known to be absent, for splits and merges. The bucket must not be full. */
+  void Append(const Entry &entry) { array_[num_entries_++] = entry; }
+
+  /** @brief Remove the entry at index i, moving the last entry into its place. */
+  void RemoveAt(uint32_t i) { array_[i] = array_[--num_entries_]; }
+
+  auto EntryAt(uint32_t i) const -> const Entry & { return array_[i]; }
+  auto NumEntries() const -> uint32_t { return static_cast<uint32_t>(num_entries_); }
+  auto IsFull() const -> bool { return num_entries_ == BUCKET_ARRAY_SIZE; }
+  auto IsEmpty() const -> bool { return num_entries_ == 0; }
+
+ private:
+  /** Index of key, or NumEntries() if it is absent. */
+  auto IndexOf(const K &key, const KeyEqual &key_equal) const -> uint32_t;
+
+  /** 64 bits wide so that the entries after it are aligned for any key and value type. */
+  uint64_t num_entries_;
+  Entry array_[BUCKET_ARRAY_SIZE];
+};
+
+}  // namespace bustub
@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory_page.h
+//
+// Identification: src/include/storage/page/hash_table_directory_page.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * Directory page of a DiskExtendibleHashTable, laid out directly over the data of a buffer pool page.
+ *
+ * Page format (sizes in bytes):
+ * ---------------------------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | GlobalDepth (4) | LocalDepths (512) | BucketPageIds (2048) | Free (1524)
+ * ---------------------------------------------------------------------------------------------
+ *
+ * The page records its own id, which lets a table reopened from a page id check that it was given a directory. Only
+ * the first 2^global_depth slots are meaningful.
+ */
+class HashTableDirectoryPage {
+ public:
+  /** Number of directory slots that fit in a page, so the global depth is at most MAX_DEPTH. */
+  static constexpr uint32_t DIRECTORY_ARRAY_SIZE = 512;
+  static constexpr uint32_t MAX_DEPTH = 9;
+
+  /** @brief Set up an empty directory of global depth 0 on a fresh page. */
+  void Init(page_id_t page_id);
+
+  auto GetPageId() const -> page_id_t { return page_id_; }
+  auto GetLSN() const -> lsn_t { return lsn_; }
+  void SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+  /** @brief Return the number of slots in use, 2^global_depth. */
+  auto Size() const -> uint32_t { return 1U << global_depth_; }
+
+  auto GetGlobalDepth() const -> uint32_t { return global_depth_; }
+
+  /** @brief Return the mask of the hash bits that index the directory. */
+  auto GetGlobalDepthMask() const -> uint32_t { return Size() - 1; }
+
+  /**
+   * @brief Double the directory. The new upper half mirrors the lower half, so every bucket keeps covering the same
+   * hashes. Must not be called at MAX_DEPTH.
+   */
+  void IncrGlobalDepth();
+
+  /** @brief Halve the directory. Only valid if CanShrink(). */
+  void DecrGlobalDepth();
+
+  /** @brief Whether every local depth is below the global depth, so the upper half of the slots is redundant. */
+  auto CanShrink() const -> bool;
+
+  auto GetBucketPageId(uint32_t bucket_idx) const -> page_id_t { return bucket_page_ids_[bucket_idx]; }
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id) { bucket_page_ids_[bucket_idx] = bucket_page_id; }
+
+  auto GetLocalDepth(uint32_t bucket_idx) const -> uint32_t { return local_depths_[bucket_idx]; }
+  void SetLocalDepth(uint32_t bucket_idx, uint32_t local_depth) {
+    local_depths_[bucket_idx] = static_cast<uint8_t>(local_depth);
+  }
+
+  /** @brief Return the mask of the hash bits the bucket at bucket_idx is selected by. */
+  auto GetLocalDepthMask(uint32_t bucket_idx) const -> uint32_t { return (1U << local_depths_[bucket_idx]) - 1; }
+
+  /**
+   * @brief Return the slot of the bucket's split image (its buddy), which differs from bucket_idx in the top bit of
+   * its local depth. Only valid for a local depth above 0.
+   */
+  auto GetSplitImageIndex(uint32_t bucket_idx) const -> uint32_t {
+    return bucket_idx ^ (1U << (local_depths_[bucket_idx] - 1));
+  }
+
+  /**
+   * @brief Check the invariants of the directory, assert on failure: every local depth is at most the global depth,
+   * each bucket page has a single local depth, and a bucket of local depth d fills exactly 2^(global - d) slots.
+   */
+  void VerifyIntegrity() const;
+
+ private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint32_t global_depth_;
+  uint8_t local_depths_[DIRECTORY_ARRAY_SIZE];
+  page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE];
+};
+
+static_assert(sizeof(HashTableDirectoryPage) <= BUSTUB_PAGE_SIZE, "the directory must fit in a page");
+
+}  // namespace bustub
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_header_page.h
+//
+// Identification: src/include/storage/page/hash_table_header_page.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * Header page of a DiskExtendibleHashTable, the root above its directory pages, laid out directly over the data of a
+ * buffer pool page.
+ *
+ * Page format (sizes in bytes):
+ * ----------------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | Magic (4) | MaxDepth (4) | DirectoryPageIds (2048) | Free
+ * ----------------------------------------------------------------------------------
+ *
+ * The top max_depth bits of a hash select one of 2^max_depth directory slots, the directory then indexes its buckets
+ * by the low bits of the hash. A slot is INVALID_PAGE_ID until the first key hashing to it is inserted. The header
+ * records its own id and a magic number, so a table reopened from a page id can check that it was given a header and
+ * not one of its directories, which also start with their own id.
+ */
+class HashTableHeaderPage {
+ public:
+  /** Number of directory slots that fit in a page, so the max depth is at most MAX_DEPTH. */
+  static constexpr uint32_t HEADER_ARRAY_SIZE = 512;
+  static constexpr uint32_t MAX_DEPTH = 9;
+
+  /** @brief Set up a header without directories on a fresh page. */
+  void Init(page_id_t page_id, uint32_t max_depth = MAX_DEPTH);
+
+  auto GetPageId() const -> page_id_t { return page_id_; }
+
+  /** @brief Whether this is the header page set up by Init(page_id). */
+  auto IsHeaderOf(page_id_t page_id) const -> bool { return page_id_ == page_id && magic_ == HEADER_MAGIC; }
+  auto GetLSN() const -> lsn_t { return lsn_; }
+  void SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+  auto GetMaxDepth() const -> uint32_t { return max_depth_; }
+
+  /** @brief Return the number of directory slots, 2^max_depth. */
+  auto MaxSize() const -> uint32_t { return 1U << max_depth_; }
+
+  /** @brief Return the directory slot a hash belongs to, given by its top max_depth bits. */
+  auto HashToDirectoryIndex(uint32_t hash) const -> uint32_t {
+    return max_depth_ == 0 ? 0 : static_cast<uint32_t>(hash >> (32 - max_depth_));
+  }
+
+  auto GetDirectoryPageId(uint32_t directory_idx) const -> page_id_t { return directory_page_ids_[directory_idx]; }
+  void SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id) {
+    directory_page_ids_[directory_idx] = directory_page_id;
+  }
+
+ private:
+  /** "HTHD", never a valid global depth, where a directory page keeps it. */
+  static constexpr uint32_t HEADER_MAGIC = 0x48544844;
+
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint32_t magic_;
+  uint32_t max_depth_;
+  page_id_t directory_page_ids_[HEADER_ARRAY_SIZE];
+};
+
+static_assert(sizeof(HashTableHeaderPage) <= BUSTUB_PAGE_SIZE, "the header must fit in a page");
+
+}  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page.h
+//
+// Identification: src/include/storage/page/page.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+#include "common/config.h"
+#include "common/rwlatch.h"
+
+namespace bustub {
+
+/**
+ * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
+ * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
+ * pin count, dirty flag, page id, etc.
+ */
+class Page {
+  // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
+  friend class BufferPoolManagerInstance;
+
+ public:
+  /**
+   * Constructor. Zeros out the page data.
+   * @param data the BUSTUB_PAGE_SIZE bytes holding the page data, owned by the caller and outliving the page
+   */
+  explicit Page(char *data) : data_(data) { ResetMemory(); }
+
+  /** Default destructor. */
+  ~Page() = default;
+
+  /** @return the actual data contained within this page */
+  inline auto GetData() -> char * { return data_; }
+
+  /** @return the page id of this page */
+  inline auto GetPageId() -> page_id_t { return page_id_; }
+
+  /**
+   * @return the pin count of this page. Page guards drop pins without the buffer pool latch, so the count is read
+   * atomically and may change right after.
+   */
+  inline auto GetPinCount() -> int { return pin_count_.load(std::memory_order_acquire); }
+
+  /** @return true if the page in memory has been modified from the page on disk, false otherwise */
+  inline auto IsDirty() -> bool { return is_dirty_; }
+
+  /** Acquire the page write latch. */
+  inline void WLatch() { rwlatch_.WLock(); }
+
+  /** Release the page write latch. */
+  inline void WUnlatch() { rwlatch_.WUnlock(); }
+
+  /** Acquire the page read latch. */
+  inline void RLatch() { rwlatch_.RLock(); }
+
+  /** Release the page read latch. */
+  inline void RUnlatch() { rwlatch_.RUnlock(); }
+
+  /** @return the page LSN. */
+  inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
+
+  /** Sets the page LSN. */
+  inline void SetLSN(lsn_t lsn) { memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t)); }
+
+ protected:
+  static_assert(sizeof(page_id_t) == 4);
+  static_assert(sizeof(lsn_t) == 4);
+
+  static constexpr size_t SIZE_PAGE_HEADER = 8;
+  static constexpr size_t OFFSET_PAGE_START = 0;
+  static constexpr size_t OFFSET_LSN = 4;
+
+ private:
+  /** Zeroes out the data that is held within the page. */
+  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
+
+  /**
+   * The actual data that is stored within a page. It lives outside the page, so that the buffer pool can keep the
+   * data of its frames in one array of whole, aligned pages (see FrameMemory) and the book-keeping in another.
+   */
+  char *data_;
+  /** The ID of this page. */
+  page_id_t page_id_ = INVALID_PAGE_ID;
+  /** The pin count of this page. Atomic because page guards drop pins without the buffer pool latch. */
+  std::atomic<int> pin_count_{0};
+  /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
+  bool is_dirty_ = false;
+  /** Page latch. */
+  ReaderWriterLatch rwlatch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManagerInstance;
+
+/**
+ * BasicPageGuard owns one pin of a buffer pool page and releases it when it goes out of scope, so callers no longer
+ * pair every fetch with an unpin by page id.
+ *
+ * The guard remembers the frame the page lives in, so releasing it touches only that frame: a pin that is not the
+ * last one is dropped with an atomic decrement, without the buffer pool latch or a page table lookup. The page is
+ * released dirty if it was accessed through GetDataMut() or AsMut().
+ */
+class BasicPageGuard {
+ public:
+  /** @brief An empty guard, see IsValid(). */
+  BasicPageGuard() = default;
+
+  /**
+   * @brief Take over a pin on page.
+   * @param bpm the buffer pool instance page is a frame of
+   * @param page a pinned page, nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManagerInstance *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  auto operator=(const BasicPageGuard &) -> BasicPageGuard & = delete;
+
+  /** @brief Take over the page of that, leaving it empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** @brief Release the page of this guard, then take over the page of that. */
+  auto operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard &;
+
+  ~BasicPageGuard() { Drop(); }
+
+  /** @brief Release the page now. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return false if the guard holds no page, e.g. because fetching it failed */
+  auto IsValid() const -> bool { return page_ != nullptr; }
+
+  auto PageId() -> page_id_t { return page_->GetPageId(); }
+
+  auto GetData() -> const char * { return page_->GetData(); }
+
+  template <class T>
+  auto As() -> const T * {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /** @return the data of the page for writing, the page is released dirty */
+  auto GetDataMut() -> char * {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  template <class T>
+  auto AsMut() -> T * {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+  friend class PageGuardBatch;
+
+  BufferPoolManagerInstance *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard is a BasicPageGuard that also holds the read latch of its page, and releases the latch before the
+ * pin.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /** @brief Take over a pin and the read latch of page, see BasicPageGuard(). */
+  ReadPageGuard(BufferPoolManagerInstance *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** @brief Release the latch and the page now. The guard is empty afterwards. */
+  void Drop();
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  auto PageId() -> page_id_t { return guard_.PageId(); }
+
+  auto GetData() -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() -> const T * {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class PageGuardBatch;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard is a BasicPageGuard that also holds the write latch of its page, and releases the latch before the
+ * pin.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /** @brief Take over a pin and the write latch of page, see BasicPageGuard(). */
+  WritePageGuard(BufferPoolManagerInstance *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** @brief Release the latch and the page now. The guard is empty afterwards. */
+  void Drop();
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  auto PageId() -> page_id_t { return guard_.PageId(); }
+
+  auto GetData() -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() -> const T * {
+    return guard_.As<T>();
+  }
+
+  /** @return the data of the page for writing, the page is released dirty */
+  auto GetDataMut() -> char * { return guard_.GetDataMut(); }
+
+  template <class T>
+  auto AsMut() -> T * {
+    return guard_.AsMut<T>();
+  }
+
+ private:
+  friend class PageGuardBatch;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * PageGuardBatch collects page guards and releases all of their pages in one call, for callers that hold many pages
+ * at once such as scans. Pins that need the buffer pool latch are released under a single acquisition of it per
+ * buffer pool instance, instead of one acquisition per page.
+ *
+ * The pages stay latched and pinned until Release() or the destruction of the batch.
+ */
+class PageGuardBatch {
+ public:
+  PageGuardBatch() = default;
+
+  PageGuardBatch(const PageGuardBatch &) = delete;
+  auto operator=(const PageGuardBatch &) -> PageGuardBatch & = delete;
+
+  ~PageGuardBatch() { Release(); }
+
+  /** @brief Take over the page of guard, which is left empty. Empty guards are ignored. */
+  void Add(BasicPageGuard &&guard);
+  void Add(ReadPageGuard &&guard);
+  void Add(WritePageGuard &&guard);
+
+  /** @brief Unlatch and release every page of the batch. The batch is empty afterwards. */
+  void Release();
+
+  /** @return number of pages held by the batch */
+  auto Size() const -> size_t { return entries_.size(); }
+
+ private:
+  enum class Latch { None, Read, Write };
+
+  struct Entry {
+    BufferPoolManagerInstance *bpm_;
+    Page *page_;
+    bool is_dirty_;
+    Latch latch_;
+  };
+
+  void Add(BasicPageGuard *guard, Latch latch);
+
+  std::vector<Entry> entries_;
+};
+
+}  // namespace bustub
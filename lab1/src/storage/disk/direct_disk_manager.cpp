@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// direct_disk_manager.cpp
+//
+// Identification: src/storage/disk/direct_disk_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/direct_disk_manager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>  // NOLINT
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+constexpr auto PAGE_SIZE = static_cast<size_t>(BUSTUB_PAGE_SIZE);
+}  // namespace
+
+DirectDiskManager::DirectDiskManager(const std::string &db_file) {
+  file_name_ = db_file;
+  fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+  if (fd_ < 0 && errno == EINVAL) {
+    direct_ = false;
+    fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (fd_ < 0) {
+    throw Exception(ExceptionType::INVALID, "cannot open db file " + db_file);
+  }
+}
+
+DirectDiskManager::~DirectDiskManager() { close(fd_); }
+
+auto DirectDiskManager::BounceBuffer() -> char * {
+  alignas(DIRECT_IO_ALIGNMENT) static thread_local char buffer[BUSTUB_PAGE_SIZE];
+  return buffer;
+}
+
+void DirectDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  const off_t offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
+  const char *data = page_data;
+  if (!IsAligned(page_data)) {
+    char *buffer = BounceBuffer();
+    memcpy(buffer, page_data, BUSTUB_PAGE_SIZE);
+    data = buffer;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(db_io_latch_);
+    num_writes_ += 1;
+  }
+  size_t written = 0;
+  while (written < PAGE_SIZE) {
+    const ssize_t n = pwrite(fd_, data + written, PAGE_SIZE - written, offset + static_cast<off_t>(written));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += static_cast<size_t>(n);
+  }
+}
+
+void DirectDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  const off_t offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
+  char *data = IsAligned(page_data) ? page_data : BounceBuffer();
+  size_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    const ssize_t n = pread(fd_, data + read_count, PAGE_SIZE - read_count, offset + static_cast<off_t>(read_count));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      LOG_DEBUG("I/O error while reading");
+      break;
+    }
+    if (n == 0) {
+      LOG_DEBUG("Read less than a page");
+      break;
+    }
+    read_count += static_cast<size_t>(n);
+  }
+  // Whatever lies past the end of the file reads as zeros.
+  memset(data + read_count, 0, PAGE_SIZE - read_count);
+  if (data != page_data) {
+    memcpy(page_data, data, BUSTUB_PAGE_SIZE);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_bucket_page.cpp
+//
+// Identification: src/storage/page/hash_table_bucket_page.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_bucket_page.h"
+
+namespace bustub {
+
+template <typename K, typename V, typename KeyEqual>
+auto HashTableBucketPage<K, V, KeyEqual>::IndexOf(const K &key, const KeyEqual &key_equal) const -> uint32_t {
+  const auto count = NumEntries();
+  for (uint32_t i = 0; i < count; i++) {
+    if (key_equal(array_[i].key_, key)) {
+      return i;
+    }
+  }
+  return count;
+}
+
+template <typename K, typename V, typename KeyEqual>
+auto HashTableBucketPage<K, V, KeyEqual>::Find(const K &key, V *value, const KeyEqual &key_equal) const -> bool {
+  const uint32_t i = IndexOf(key, key_equal);
+  if (i == NumEntries()) {
+    return false;
+  }
+  *value = array_[i].value_;
+  return true;
+}
+
+template <typename K, typename V, typename KeyEqual>
+auto HashTableBucketPage<K, V, KeyEqual>::Insert(const K &key, const V &value, const KeyEqual &key_equal) -> bool {
+  const uint32_t i = IndexOf(key, key_equal);
+  if (i != NumEntries()) {
+    array_[i].value_ = value;
+    return true;
+  }
+  if (IsFull()) {
+    return false;
+  }
+  Append(Entry{key, value});
+  return true;
+}
+
+template <typename K, typename V, typename KeyEqual>
+auto HashTableBucketPage<K, V, KeyEqual>::Remove(const K &key, const KeyEqual &key_equal) -> bool {
+  const uint32_t i = IndexOf(key, key_equal);
+  if (i == NumEntries()) {
+    return false;
+  }
+  RemoveAt(i);
+  return true;
+}
+
+template class HashTableBucketPage<int, int>;
+template class HashTableBucketPage<int64_t, int64_t>;
+
+}  // namespace bustub
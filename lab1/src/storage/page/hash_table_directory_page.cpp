@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory_page.cpp
+//
+// Identification: src/storage/page/hash_table_directory_page.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_directory_page.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+void HashTableDirectoryPage::Init(page_id_t page_id) {
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  global_depth_ = 0;
+  std::fill_n(local_depths_, DIRECTORY_ARRAY_SIZE, 0);
+  std::fill_n(bucket_page_ids_, DIRECTORY_ARRAY_SIZE, INVALID_PAGE_ID);
+}
+
+void HashTableDirectoryPage::IncrGlobalDepth() {
+  BUSTUB_ASSERT(global_depth_ < MAX_DEPTH, "the directory is full");
+  const uint32_t size = Size();
+  std::copy_n(local_depths_, size, local_depths_ + size);
+  std::copy_n(bucket_page_ids_, size, bucket_page_ids_ + size);
+  global_depth_++;
+}
+
+void HashTableDirectoryPage::DecrGlobalDepth() {
+  BUSTUB_ASSERT(CanShrink(), "a bucket still needs the global depth");
+  global_depth_--;
+}
+
+auto HashTableDirectoryPage::CanShrink() const -> bool {
+  if (global_depth_ == 0) {
+    return false;
+  }
+  return std::all_of(local_depths_, local_depths_ + Size(), [&](uint8_t depth) { return depth < global_depth_; });
+}
+
+void HashTableDirectoryPage::VerifyIntegrity() const {
+  std::unordered_map<page_id_t, uint32_t> slots;
+  std::unordered_map<page_id_t, uint32_t> depths;
+  for (uint32_t i = 0; i < Size(); i++) {
+    const page_id_t bucket_page_id = bucket_page_ids_[i];
+    BUSTUB_ASSERT(bucket_page_id != INVALID_PAGE_ID, "every slot must point at a bucket");
+    BUSTUB_ASSERT(local_depths_[i] <= global_depth_, "a local depth exceeds the global depth");
+    slots[bucket_page_id]++;
+    auto [it, inserted] = depths.emplace(bucket_page_id, local_depths_[i]);
+    BUSTUB_ASSERT(inserted || it->second == local_depths_[i], "a bucket has two local depths");
+  }
+  for (const auto &[bucket_page_id, count] : slots) {
+    BUSTUB_ASSERT(count == 1U << (global_depth_ - depths[bucket_page_id]), "a bucket fills the wrong number of slots");
+  }
+}
+
+}  // namespace bustub
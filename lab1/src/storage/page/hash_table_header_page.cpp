@@ -0,0 +1,30 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_header_page.cpp
+//
+// Identification: src/storage/page/hash_table_header_page.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_header_page.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+void HashTableHeaderPage::Init(page_id_t page_id, uint32_t max_depth) {
+  BUSTUB_ASSERT(max_depth <= MAX_DEPTH, "the header page holds at most 2^MAX_DEPTH directories");
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  magic_ = HEADER_MAGIC;
+  max_depth_ = max_depth;
+  std::fill_n(directory_page_ids_, HEADER_ARRAY_SIZE, INVALID_PAGE_ID);
+}
+
+}  // namespace bustub
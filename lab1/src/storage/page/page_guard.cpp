@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.cpp
+//
+// Identification: src/storage/page/page_guard.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/page_guard.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "buffer/buffer_pool_manager_instance.h"
+
+namespace bustub {
+
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(that.page_), is_dirty_(that.is_dirty_) {
+  that.bpm_ = nullptr;
+  that.page_ = nullptr;
+  that.is_dirty_ = false;
+}
+
+auto BasicPageGuard::operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard & {
+  if (this != &that) {
+    Drop();
+    std::swap(bpm_, that.bpm_);
+    std::swap(page_, that.page_);
+    std::swap(is_dirty_, that.is_dirty_);
+  }
+  return *this;
+}
+
+void BasicPageGuard::Drop() {
+  if (page_ == nullptr) {
+    return;
+  }
+  bpm_->ReleaseFrame(page_, is_dirty_);
+  bpm_ = nullptr;
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+auto ReadPageGuard::operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard & {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (guard_.page_ != nullptr) {
+    guard_.page_->RUnlatch();
+  }
+  guard_.Drop();
+}
+
+auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard & {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void WritePageGuard::Drop() {
+  if (guard_.page_ != nullptr) {
+    guard_.page_->WUnlatch();
+  }
+  guard_.Drop();
+}
+
+void PageGuardBatch::Add(BasicPageGuard &&guard) { Add(&guard, Latch::None); }
+
+void PageGuardBatch::Add(ReadPageGuard &&guard) { Add(&guard.guard_, Latch::Read); }
+
+void PageGuardBatch::Add(WritePageGuard &&guard) { Add(&guard.guard_, Latch::Write); }
+
+void PageGuardBatch::Add(BasicPageGuard *guard, Latch latch) {
+  if (guard->page_ == nullptr) {
+    return;
+  }
+  entries_.push_back({guard->bpm_, guard->page_, guard->is_dirty_, latch});
+  // The batch owns the pin and the latch now, the guard must not release them.
+  guard->bpm_ = nullptr;
+  guard->page_ = nullptr;
+  guard->is_dirty_ = false;
+}
+
+void PageGuardBatch::Release() {
+  if (entries_.empty()) {
+    return;
+  }
+  for (auto &entry : entries_) {
+    if (entry.latch_ == Latch::Read) {
+      entry.page_->RUnlatch();
+    } else if (entry.latch_ == Latch::Write) {
+      entry.page_->WUnlatch();
+    }
+  }
+
+  // Group the pages by instance, each instance then releases its pages in one call.
+  std::stable_sort(entries_.begin(), entries_.end(),
+                   [](const Entry &a, const Entry &b) { return std::less<>()(a.bpm_, b.bpm_); });
+  std::vector<std::pair<Page *, bool>> pages;
+  for (size_t begin = 0; begin < entries_.size();) {
+    BufferPoolManagerInstance *bpm = entries_[begin].bpm_;
+    pages.clear();
+    size_t end = begin;
+    for (; end < entries_.size() && entries_[end].bpm_ == bpm; end++) {
+      pages.emplace_back(entries_[end].page_, entries_[end].is_dirty_);
+    }
+    bpm->ReleaseFrames(pages);
+    begin = end;
+  }
+  entries_.clear();
+}
+
+}  // namespace bustub
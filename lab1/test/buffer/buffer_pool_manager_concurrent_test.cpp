@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager_concurrent_test.cpp
+//
+// Identification: test/buffer/buffer_pool_manager_concurrent_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr const char *DB_NAME = "bpm_concurrent_test.db";
+
+/** @return the frame holding page_id, nullptr if it is not resident */
+auto FrameOf(BufferPoolManagerInstance *bpm, page_id_t page_id) -> Page * {
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    if (bpm->GetPages()[i].GetPageId() == page_id) {
+      return &bpm->GetPages()[i];
+    }
+  }
+  return nullptr;
+}
+
+/** Page contents of the data integrity test: the page's own id and a counter of the writes to it. */
+struct TestPage {
+  page_id_t page_id_;
+  uint32_t writes_;
+};
+
+}  // namespace
+
+// Page guards drop their pins without the buffer pool latch. Dropping many of them at once must neither lose nor
+// double count a pin.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerConcurrentTest, GuardDropsKeepPinCount) {
+  constexpr int num_threads = 8;
+  constexpr int num_ops = 2000;
+  DiskManager disk_manager(DB_NAME);
+  BufferPoolManagerInstance bpm(10, &disk_manager, 2);
+  page_id_t page_id;
+  {
+    auto guard = bpm.NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    std::strcpy(guard.GetDataMut(), "pinned");  // NOLINT
+  }
+  Page *frame = FrameOf(&bpm, page_id);
+  ASSERT_NE(frame, nullptr);
+  ASSERT_EQ(frame->GetPinCount(), 0);
+
+  auto held = bpm.FetchPageRead(page_id);
+  const uint64_t unpins_before = bpm.GetStats().unpins_;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < num_threads; thread++) {
+    threads.emplace_back([&bpm, page_id, thread] {
+      for (int i = 0; i < num_ops; i++) {
+        if ((i + thread) % 3 == 0) {
+          auto guard = bpm.FetchPageBasic(page_id);
+          ASSERT_TRUE(guard.IsValid());
+          guard.Drop();
+        } else if ((i + thread) % 3 == 1) {
+          auto guard = bpm.FetchPageRead(page_id);
+          ASSERT_TRUE(guard.IsValid());
+          EXPECT_STREQ(guard.GetData(), "pinned");
+        } else {
+          // Moving a guard hands its pin over, only the last owner drops it.
+          ReadPageGuard guard;
+          guard = bpm.FetchPageRead(page_id);
+          ReadPageGuard moved(std::move(guard));
+          EXPECT_FALSE(guard.IsValid());  // NOLINT
+          EXPECT_TRUE(moved.IsValid());
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(frame->GetPinCount(), 1);
+  EXPECT_EQ(bpm.GetStats().unpins_ - unpins_before, static_cast<uint64_t>(num_threads * num_ops));
+  EXPECT_FALSE(bpm.DeletePage(page_id));
+  held.Drop();
+  EXPECT_EQ(frame->GetPinCount(), 0);
+  EXPECT_TRUE(bpm.DeletePage(page_id));
+
+  disk_manager.ShutDown();
+  remove(DB_NAME);
+}
+
+// A page is dirty once any of the pins dropped on it was dirty, however the unpins interleave, and clean again
+// once flushed.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerConcurrentTest, DirtyFlagSurvivesConcurrentUnpins) {
+  constexpr int num_threads = 4;
+  constexpr int num_ops = 2000;
+  DiskManager disk_manager(DB_NAME);
+  BufferPoolManagerInstance bpm(10, &disk_manager, 2);
+  page_id_t page_id;
+  ASSERT_NE(bpm.NewPage(&page_id), nullptr);
+  ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+  ASSERT_TRUE(bpm.FlushPage(page_id));
+  Page *frame = FrameOf(&bpm, page_id);
+  ASSERT_NE(frame, nullptr);
+
+  for (bool write : {false, true}) {
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; thread++) {
+      threads.emplace_back([&bpm, page_id, thread, write] {
+        for (int i = 0; i < num_ops; i++) {
+          const bool dirty = write && thread == 0 && i == num_ops / 2;
+          if (i % 2 == 0) {
+            ASSERT_NE(bpm.FetchPage(page_id), nullptr);
+            EXPECT_TRUE(bpm.UnpinPage(page_id, dirty));
+          } else if (dirty) {
+            auto guard = bpm.FetchPageWrite(page_id);
+            guard.GetDataMut()[0] = 'x';
+          } else {
+            auto guard = bpm.FetchPageRead(page_id);
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(frame->GetPinCount(), 0);
+    EXPECT_EQ(frame->IsDirty(), write);
+  }
+  ASSERT_TRUE(bpm.FlushPage(page_id));
+  EXPECT_FALSE(frame->IsDirty());
+
+  disk_manager.ShutDown();
+  remove(DB_NAME);
+}
+
+// Misses read and evictions write pages without the buffer pool latch. With many more pages than frames, every page
+// must still read back its own contents and every write, under each replacement policy.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerConcurrentTest, ConcurrentMissesPreserveData) {
+  constexpr size_t pool_size = 8;
+  constexpr int num_pages = 64;
+  constexpr int num_threads = 4;
+  constexpr int num_ops = 4000;
+  for (auto replacer_type : {ReplacerType::LRUK, ReplacerType::Clock, ReplacerType::TwoQueue, ReplacerType::ARC}) {
+    DiskManager disk_manager(DB_NAME);
+    BufferPoolManagerInstance bpm(pool_size, &disk_manager, 2, nullptr, replacer_type);
+    std::vector<page_id_t> page_ids;
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      auto guard = bpm.NewPageGuarded(&page_id);
+      ASSERT_TRUE(guard.IsValid());
+      *guard.AsMut<TestPage>() = {page_id, 0};
+      page_ids.push_back(page_id);
+    }
+
+    std::vector<std::vector<uint32_t>> writes(num_threads, std::vector<uint32_t>(num_pages, 0));
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; thread++) {
+      threads.emplace_back([&bpm, &page_ids, &writes, thread] {
+        std::mt19937 rng(thread);
+        for (int i = 0; i < num_ops; i++) {
+          const size_t index = rng() % page_ids.size();
+          if (rng() % 4 == 0) {
+            auto guard = bpm.FetchPageWrite(page_ids[index]);
+            ASSERT_TRUE(guard.IsValid());
+            EXPECT_EQ(guard.As<TestPage>()->page_id_, page_ids[index]);
+            guard.AsMut<TestPage>()->writes_++;
+            writes[thread][index]++;
+          } else {
+            auto guard = bpm.FetchPageRead(page_ids[index]);
+            ASSERT_TRUE(guard.IsValid());
+            EXPECT_EQ(guard.As<TestPage>()->page_id_, page_ids[index]);
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    for (size_t index = 0; index < page_ids.size(); index++) {
+      uint32_t expected = 0;
+      for (const auto &thread_writes : writes) {
+        expected += thread_writes[index];
+      }
+      auto guard = bpm.FetchPageRead(page_ids[index]);
+      ASSERT_TRUE(guard.IsValid());
+      EXPECT_EQ(guard.As<TestPage>()->page_id_, page_ids[index]);
+      EXPECT_EQ(guard.As<TestPage>()->writes_, expected);
+    }
+    for (size_t i = 0; i < pool_size; i++) {
+      EXPECT_LE(bpm.GetPages()[i].GetPinCount(), 1);
+    }
+
+    disk_manager.ShutDown();
+    remove(DB_NAME);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,229 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_concurrent_test.cpp
+//
+// Identification: test/container/extendible_hash_table_concurrent_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "container/hash/extendible_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return a value that names its key, so a reader can tell a value torn between two writes from a current one */
+auto ValueOf(int key, int version) -> int { return key * 16 + version % 16; }
+
+/** @brief Check that every local depth is at most the global depth and that buddies agree on their depth. */
+template <typename K, typename V>
+void ExpectConsistentDirectory(const ExtendibleHashTable<K, V> &table) {
+  const int global_depth = table.GetGlobalDepth();
+  for (int i = 0; i < (1 << global_depth); i++) {
+    const int local_depth = table.GetLocalDepth(i);
+    ASSERT_LE(local_depth, global_depth);
+    EXPECT_EQ(table.GetLocalDepth(i & ((1 << local_depth) - 1)), local_depth);
+  }
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableConcurrentTest, MatchesMapModel) {
+  ExtendibleHashTable<int, int> table(4);
+  std::unordered_map<int, int> model;
+  std::mt19937 rng(1);
+  // Insert-heavy rounds split buckets and grow the directory, remove-heavy rounds merge them and shrink it again.
+  for (int round = 0; round < 6; round++) {
+    const unsigned insert_share = round % 2 == 0 ? 3 : 1;
+    for (int i = 0; i < 5000; i++) {
+      const int key = static_cast<int>(rng() % 2000);
+      if (rng() % 4 < insert_share) {
+        const int value = static_cast<int>(rng());
+        table.Insert(key, value);
+        model[key] = value;
+      } else {
+        EXPECT_EQ(table.Remove(key), model.erase(key) == 1);
+      }
+    }
+    ExpectConsistentDirectory(table);
+    for (int key = 0; key < 2000; key++) {
+      int value;
+      const auto it = model.find(key);
+      ASSERT_EQ(table.Find(key, value), it != model.end()) << "key " << key;
+      if (it != model.end()) {
+        EXPECT_EQ(value, it->second);
+      }
+    }
+  }
+  const auto stats = table.GetStats();
+  EXPECT_GT(stats.splits_, 0);
+  EXPECT_GT(stats.merges_, 0);
+
+  // The batch operations agree with the single ones.
+  std::vector<std::pair<int, int>> entries;
+  for (int i = 0; i < 3000; i++) {
+    entries.emplace_back(static_cast<int>(rng() % 4000), i);
+    model[entries.back().first] = i;
+  }
+  table.InsertBatch(entries);
+  std::vector<int> keys;
+  for (int key = 0; key < 4000; key++) {
+    keys.push_back(key);
+  }
+  std::vector<int> values;
+  std::vector<bool> found;
+  EXPECT_EQ(table.FindBatch(keys, &values, &found), model.size());
+  for (int key = 0; key < 4000; key++) {
+    const auto it = model.find(key);
+    ASSERT_EQ(found[key], it != model.end()) << "key " << key;
+    if (it != model.end()) {
+      EXPECT_EQ(values[key], it->second);
+    }
+  }
+
+  // Removing everything merges the table back down.
+  for (const auto &[key, value] : model) {
+    EXPECT_TRUE(table.Remove(key));
+  }
+  ExpectConsistentDirectory(table);
+  int value;
+  EXPECT_FALSE(table.Find(entries.front().first, value));
+  EXPECT_LT(table.GetNumBuckets(), stats.num_buckets_);
+}
+
+// Writers split and merge buckets under readers that find keys without the bucket latch. Every key that stays in the
+// table must be found under any interleaving, and no reader may see a value written for another key.
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableConcurrentTest, DisjointWritersAndOptimisticReaders) {
+  constexpr int num_writers = 4;
+  constexpr int num_readers = 4;
+  constexpr int num_stable = 1000;
+  constexpr int keys_per_writer = 2000;
+  ExtendibleHashTable<int, int> table(4);
+  for (int key = 0; key < num_stable; key++) {
+    table.Insert(key, ValueOf(key, 0));
+  }
+
+  std::atomic<int> writers_left{num_writers};
+  std::vector<std::thread> threads;
+  for (int writer = 0; writer < num_writers; writer++) {
+    threads.emplace_back([&table, &writers_left, writer] {
+      // Every writer owns a range of keys, so it knows exactly what it should find there.
+      const int first = num_stable + writer * keys_per_writer;
+      std::unordered_map<int, int> mine;
+      std::mt19937 rng(writer);
+      for (int round = 0; round < 4; round++) {
+        // Fill the range and empty it again, splitting and merging the buckets it shares with the stable keys.
+        for (int i = 0; i < keys_per_writer; i++) {
+          const int key = first + static_cast<int>(rng() % keys_per_writer);
+          const int value = ValueOf(key, round * keys_per_writer + i);
+          table.Insert(key, value);
+          mine[key] = value;
+        }
+        for (int i = 0; i < keys_per_writer; i++) {
+          const int key = first + i;
+          int value;
+          const auto it = mine.find(key);
+          ASSERT_EQ(table.Find(key, value), it != mine.end()) << "key " << key;
+          if (it != mine.end()) {
+            EXPECT_EQ(value, it->second);
+          }
+        }
+        for (auto it = mine.begin(); it != mine.end();) {
+          EXPECT_TRUE(table.Remove(it->first));
+          it = mine.erase(it);
+        }
+      }
+      writers_left--;
+    });
+  }
+  for (int reader = 0; reader < num_readers; reader++) {
+    threads.emplace_back([&table, &writers_left, reader] {
+      std::mt19937 rng(100 + reader);
+      std::vector<int> keys(16);
+      std::vector<int> values;
+      std::vector<bool> found;
+      while (writers_left.load() > 0) {
+        for (auto &key : keys) {
+          key = static_cast<int>(rng() % (num_stable + num_writers * keys_per_writer));
+        }
+        if (reader % 2 == 0) {
+          values.assign(keys.size(), 0);
+          found.assign(keys.size(), false);
+          for (size_t i = 0; i < keys.size(); i++) {
+            found[i] = table.Find(keys[i], values[i]);
+          }
+        } else {
+          table.FindBatch(keys, &values, &found);
+        }
+        for (size_t i = 0; i < keys.size(); i++) {
+          if (keys[i] < num_stable) {
+            ASSERT_TRUE(found[i]) << "stable key " << keys[i];
+            EXPECT_EQ(values[i], ValueOf(keys[i], 0));
+          } else if (found[i]) {
+            EXPECT_EQ(values[i] / 16, keys[i]);
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  ExpectConsistentDirectory(table);
+  for (int key = 0; key < num_stable + num_writers * keys_per_writer; key++) {
+    int value;
+    ASSERT_EQ(table.Find(key, value), key < num_stable) << "key " << key;
+  }
+  EXPECT_GT(table.GetStats().merges_, 0);
+}
+
+// Values that are not trivially copyable are always read under the bucket latch.
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableConcurrentTest, LatchedReadersOfStrings) {
+  constexpr int num_threads = 4;
+  constexpr int num_keys = 500;
+  ExtendibleHashTable<int, std::string> table(4);
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < num_threads; thread++) {
+    threads.emplace_back([&table, thread] {
+      std::mt19937 rng(thread);
+      for (int i = 0; i < 20000; i++) {
+        const int key = static_cast<int>(rng() % num_keys);
+        if (rng() % 2 == 0) {
+          // Writers to the same key store the same string, only its length varies with the writer.
+          table.Insert(key, std::string(10 + thread * 10, static_cast<char>('a' + key % 26)));
+        } else if (rng() % 4 == 0) {
+          table.Remove(key);
+        } else {
+          std::string value;
+          if (table.Find(key, value)) {
+            EXPECT_EQ(value.size() % 10, 0);
+            EXPECT_EQ(value, std::string(value.size(), static_cast<char>('a' + key % 26)));
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ExpectConsistentDirectory(table);
+}
+
+}  // namespace bustub